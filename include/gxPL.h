@@ -10,12 +10,19 @@
 #define _GXPL_HEADER_
 
 #include <gxPL/defs.h>
+#include <gxPL/alloc.h>
 #include <gxPL/message.h>
 #include <gxPL/util.h>
 #include <gxPL/device.h>
 #ifndef  __AVR__
 #include <gxPL/hub.h>
 #include <gxPL/bridge.h>
+#include <gxPL/reactor.h>
+#include <gxPL/worker.h>
+#include <gxPL/sendqueue.h>
+#include <gxPL/request.h>
+#include <gxPL/directory.h>
+#include <gxPL/statecache.h>
 #endif
 
 __BEGIN_C_DECLS
@@ -70,6 +77,17 @@ gxPLSetting * gxPLSettingFromCommandArgs (int argc, char * argv[], gxPLConnectTy
  * gxPLApplication is the central element of a xPL application.
  * This class performs all operations to open and close the xPL network,
  * send and receive messages. An application is needed to create devices.
+ *
+ * An application, its devices and its messages keep all their state, they
+ * are not locked: each application must be used by one thread at a time, but
+ * several applications can be polled in parallel by different threads. The
+ * state shared by all the applications (interned strings, heap and pool
+ * allocators) is locked when the library is built with CONFIG_THREAD_SAFE. \n
+ * The functions that return a static string (gxPLLongToStr(),
+ * gxPLDateTimeStr(), gxPLDeviceFilterToString()...) are not reentrant, each
+ * of them has a variant that writes in a buffer provided by the caller.
+ * gxPLIoLocalAddrGet() and gxPLIoBcastAddrGet() return a buffer of the
+ * application.
  * @{
  */
 
@@ -101,11 +119,64 @@ int gxPLAppClose (gxPLApplication * app);
 /**
  * @brief Polling event of an application
  * @param app pointer to a gxPLApplication object
- * @param timeout_ms waiting period in ms before output if no event occurs
+ * @param timeout_ms waiting period in ms before output if no event occurs,
+ * a negative value waits until a datagram is received or a timer of the
+ * application (heartbeats...) expires
  * @return 0, -1 if an error occurs
  */
 int gxPLAppPoll (gxPLApplication * app, int timeout_ms);
 
+/**
+ * @brief Polling event of an application with a processing budget
+ *
+ * Waits at most timeout_ms for a datagram, then processes the datagrams
+ * already received without waiting, until there are none left or budget
+ * datagrams have been processed. The wait ends earlier if a timer of the
+ * application (heartbeats...) expires. The expired timers are run before
+ * returning, so a busy network can not delay them.
+ * gxPLAppPoll() is equivalent to this function with a default budget.
+ * @param app pointer to a gxPLApplication object
+ * @param timeout_ms waiting period in ms before output if no event occurs,
+ * a negative value waits for a datagram or the next timer
+ * @param budget maximum number of datagrams processed by this call
+ * @return number of datagrams processed, -1 if an error occurs
+ */
+int gxPLAppPollBudget (gxPLApplication * app, int timeout_ms, int budget);
+
+/**
+ * @brief File descriptor to wait for the datagrams of an application
+ *
+ * Allows to run an application in an external event loop (select, poll,
+ * epoll, libuv, glib...) instead of gxPLAppPoll(): the loop waits for this
+ * descriptor to be readable, for at most gxPLAppNextDeadlineMs(), then calls
+ * gxPLAppProcessReady(). If the send queue of the application is opened,
+ * gxPLAppSendQueueFd() must be waited for too.
+ * @param app pointer to a gxPLApplication object
+ * @return the descriptor, -1 if an error occurs (errno is set to EINVAL if the
+ * io layer does not provide one)
+ */
+int gxPLAppFd (gxPLApplication * app);
+
+/**
+ * @brief Maximum waiting time of an external event loop
+ * @param app pointer to a gxPLApplication object
+ * @return time before the next timer of the application expires in ms, 0 if
+ * datagrams already received are waiting to be processed, -1 if there is no
+ * timer (waits for the descriptor only)
+ */
+long gxPLAppNextDeadlineMs (gxPLApplication * app);
+
+/**
+ * @brief Processes the events of an application without waiting
+ *
+ * Called by an external event loop when the descriptor of the application is
+ * readable or when the deadline is reached. The datagrams already received
+ * are processed, within the default budget, then the expired timers are run.
+ * @param app pointer to a gxPLApplication object
+ * @return number of datagrams processed, -1 if an error occurs
+ */
+int gxPLAppProcessReady (gxPLApplication * app);
+
 /**
  * @brief Connection type
  *
@@ -122,6 +193,27 @@ gxPLConnectType gxPLAppConnectionType (const gxPLApplication * app);
  */
 gxPLSetting * gxPLAppSetting (gxPLApplication * app);
 
+/**
+ * @brief Sets the allocator of the application
+ *
+ * The messages created by the devices of the application and the datagrams
+ * received are allocated by this allocator, which must remain valid as long
+ * as the messages it allocated. The messages already allocated are released
+ * by their allocator.
+ * @param app pointer to a gxPLApplication object
+ * @param allocator pointer to the allocator, the heap allocator if NULL
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppAllocatorSet (gxPLApplication * app, gxPLAllocator * allocator);
+
+/**
+ * @brief Returns the allocator of the application
+ *
+ * @param app pointer to a gxPLApplication object
+ * @return the allocator, gxPLAllocatorHeap() if none has been set
+ */
+gxPLAllocator * gxPLAppAllocator (const gxPLApplication * app);
+
 /**
  * @}
  */
@@ -206,8 +298,19 @@ gxPLDevice * gxPLAppDeviceAt (gxPLApplication * app, int index);
  */
 int gxPLAppDeviceIndex (gxPLApplication * app, const gxPLDevice * device);
 
+/**
+ * @brief Finds a device from its identifier
+ *
+ * @param app pointer to a gxPLApplication object
+ * @param id identifier of the device
+ * @return the device, NULL if not found
+ */
+gxPLDevice * gxPLAppDeviceFind (gxPLApplication * app, const gxPLId * id);
+
 /**
  * @brief Removes a device
+ *
+ * The last device of the application takes the index of the removed device.
  * @param app pointer to a gxPLApplication object
  * @param device pointer on the device
  * @return 0, -1 if an error occurs
@@ -354,7 +457,8 @@ xVector * gxPLIoLayerList (void);
  * @brief Local network address as a string
  *
  * @param app pointer to a gxPLApplication object
- * @return network address as a string, NULL if an error occurs
+ * @return network address as a string, stored in the application until the
+ * next call, NULL if an error occurs
  */
 const char * gxPLIoLocalAddrGet (const gxPLApplication * app);
 
@@ -370,7 +474,8 @@ const xVector * gxPLIoLocalAddrList (const gxPLApplication * app);
  * @brief Broadcast network address as a string
  *
  * @param app pointer to a gxPLApplication object
- * @return the address as a string, NULL if an error occurs
+ * @return the address as a string, stored in the application until the
+ * next call, NULL if an error occurs
  */
 const char * gxPLIoBcastAddrGet (const gxPLApplication * app);
 
@@ -420,7 +525,8 @@ const char * gxPLIoLayerGet (const gxPLApplication * app);
  * 
  * -  \b gxPLIoFuncNetAddrToString
  *    \code int gxPLIoCtl (gxPLApplication * app, gxPLIoFuncNetAddrToString, gxPLIoAddr * net_addr, char ** str_addr)
- *    converts a network address in a gxPLIoAddr to a dots-and-numbers format string
+ *    converts a network address in a gxPLIoAddr to a dots-and-numbers format string,
+ *    stored in the io layer until the next call
  * 
  * -  \b gxPLIoFuncNetAddrFromString
  *    \code int gxPLIoCtl (gxPLIo * io, gxPLIoFuncNetAddrFromString, gxPLIoAddr * net_addr, const char * str_addr)
@@ -429,6 +535,17 @@ const char * gxPLIoLayerGet (const gxPLApplication * app);
  * -  \b gxPLIoFuncGetLocalAddrList
  *    \code int gxPLIoCtl (gxPLIo * io, gxPLIoFuncGetLocalAddrList, const xVector ** addr_list)
  *    returns binded adresses list
+ * 
+ * -  \b gxPLIoFuncGetFd
+ *    \code int gxPLIoCtl (gxPLApplication * app, gxPLIoFuncGetFd, int * fd)
+ *    returns the file descriptor to wait for incoming messages (-1 and errno
+ *    set to EINVAL if the io layer does not provide one)
+ *
+ * -  \b gxPLIoFuncSetWakeFd
+ *    \code int gxPLIoCtl (gxPLApplication * app, gxPLIoFuncSetWakeFd, int fd)
+ *    gxPLIoFuncPoll also returns, without available bytes, when fd is
+ *    readable; -1 removes it (-1 and errno set to EINVAL if the io layer
+ *    does not support it)
  * .
  *
  * @param app pointer to a gxPLApplication object
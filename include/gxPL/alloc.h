@@ -0,0 +1,119 @@
+/**
+ * @file
+ * Memory allocators
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_ALLOC_HEADER_
+#define _GXPL_ALLOC_HEADER_
+
+#include <stddef.h>
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/**
+ * @defgroup gxPLAllocatorDoc Allocators
+ * An allocator provides the memory of the messages, of their body and of the
+ * receive buffers of an application (gxPLAppAllocatorSet()). \n
+ * The library comes with a heap allocator, used by default, and a pool
+ * allocator that recycles the blocks released in size classes, so that a
+ * long running application no longer allocates memory once its pools are
+ * warmed. Other allocators can be provided by the user by filling a
+ * gxPLAllocator structure. \n
+ * The counters of the allocator are updated on each allocation and release,
+ * they measure the memory used by each application. \n
+ * The heap and pool allocators can be shared by applications that run in
+ * different threads (CONFIG_THREAD_SAFE), a user allocator must be
+ * reentrant if it is shared.
+ * @{
+ */
+
+/* structures =============================================================== */
+/**
+ * @brief Memory allocator
+ */
+struct _gxPLAllocator {
+  /** allocates size bytes, returns NULL if an error occurs */
+  void * (*alloc) (gxPLAllocator * allocator, size_t size);
+  /** releases a block of size bytes returned by alloc */
+  void (*free) (gxPLAllocator * allocator, void * ptr, size_t size);
+  void * udata;   /**< user data of the allocator */
+  long live;      /**< number of blocks allocated and not yet released */
+  long bytes;     /**< number of bytes allocated and not yet released */
+};
+
+/* internal public functions ================================================ */
+
+/**
+ * @brief Heap allocator, used by default
+ *
+ * The blocks are allocated with malloc(), the allocator is shared by all the
+ * applications that use it.
+ * @return the allocator, never NULL
+ */
+gxPLAllocator * gxPLAllocatorHeap (void);
+
+/**
+ * @brief Creates a new pool allocator
+ *
+ * The blocks are taken in size classes from slabs allocated on the heap,
+ * the blocks released are kept in the pool for the next allocations. The
+ * blocks larger than the largest class are allocated on the heap.
+ * @return the allocator, NULL if an error occurs
+ */
+gxPLAllocator * gxPLAllocatorPoolNew (void);
+
+/**
+ * @brief Releases a pool allocator and all its slabs
+ * @param allocator pointer to an allocator returned by gxPLAllocatorPoolNew()
+ * @return 0, -1 if an error occurs (errno is set to EBUSY if blocks are still
+ * allocated)
+ */
+int gxPLAllocatorPoolDelete (gxPLAllocator * allocator);
+
+/**
+ * @brief Allocates a block
+ * @param allocator pointer to an allocator, the heap allocator if NULL
+ * @param size number of bytes
+ * @return the block, NULL if an error occurs
+ */
+void * gxPLAllocatorAlloc (gxPLAllocator * allocator, size_t size);
+
+/**
+ * @brief Changes the size of a block
+ * @param allocator pointer to the allocator of the block, the heap allocator if NULL
+ * @param ptr block to change, a new block is allocated if NULL
+ * @param size new number of bytes
+ * @return the block, NULL if an error occurs (ptr is left unchanged)
+ */
+void * gxPLAllocatorRealloc (gxPLAllocator * allocator, void * ptr, size_t size);
+
+/**
+ * @brief Releases a block
+ * @param allocator pointer to the allocator of the block, the heap allocator if NULL
+ * @param ptr block to release, nothing is done if NULL
+ */
+void gxPLAllocatorFree (gxPLAllocator * allocator, void * ptr);
+
+/**
+ * @brief Number of blocks allocated and not yet released
+ * @param allocator pointer to an allocator, the heap allocator if NULL
+ */
+long gxPLAllocatorLiveCount (const gxPLAllocator * allocator);
+
+/**
+ * @brief Number of bytes allocated and not yet released
+ * @param allocator pointer to an allocator, the heap allocator if NULL
+ */
+long gxPLAllocatorLiveBytes (const gxPLAllocator * allocator);
+
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_ALLOC_HEADER_ defined */
@@ -90,7 +90,8 @@ int gxPLBridgeClose (gxPLBridge * bridge);
 /**
  * @brief Polling event of a bridge
  * @param bridge pointer to a gxPLBridge object
- * @param timeout_ms waiting period in ms before output if no event occurs
+ * @param timeout_ms waiting period in ms before output if no event occurs,
+ * a negative value waits for an event or the next timer
  * @return 0, -1 if an error occurs
  */
 int gxPLBridgePoll (gxPLBridge * bridge, int timeout_ms);
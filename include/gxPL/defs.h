@@ -52,6 +52,8 @@ typedef struct _gxPLDevice gxPLDevice;
 typedef struct _gxPLDeviceConfig gxPLDeviceConfig;
 typedef struct _gxPLHub gxPLHub;
 typedef struct _gxPLBridge gxPLBridge;
+typedef struct _gxPLReactor gxPLReactor;
+typedef struct _gxPLAllocator gxPLAllocator;
 
 #ifndef EINVAL
 #define EINVAL          22      /* Invalid argument */
@@ -100,6 +102,16 @@ typedef struct _gxPLBridge gxPLBridge;
  */
 #define GXPL_NAME_MAX       16
 
+/**
+ * @brief Size of a buffer that holds a filter as a string, null included
+ */
+#define GXPL_FILTER_STR_MAX 62
+
+/**
+ * @brief Size of a buffer that holds a network address as a string, null included
+ */
+#define GXPL_NETADDR_STR_MAX 48
+
 /**
  * @brief Maximum number of hop count
  */
@@ -154,6 +166,8 @@ typedef enum {
   gxPLIoFuncGetLocalAddrList,
   gxPLIoFuncNetAddrToString,
   gxPLIoFuncNetAddrFromString,
+  gxPLIoFuncGetFd,
+  gxPLIoFuncSetWakeFd,
   gxPLIoFuncError = -1
 } gxPLIoFunc;
 
@@ -248,6 +262,7 @@ typedef struct _gxPLSetting {
       uint16_t nodaemon: 1;   /**< do not daemonize */
       uint16_t iosflag: 1;    /**< true if io setting was configured */
       uint16_t broadcast: 1;  /**< all broadcasts messages will be rebroadcasted by the bridge */
+      uint16_t forward: 1;    /**< the hub relays the datagrams without decoding them */
     };
   };
   unsigned iotimeout; /**< timeout at the opening of the io layer */
@@ -273,6 +288,14 @@ typedef struct _gxPLIoAddr {
   };
 } gxPLIoAddr;
 
+/**
+ * @brief Fragment of a message sent by gxPLIoSendv()
+ */
+typedef struct _gxPLIoVec {
+  const void * base; /**< first byte of the fragment */
+  int len;           /**< number of bytes */
+} gxPLIoVec;
+
 /**
  * @brief Describe a source or destination xPL identifier
  */
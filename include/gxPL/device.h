@@ -174,9 +174,9 @@ int gxPLDeviceHeartbeatInterval (const gxPLDevice * device);
 /**
  * @brief Gets the time of the last heartbeat sent
  *
- * The time is given in a unit dependent on the host system, most of the time
- * is given in seconds. On a unix system with a real time clock that value is
- * the number of seconds since the first second of January 1, 1970.
+ * The time is the monotonic time in milliseconds given by
+ * gxPLTimeMonotonicMs(), it is not affected by the changes of the system
+ * clock.
  *
  * @param device pointer on the device
  * @return the last time, -1 if error occurs
@@ -445,10 +445,21 @@ int gxPLDeviceFilterClearAll (gxPLDevice * device);
  * For display purposes.
  * @param filter the filter
  * @return a string in a static buffer that is overwritten with each call to
- * the function.
+ * the function, use gxPLDeviceFilterToBuffer() if several threads can call
+ * this function.
  */
 const char * gxPLDeviceFilterToString (const gxPLFilter * filter);
 
+/**
+ * @brief Convert a filter to a string in a buffer provided by the caller
+ * @param filter the filter
+ * @param buf destination buffer, GXPL_FILTER_STR_MAX characters are enough
+ * @param len size of buf
+ * @return the number of characters written, null excluded, -1 if an error
+ * occurs (errno is set to ENOBUFS if buf is too small)
+ */
+int gxPLDeviceFilterToBuffer (const gxPLFilter * filter, char * buf, int len);
+
 /**
  * @}
  */
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * Directory of the devices alive on the network
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_DIRECTORY_HEADER_
+#define _GXPL_DIRECTORY_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/**
+ * @defgroup gxPLDirectoryDoc Directory
+ * The directory of an application lists the devices of the network from the
+ * heartbeats they send (hbeat.app, hbeat.basic, config.app and config.basic),
+ * without sending any request. A device is removed when it sends its
+ * hbeat.end or config.end message, or when no heartbeat was received for
+ * twice its interval plus one minute. \n
+ * A heartbeat request (hbeat.request) may be sent once to fill the directory
+ * without waiting for the next heartbeats. \n
+ * The directory is read and its function is called by the thread that polls
+ * the application.
+ * @{
+ */
+
+/* constants ================================================================ */
+/**
+ * @brief Maximum number of characters of the version of a device, a longer
+ * version is truncated
+ */
+#define GXPL_DIRECTORY_VERSION_MAX 16
+
+/**
+ * @brief Changes of the directory
+ */
+typedef enum {
+  gxPLDirectoryAdded = 0, /**< first heartbeat of a device */
+  gxPLDirectoryChanged,   /**< the interval, configuration, version or address of a device changed */
+  gxPLDirectoryRemoved,   /**< end heartbeat of a device */
+  gxPLDirectoryExpired    /**< heartbeat not received in time */
+} gxPLDirectoryEvent;
+
+/* structures =============================================================== */
+/**
+ * @brief Device of the directory
+ */
+typedef struct _gxPLDirectoryEntry {
+  gxPLId id;                  /**< identifier of the device */
+  int interval;               /**< heartbeat interval in minutes */
+  int isconfig;               /**< the device waits for its configuration (config.app) */
+  unsigned long last_seen;    /**< time of the last heartbeat, see gxPLTimeMonotonicMs() */
+  char version[GXPL_DIRECTORY_VERSION_MAX + 1]; /**< empty if not sent */
+  char addr[GXPL_NETADDR_STR_MAX]; /**< remote-ip or remote-addr, empty if not sent */
+  int port;                   /**< 0 if not sent */
+} gxPLDirectoryEntry;
+
+/**
+ * @brief Function called when the directory changes
+ *
+ * For gxPLDirectoryRemoved and gxPLDirectoryExpired, the entry is no longer
+ * in the directory and is released after the return.
+ * @param app the application of the directory
+ * @param entry the device
+ * @param event the change
+ * @param udata user data passed to gxPLAppDirectoryOpen()
+ */
+typedef void (*gxPLDirectoryListener) (gxPLApplication * app,
+                                       const gxPLDirectoryEntry * entry,
+                                       gxPLDirectoryEvent event,
+                                       void * udata);
+
+/* internal public functions ================================================ */
+
+/**
+ * @brief Starts to track the devices of the network
+ * @param app pointer to an opened application
+ * @param listener function called on each change, NULL if none
+ * @param udata user data passed to listener
+ * @return 0, -1 if an error occurs (errno is set to EBUSY if the directory is
+ * already opened)
+ */
+int gxPLAppDirectoryOpen (gxPLApplication * app,
+                          gxPLDirectoryListener listener, void * udata);
+
+/**
+ * @brief Stops to track the devices and releases the directory
+ *
+ * The listener is not called. The directory is closed by gxPLAppClose().
+ * @param app pointer to an opened application
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppDirectoryClose (gxPLApplication * app);
+
+/**
+ * @brief Number of devices of the directory
+ * @param app pointer to an opened application
+ * @return the number of devices, 0 if the directory is not opened
+ */
+int gxPLAppDirectoryCount (const gxPLApplication * app);
+
+/**
+ * @brief Device of the directory at an index
+ *
+ * The index of a device can change when another device is removed.
+ * @param app pointer to an opened application
+ * @param index from 0 to gxPLAppDirectoryCount() - 1
+ * @return the device, NULL if index is out of range
+ */
+const gxPLDirectoryEntry * gxPLAppDirectoryAt (const gxPLApplication * app,
+    int index);
+
+/**
+ * @brief Finds a device of the directory by its identifier
+ * @param app pointer to an opened application
+ * @param id identifier of the device
+ * @return the device, NULL if not found
+ */
+const gxPLDirectoryEntry * gxPLAppDirectoryFind (const gxPLApplication * app,
+    const gxPLId * id);
+
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_DIRECTORY_HEADER_ defined */
@@ -38,6 +38,11 @@ __BEGIN_C_DECLS
 
 /**
  * @brief Opens a new gxPLHub object
+ *
+ * If the forward flag of the setting is set, the hub works in forward only
+ * mode: only the header and the schema of the datagrams are scanned (and the
+ * body of the hbeat and config messages for the discovery), the datagrams are
+ * relayed byte for byte to the local applications without being decoded.
  * @param setting pointer to a configuration, this configuration can be modified
  * by the function to return the actual configuration.
  * @return the object or NULL if error occurs
@@ -54,11 +59,35 @@ int gxPLHubClose (gxPLHub * hub);
 /**
  * @brief Polling event of a hub
  * @param hub pointer to a gxPLHub object
- * @param timeout_ms waiting period in ms before output if no event occurs
+ * @param timeout_ms waiting period in ms before output if no event occurs,
+ * a negative value waits for an event or the next timer
  * @return 0, -1 if an error occurs
  */
 int gxPLHubPoll (gxPLHub * hub, int timeout_ms);
 
+/**
+ * @brief Answers the status requests from the state cache of the hub
+ *
+ * When a local application, known by the source of its heartbeats, sends a
+ * request (xpl-cmnd class.request) to a device with a "device" pair and the
+ * hub has received the class.reply_type status of this device for less than
+ * max_age_ms, this status is delivered to the requester only, instead of the
+ * request. The status is the last one sent by the device, with its source.
+ * The requests of the applications of the other computers are delivered
+ * unchanged, their hub answers them. \n
+ * The messages are decoded, the hub must not work in forward only mode.
+ * @param hub pointer to a gxPLHub object
+ * @param size maximum number of status in the cache, 0 for the default size
+ * @param max_age_ms maximum age of a status to answer a request, 0 disables
+ * the answers and releases the cache
+ * @param reply_type schema type of the status answering a request of the same
+ * schema class, NULL for "basic" (sensor.request answered by sensor.basic...)
+ * @return 0, -1 if an error occurs (errno is set to ENOSYS in forward only
+ * mode, to EINVAL if reply_type is not valid)
+ */
+int gxPLHubStateCacheEnable (gxPLHub * hub, int size, int max_age_ms,
+                             const char * reply_type);
+
 /**
  * @brief Returns the application
  * @param hub pointer to a gxPLHub object
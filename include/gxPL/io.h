@@ -53,6 +53,23 @@ gxPLIo * gxPLIoOpen (gxPLSetting * setting);
  */
 int gxPLIoRecv (gxPLIo * io, void * buffer, int count, gxPLIoAddr * source);
 
+/**
+ * @brief Receive a message from the network without copy
+ *
+ * The buffer where the layer received the message is handed over to the
+ * caller, the layer replaces it by a buffer allocated by *allocator.
+ *
+ * @param io io layer
+ * @param buffer returns the buffer of the message, terminated by a null
+ * character, to be released by the allocator returned in *allocator
+ * @param allocator allocator of the new buffer of the layer, returns the
+ * allocator of the buffer handed over
+ * @return number of bytes read, 0 if none, a negative value if error occurs
+ * (errno is set to ENOSYS if the layer does not keep its buffers,
+ * gxPLIoRecv() must be used)
+ */
+int gxPLIoRecvBuffer (gxPLIo * io, char ** buffer, gxPLAllocator ** allocator);
+
 /**
  * @brief Send a message to the network
  *
@@ -66,6 +83,40 @@ int gxPLIoRecv (gxPLIo * io, void * buffer, int count, gxPLIoAddr * source);
  */
 int gxPLIoSend (gxPLIo * io, const void * buffer, int count, const gxPLIoAddr * target);
 
+/**
+ * @brief Send the same message to several targets
+ *
+ * If the layer provides it, a single operation is used for all the targets
+ * (sendmmsg() for udp), otherwise the message is sent to each target in turn.
+ *
+ * @param io io layer
+ * @param buffer buffer where the bytes were stored
+ * @param count number of bytes to send
+ * @param targets array of targets, as for gxPLIoSend()
+ * @param ntargets number of targets
+ * @return number of targets to which the message was sent, a negative value
+ * if the message could not be sent to any of them
+ */
+int gxPLIoSendMulti (gxPLIo * io, const void * buffer, int count,
+                     const gxPLIoAddr * const * targets, int ntargets);
+
+/**
+ * @brief Send a message gathered from several fragments
+ *
+ * The fragments are sent in a single datagram without being copied in a
+ * contiguous buffer (sendmsg() for udp).
+ *
+ * @param io io layer
+ * @param iov array of fragments, in the order of the message
+ * @param iovcnt number of fragments
+ * @param target as for gxPLIoSend()
+ * @return number of bytes sent, a negative value if error occurs (errno is
+ * set to ENOSYS if the layer needs a contiguous frame, gxPLIoSend() must be
+ * used)
+ */
+int gxPLIoSendv (gxPLIo * io, const gxPLIoVec * iov, int iovcnt,
+                 const gxPLIoAddr * target);
+
 /**
  * @brief Close the input-output layer.
  * @param io io layer
@@ -28,7 +28,10 @@ __BEGIN_C_DECLS
  * 
  * All fields are set to zero except the hop count is set to 1 and the type that
  * is set with the value passed as parameter. The message should be released 
- * with gxPLMessageDelete after use.
+ * with gxPLMessageDelete after use. \n
+ * A message is a single block of memory that also stores the first pairs of
+ * the body and their text (DEFAULT_MESSAGE_INLINE_PAIRS and
+ * DEFAULT_MESSAGE_INLINE_TEXT), only larger bodies allocate memory.
  *
  * @param type the type of message
  * @return  the message, NULL if an error occurs
@@ -38,10 +41,25 @@ gxPLMessage * gxPLMessageNew (gxPLMessageType type);
 /**
  * @brief Release a message and all it's resources
  *
+ * If references have been added by gxPLMessageRef(), only one reference is
+ * released, the message is released with the last one.
  * @param message pointer to the message
  */
 void gxPLMessageDelete (gxPLMessage * message);
 
+/**
+ * @brief Adds a reference to a message
+ *
+ * A listener can keep the message it receives after returning by adding a
+ * reference, released by gxPLMessageDelete(). A message with several
+ * references can be read by several threads, it must no longer be modified
+ * and gxPLMessageStringGet() must not be used (gxPLMessageToString() and
+ * gxPLMessageToBuffer() can).
+ * @param message pointer to the message
+ * @return the message
+ */
+gxPLMessage * gxPLMessageRef (gxPLMessage * message);
+
 /**
  * @brief Returns xPL message as text
  * 
@@ -51,6 +69,58 @@ void gxPLMessageDelete (gxPLMessage * message);
  */
 char * gxPLMessageToString (const gxPLMessage * message);
 
+/**
+ * @brief Returns xPL message as text, kept by the message
+ *
+ * The text is formatted on the first call and kept until the message is
+ * modified by one of the functions of this module, the next calls return
+ * it without formatting. A message sent to several clients is thus
+ * formatted only once.
+ *
+ * @param message pointer to the message
+ * @param len pointer to store the length of the text, NULL if not used
+ * @return xPL message as text, NULL if an error occurs. This character buffer
+ * belongs to the message, it is valid until the next modification or the
+ * release of the message.
+ */
+const char * gxPLMessageStringGet (const gxPLMessage * message, int * len);
+
+/**
+ * @brief Number of characters of a message as text
+ *
+ * @param message pointer to the message
+ * @return the length of the text, without the terminating null character,
+ * -1 if an error occurs (errno is set to EINVAL if the type is unknown)
+ */
+int gxPLMessageSerializedSize (const gxPLMessage * message);
+
+/**
+ * @brief Writes a message as text in a buffer provided by the caller
+ *
+ * The text is written in a single pass, without memory allocation.
+ * @param message pointer to the message
+ * @param buf buffer where the null-terminated text is written
+ * @param len size of the buffer, at least gxPLMessageSerializedSize() + 1
+ * @return the length of the text, without the terminating null character,
+ * -1 if an error occurs (errno is set to ENOBUFS if the buffer is too small)
+ */
+int gxPLMessageToBuffer (const gxPLMessage * message, char * buf, int len);
+
+/**
+ * @brief Describes a message as text by fragments, without copy
+ *
+ * The fragments point to the identifiers, the schema and the pairs of the
+ * message and to constant strings, they are valid until the next
+ * modification or the release of the message. They are sent with
+ * gxPLIoSendv().
+ * @param message pointer to the message
+ * @param iov array where the fragments are stored
+ * @param iovmax number of elements of iov, 4 per pair plus 20 are enough
+ * @return the number of fragments, -1 if an error occurs (errno is set to
+ * ENOBUFS if iov is too small, EINVAL if the hop count has more than one digit)
+ */
+int gxPLMessageToIoVec (const gxPLMessage * message, gxPLIoVec * iov, int iovmax);
+
 /**
  * @brief Parse a list of lines as text  to extract a message
  * 
@@ -68,6 +138,24 @@ char * gxPLMessageToString (const gxPLMessage * message);
  */
 gxPLMessage * gxPLMessageFromString (gxPLMessage * message, char * line);
 
+/**
+ * @brief Decode a message in place, without copying its content
+ *
+ * The message takes ownership of the buffer, the name/value pairs of the body
+ * point directly into it (no allocation per pair). The buffer is released
+ * with the message by gxPLMessageDelete(). \n
+ * The pairs added or modified afterwards are stored in the message, the
+ * pairs of the buffer are left in place. \n
+ * If the buffer does not contain a complete message, the next parts must be
+ * passed to gxPLMessageFromString().
+ *
+ * @param buffer null-terminated text of the message, allocated on the heap.
+ * This buffer is modified by the function and released with the message
+ * (or immediately if an error occurs).
+ * @return the message, NULL if an error occurs
+ */
+gxPLMessage * gxPLMessageFromBuffer (char * buffer);
+
 /**
  * @brief Check if the passed message matches the passed filter
  * @param message pointer to the message
@@ -327,6 +415,9 @@ int gxPLMessageSchemaTypeSet (gxPLMessage * message, const char * schema_type);
 
 /**
  * @brief Returns body of message as a const vector of gxPLPair
+ *
+ * The vector is a view of the pairs stored in the message, built on the
+ * first call after a change of the body.
  * @param message pointer to the message
  * @return pointer body of message as a const vector of gxPLPair, must not be 
  * released. NULL if an error occurs
@@ -338,7 +429,10 @@ const xVector * gxPLMessageBodyGetConst (const gxPLMessage * message);
  * 
  * All added pairs will be released during the destruction of the message.
  * If a pair is changed, it will reallocate the memory of the modified parameter 
- * if it is longer.
+ * if it is longer. \n
+ * The pairs are moved from the message to the vector on the heap, this
+ * function should be avoided where gxPLMessagePairSet() and
+ * gxPLMessageBodyGetConst() are enough.
  * 
  * @param message pointer to the message
  * @return pointer body of message as a vector of gxPLPair, must not be 
@@ -376,6 +470,29 @@ const char * gxPLMessagePairGet (const gxPLMessage * message, const char * name)
  */
 int gxPLMessagePairExist (const gxPLMessage * message, const char * name);
 
+/**
+ * @brief Function called for each pair by gxPLMessagePairForEach()
+ * @param pair the pair, must not be modified
+ * @param udata user data passed to gxPLMessagePairForEach()
+ * @return 0 to continue, any other value stops the iteration
+ */
+struct _gxPLPair; /* defined in gxPL/util.h */
+typedef int (* gxPLPairCallback) (const struct _gxPLPair * pair, void * udata);
+
+/**
+ * @brief Calls a function for each pair with a given name
+ *
+ * Used for the names that may have several values (filter, group, option ...),
+ * the pairs are passed in the order of the body.
+ * @param message pointer to the message
+ * @param name the name
+ * @param func function to call
+ * @param udata user data passed to func
+ * @return number of pairs passed to func, -1 if an error occurs
+ */
+int gxPLMessagePairForEach (const gxPLMessage * message, const char * name,
+                            gxPLPairCallback func, void * udata);
+
 /**
  * @brief Adds a pair to the body
  * @param message pointer to the message
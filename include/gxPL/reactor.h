@@ -0,0 +1,91 @@
+/**
+ * @file
+ * Event loop shared by several applications
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_REACTOR_HEADER_
+#define _GXPL_REACTOR_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+
+/* internal public functions ================================================ */
+
+/**
+ * @defgroup gxPLReactorDoc Reactor
+ * A reactor waits with a single blocking call for the events of any number
+ * of applications and dispatches the messages of whichever is ready. \n
+ * The io layer of each application must provide its file descriptor
+ * (gxPLIoFuncGetFd), this is the case of the udp layer. The heartbeats of the
+ * devices of all registered applications are managed by the reactor.
+ * @{
+ */
+
+/**
+ * @brief Creates a new empty reactor
+ * @return the object or NULL if error occurs
+ */
+gxPLReactor * gxPLReactorNew (void);
+
+/**
+ * @brief Release a reactor
+ *
+ * The registered applications are not closed.
+ * @param reactor pointer to a gxPLReactor object
+ * @return 0, -1 if an error occurs
+ */
+int gxPLReactorDelete (gxPLReactor * reactor);
+
+/**
+ * @brief Registers an application
+ *
+ * The send queue of the application, if any, must be opened before.
+ * @param reactor pointer to a gxPLReactor object
+ * @param app pointer to an opened application
+ * @return 0, -1 if an error occurs (errno is set to EINVAL if the io layer
+ * of the application does not provide a file descriptor)
+ */
+int gxPLReactorAdd (gxPLReactor * reactor, gxPLApplication * app);
+
+/**
+ * @brief Unregisters an application
+ *
+ * Must be called before closing a registered application.
+ * @param reactor pointer to a gxPLReactor object
+ * @param app pointer to a registered application
+ * @return 0, -1 if an error occurs
+ */
+int gxPLReactorRemove (gxPLReactor * reactor, gxPLApplication * app);
+
+/**
+ * @brief Number of registered applications
+ * @param reactor pointer to a gxPLReactor object
+ * @return number of applications, -1 if an error occurs
+ */
+int gxPLReactorSize (const gxPLReactor * reactor);
+
+/**
+ * @brief Waits for events on all registered applications and dispatches them
+ *
+ * Each application ready is polled with gxPLAppPollBudget(), the
+ * timers of the others are run. The wait never exceeds the next timer
+ * expiry of the registered applications.
+ * @param reactor pointer to a gxPLReactor object
+ * @param timeout_ms waiting period in ms before output if no event occurs,
+ * a negative value waits for an event or the next timer
+ * @return number of datagrams processed, -1 if an error occurs
+ */
+int gxPLReactorPoll (gxPLReactor * reactor, int timeout_ms);
+
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_REACTOR_HEADER_ defined */
@@ -0,0 +1,97 @@
+/**
+ * @file
+ * Requests waiting for a reply
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_REQUEST_HEADER_
+#define _GXPL_REQUEST_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/**
+ * @defgroup gxPLRequestDoc Requests
+ * gxPLAppRequest() sends a message (config.list, config.current,
+ * sensor.request, hbeat.request...) and calls a function when the reply is
+ * received or when no reply was received before a timeout. \n
+ * The requests are indexed by the source and the schema class of the
+ * expected reply: a received message is compared with the requests that
+ * match them only, not with all the requests waiting. The timeouts are
+ * scheduled on the timers of the application. \n
+ * xPL messages have no identifier, when several requests expect the same
+ * reply, the oldest one receives it. The requests are made and the
+ * functions are called by the thread that polls the application, the
+ * functions must not block.
+ * @{
+ */
+
+/* structures =============================================================== */
+/**
+ * @brief Function called when a reply is received or a request times out
+ * @param app the application of the request
+ * @param reply the reply, NULL if the request times out or is released by
+ * gxPLAppClose(). The message must not be modified, it must be copied to be
+ * used after the return.
+ * @param udata user data passed to gxPLAppRequest()
+ */
+typedef void (*gxPLRequestCallback) (gxPLApplication * app,
+                                     gxPLMessage * reply, void * udata);
+
+/**
+ * @brief Messages accepted as a reply to a request
+ */
+typedef struct _gxPLRequestMatch {
+  gxPLMessageType type;       /**< type of the reply, gxPLMessageAny for all */
+  const char * schema_class;  /**< NULL for the schema class of the request */
+  const char * schema_type;   /**< NULL for all */
+  const gxPLId * source;      /**< NULL for the target of the request, all the sources if it is broadcast or grouped */
+  int multiple;               /**< the function is called for each reply until the timeout, then with a NULL reply */
+} gxPLRequestMatch;
+
+/* internal public functions ================================================ */
+
+/**
+ * @brief Sends a request and waits for its reply without blocking
+ *
+ * The messages sent by the source of the request are never a reply.
+ * @param app pointer to an opened application
+ * @param message the request, sent by gxPLAppBroadcastMessage()
+ * @param match the replies accepted, NULL for a single reply from the target
+ * of the request with the same schema class
+ * @param timeout_ms delay before callback is called without reply
+ * @param callback function called with the reply or on timeout
+ * @param udata user data passed to callback
+ * @return identifier of the request, -1 if an error occurs (errno is set to
+ * EINVAL if an argument is not valid)
+ */
+int gxPLAppRequest (gxPLApplication * app, const gxPLMessage * message,
+                    const gxPLRequestMatch * match, int timeout_ms,
+                    gxPLRequestCallback callback, void * udata);
+
+/**
+ * @brief Cancels a request waiting for its reply, its function is not called
+ * @param app pointer to an opened application
+ * @param id identifier returned by gxPLAppRequest()
+ * @return 0, -1 if an error occurs (errno is set to ENOENT if the request was
+ * completed)
+ */
+int gxPLAppRequestCancel (gxPLApplication * app, int id);
+
+/**
+ * @brief Number of requests waiting for their reply
+ * @param app pointer to an opened application
+ * @return the number of requests
+ */
+int gxPLAppRequestCount (const gxPLApplication * app);
+
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_REQUEST_HEADER_ defined */
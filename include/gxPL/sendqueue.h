@@ -0,0 +1,116 @@
+/**
+ * @file
+ * Queue of the messages sent by the threads of the user
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_SENDQUEUE_HEADER_
+#define _GXPL_SENDQUEUE_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/**
+ * @defgroup gxPLSendQueueDoc Send queue
+ * The functions that send a message (gxPLAppBroadcastMessage(),
+ * gxPLDeviceMessageSend()...) must be called by the thread that polls the
+ * application and wait for the network. \n
+ * gxPLAppSendAsync() can be called by any thread: the message is added to a
+ * bounded queue without lock, then broadcast by gxPLAppPoll(). When the io
+ * layer supports it, a descriptor registered with the poll wakes it up as
+ * soon as a message is queued, otherwise the messages are sent at the end of
+ * the current wait. \n
+ * The queue must be opened before the application is added to a reactor.
+ * @{
+ */
+
+/* constants ================================================================ */
+/**
+ * @brief What gxPLAppSendAsync() does when the queue is full
+ */
+typedef enum {
+  gxPLSendQueueDropNewest = 0,  /**< the message is not queued */
+  gxPLSendQueueDropOldest,      /**< the oldest message of the queue is removed */
+  gxPLSendQueueBlock            /**< waits for the poll to make room */
+} gxPLSendQueuePolicy;
+
+/* structures =============================================================== */
+/**
+ * @brief Counters of a send queue
+ */
+typedef struct _gxPLSendQueueStats {
+  unsigned long enqueued; /**< messages added to the queue */
+  unsigned long sent;     /**< messages sent by the poll */
+  unsigned long dropped;  /**< messages removed by the policy or not sent */
+  int depth;              /**< messages waiting in the queue */
+  int size;               /**< capacity of the queue */
+} gxPLSendQueueStats;
+
+/* internal public functions ================================================ */
+
+/**
+ * @brief Opens the send queue of an application
+ * @param app pointer to an opened application
+ * @param size capacity of the queue, rounded up to a power of 2, 0 for the
+ * default size
+ * @param policy what to do when the queue is full
+ * @return 0, -1 if an error occurs (errno is set to EBUSY if the queue is
+ * already opened, EINVAL if size is out of range)
+ */
+int gxPLAppSendQueueOpen (gxPLApplication * app, int size,
+                          gxPLSendQueuePolicy policy);
+
+/**
+ * @brief Closes the send queue of an application
+ *
+ * The messages in the queue are sent before. No thread must be in
+ * gxPLAppSendAsync(). The queue is closed by gxPLAppClose().
+ * @param app pointer to an opened application
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppSendQueueClose (gxPLApplication * app);
+
+/**
+ * @brief Broadcasts a message from any thread
+ *
+ * A reference to the message is added to the queue (see gxPLMessageRef()),
+ * the caller keeps its own one and must no longer modify the message.
+ * With the gxPLSendQueueBlock policy, the thread that polls the application
+ * sends the queue itself instead of waiting.
+ * @param app pointer to an application with an opened send queue
+ * @param message the message to broadcast
+ * @return 0, -1 if an error occurs (errno is set to EINVAL if the queue is
+ * not opened, ENOBUFS if the message was dropped because the queue is full)
+ */
+int gxPLAppSendAsync (gxPLApplication * app, gxPLMessage * message);
+
+/**
+ * @brief Counters of the send queue of an application
+ * @param app pointer to an application with an opened send queue
+ * @param stats pointer to the result
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppSendQueueStats (const gxPLApplication * app,
+                           gxPLSendQueueStats * stats);
+
+/**
+ * @brief Descriptor readable when messages are waiting in the send queue
+ *
+ * For an external event loop, see gxPLAppFd(). It is read by
+ * gxPLAppProcessReady().
+ * @param app pointer to an opened application
+ * @return the descriptor, -1 if the queue is not opened or can not wake up
+ * the loop (the messages are then sent by the next gxPLAppProcessReady())
+ */
+int gxPLAppSendQueueFd (const gxPLApplication * app);
+
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_SENDQUEUE_HEADER_ defined */
@@ -0,0 +1,98 @@
+/**
+ * @file
+ * Cache of the last status of the devices
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_STATECACHE_HEADER_
+#define _GXPL_STATECACHE_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/**
+ * @defgroup gxPLStateCacheDoc State cache
+ * The state cache of an application keeps the last status (xpl-stat) or
+ * trigger (xpl-trig) message received for each source, schema and value of
+ * the "device" pair (sensor.basic, x10.basic...), so the current state of a
+ * device can be read without sending a request. The heartbeats and the
+ * configuration messages are not cached. \n
+ * The number of messages is bounded, the least recently used is removed when
+ * the cache is full. A message is copied as text in a single buffer decoded
+ * in place, like a message received. \n
+ * The cache is read by the thread that polls the application.
+ * @{
+ */
+
+/* structures =============================================================== */
+/**
+ * @brief Counters of a state cache
+ */
+typedef struct _gxPLStateCacheStats {
+  int count;              /**< messages in the cache */
+  int size;               /**< maximum number of messages */
+  unsigned long hits;     /**< messages found by gxPLAppStateCacheGet() */
+  unsigned long misses;   /**< messages not found by gxPLAppStateCacheGet() */
+  unsigned long evicted;  /**< messages removed because the cache was full */
+} gxPLStateCacheStats;
+
+/* internal public functions ================================================ */
+
+/**
+ * @brief Starts to cache the status of the devices
+ * @param app pointer to an opened application
+ * @param size maximum number of messages, 0 for the default size
+ * @return 0, -1 if an error occurs (errno is set to EBUSY if the cache is
+ * already opened, EINVAL if size is out of range)
+ */
+int gxPLAppStateCacheOpen (gxPLApplication * app, int size);
+
+/**
+ * @brief Releases the state cache of an application
+ *
+ * The messages returned by gxPLAppStateCacheGet() remain valid until they are
+ * released. The cache is closed by gxPLAppClose().
+ * @param app pointer to an opened application
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppStateCacheClose (gxPLApplication * app);
+
+/**
+ * @brief Last status of a device
+ * @param app pointer to an opened application
+ * @param source identifier of the device
+ * @param schema_class schema class of the status
+ * @param schema_type schema type of the status
+ * @param device value of the "device" pair, NULL or empty if the status has
+ * no such pair
+ * @param age_ms if not NULL, time elapsed since the reception in milliseconds
+ * @return a reference to the message that must be released with
+ * gxPLMessageDelete() and must not be modified, NULL if not found (errno is
+ * set to ENOENT)
+ */
+gxPLMessage * gxPLAppStateCacheGet (gxPLApplication * app,
+                                    const gxPLId * source,
+                                    const char * schema_class,
+                                    const char * schema_type,
+                                    const char * device,
+                                    unsigned long * age_ms);
+
+/**
+ * @brief Counters of the state cache of an application
+ * @param app pointer to an application with an opened state cache
+ * @param stats pointer to the result
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppStateCacheStats (const gxPLApplication * app,
+                            gxPLStateCacheStats * stats);
+
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_STATECACHE_HEADER_ defined */
@@ -48,7 +48,8 @@ int gxPLStrCpy (char * dst, const char * src);
 /**
  * @brief Quickly to convert an long integer to string
  * @param value
- * @return a static const string
+ * @return a static const string, overwritten by each call, use
+ * gxPLLongToBuffer() if several threads can call this function
  */
 const char * gxPLLongToStr (long value);
 
@@ -56,10 +57,32 @@ const char * gxPLLongToStr (long value);
  * @brief Quickly to convert an double to string
  * @param value
  * @param precision (8 max)
- * @return a static const string
+ * @return a static const string, overwritten by each call, use
+ * gxPLDoubleToBuffer() if several threads can call this function
  */
 const char * gxPLDoubleToStr (double value, int precision);
 
+/**
+ * @brief Converts an long integer to string in a buffer provided by the caller
+ * @param value
+ * @param buf destination buffer
+ * @param len size of buf
+ * @return the number of characters written, null excluded, -1 if an error
+ * occurs (errno is set to ENOBUFS if buf is too small)
+ */
+int gxPLLongToBuffer (long value, char * buf, int len);
+
+/**
+ * @brief Converts an double to string in a buffer provided by the caller
+ * @param value
+ * @param precision (8 max)
+ * @param buf destination buffer
+ * @param len size of buf
+ * @return the number of characters written, null excluded, -1 if an error
+ * occurs (errno is set to ENOBUFS if buf is too small)
+ */
+int gxPLDoubleToBuffer (double value, int precision, char * buf, int len);
+
 /**
  * @}
  */
@@ -289,6 +312,24 @@ int gxPLSchemaIsEmpty (const gxPLSchema * schema);
  * @}
  */
 
+/**
+ * @defgroup gxPLUtilTokenDoc Interned strings
+ * The schemas and identifiers of the devices and filters are interned in a
+ * table shared by the whole process, the headers of the messages received
+ * are looked up in this table and compared as integers.
+ * @{
+ */
+/**
+ * @brief Statistics of the table of interned strings
+ * @param hit number of lookups that found the string, may be NULL
+ * @param miss number of lookups that did not find the string, may be NULL
+ * @return number of strings interned
+ */
+int gxPLTokenStats (unsigned long * hit, unsigned long * miss);
+/**
+ * @}
+ */
+
 /**
  * @defgroup gxPLUtilTimeDoc Time
  * @{
@@ -308,11 +349,23 @@ unsigned long gxPLTime (void);
  */
 int gxPLTimeMs (unsigned long * ms);
 
+/**
+ * @brief Monotonic time in milliseconds
+ *
+ * Unlike gxPLTime() and gxPLTimeMs(), this time is not affected by the
+ * changes of the system clock, it must be used to measure delays. Its origin
+ * is unspecified.
+ * @param ms pointer on the result
+ * @return 0, < 0 if error occurs
+ */
+int gxPLTimeMonotonicMs (unsigned long * ms);
+
 /**
  * @brief converts the system time t into a null-terminated string
  * @param t time return by gxPLTime
  * @param format same as strftime() on unix, NULL if default (yyyymmddhhmmss)
- * @return system time t into a null-terminated string
+ * @return system time t into a static string, overwritten by each call, use
+ * gxPLDateTimeToBuffer() if several threads can call this function
  */
 char * gxPLDateTimeStr (unsigned long t, const char * format);
 
@@ -320,7 +373,8 @@ char * gxPLDateTimeStr (unsigned long t, const char * format);
  * @brief converts the system time t into a null-terminated string
  * @param t time return by gxPLTime
  * @param format same as strftime() on unix, NULL if default (yyyymmdd)
- * @return system time t into a null-terminated string
+ * @return system time t into a static string, overwritten by each call, use
+ * gxPLDateToBuffer() if several threads can call this function
  */
 char * gxPLDateStr (unsigned long t, const char * format);
 
@@ -328,10 +382,44 @@ char * gxPLDateStr (unsigned long t, const char * format);
  * @brief converts the system time t into a null-terminated string
  * @param t time return by gxPLTime
  * @param format same as strftime() on unix, NULL if default (hhmmss)
- * @return system time t into a null-terminated string
+ * @return system time t into a static string, overwritten by each call, use
+ * gxPLTimeToBuffer() if several threads can call this function
  */
 char * gxPLTimeStr (unsigned long t, const char * format);
 
+/**
+ * @brief converts the system time t into a buffer provided by the caller
+ * @param t time return by gxPLTime
+ * @param format same as gxPLDateTimeStr()
+ * @param buf destination buffer
+ * @param len size of buf
+ * @return the number of characters written, null excluded, -1 if an error
+ * occurs (errno is set to ENOBUFS if buf is too small)
+ */
+int gxPLDateTimeToBuffer (unsigned long t, const char * format, char * buf, int len);
+
+/**
+ * @brief converts the date of the system time t into a buffer provided by the caller
+ * @param t time return by gxPLTime
+ * @param format same as gxPLDateStr()
+ * @param buf destination buffer
+ * @param len size of buf
+ * @return the number of characters written, null excluded, -1 if an error
+ * occurs (errno is set to ENOBUFS if buf is too small)
+ */
+int gxPLDateToBuffer (unsigned long t, const char * format, char * buf, int len);
+
+/**
+ * @brief converts the hour of the system time t into a buffer provided by the caller
+ * @param t time return by gxPLTime
+ * @param format same as gxPLTimeStr()
+ * @param buf destination buffer
+ * @param len size of buf
+ * @return the number of characters written, null excluded, -1 if an error
+ * occurs (errno is set to ENOBUFS if buf is too small)
+ */
+int gxPLTimeToBuffer (unsigned long t, const char * format, char * buf, int len);
+
 /**
  * @brief suspends execution for (at least) ms milliseconds
  * @param ms delay in milliseconds
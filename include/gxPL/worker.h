@@ -0,0 +1,93 @@
+/**
+ * @file
+ * Dispatch of the messages by a pool of worker threads
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_WORKER_HEADER_
+#define _GXPL_WORKER_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/**
+ * @defgroup gxPLWorkerDoc Workers
+ * By default, the listeners are called by gxPLAppPoll(), a slow listener
+ * delays the reception of the following messages. \n
+ * When workers are started, the thread that polls the application decodes
+ * the messages, runs the xPL protocol (heartbeats, hub detection,
+ * configuration, filters, groups), then hands the messages over to the
+ * workers that call the listeners of the user. The work is sharded by
+ * device: the listeners of a device are always called by the same worker and
+ * receive the messages in order, the devices assigned to different workers
+ * run in parallel. The listeners of the application
+ * (gxPLMessageListenerAdd()) are sharded by source of the messages. \n
+ * A message can be read by several workers at the same time: the listeners
+ * must not modify it (see gxPLMessageRef()). They can send messages,
+ * preferably with gxPLAppSendAsync(), the other functions of the application
+ * and its devices must be called by the thread that polls the application.
+ * @{
+ */
+
+/* structures =============================================================== */
+/**
+ * @brief Statistics of a worker
+ */
+typedef struct _gxPLWorkerStats {
+  int depth;                  /**< messages waiting in the queue */
+  int depth_max;              /**< highest number of messages waiting */
+  unsigned long count;        /**< messages processed */
+  unsigned long latency_avg;  /**< mean delay between the hand over and the end of the processing, in microseconds */
+  unsigned long latency_max;  /**< highest delay, in microseconds */
+} gxPLWorkerStats;
+
+/* internal public functions ================================================ */
+
+/**
+ * @brief Starts the dispatch of the messages of an application by workers
+ * @param app pointer to an opened application
+ * @param count number of worker threads
+ * @return 0, -1 if an error occurs (errno is set to EBUSY if the workers are
+ * already started, EINVAL if count is out of range)
+ */
+int gxPLAppWorkersStart (gxPLApplication * app, int count);
+
+/**
+ * @brief Stops the workers of an application
+ *
+ * The messages already handed over are processed before the workers exit,
+ * the listeners are then called by gxPLAppPoll(). The workers are stopped
+ * by gxPLAppClose().
+ * @param app pointer to an opened application
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppWorkersStop (gxPLApplication * app);
+
+/**
+ * @brief Number of workers of an application
+ * @param app pointer to an opened application
+ * @return number of workers, 0 if the listeners are called by gxPLAppPoll()
+ */
+int gxPLAppWorkersCount (const gxPLApplication * app);
+
+/**
+ * @brief Statistics of a worker
+ * @param app pointer to an opened application
+ * @param worker index of the worker, from 0 to gxPLAppWorkersCount() - 1
+ * @param stats pointer to the result
+ * @return 0, -1 if an error occurs (errno is set to EINVAL if worker is out
+ * of range)
+ */
+int gxPLAppWorkerStats (const gxPLApplication * app, int worker,
+                        gxPLWorkerStats * stats);
+
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_WORKER_HEADER_ defined */
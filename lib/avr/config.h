@@ -20,11 +20,27 @@ extern "C" {
 #define DEFAULT_HEARTBEAT_INTERVAL        300
 #define DEFAULT_CONFIG_HEARTBEAT_INTERVAL 60
 #define DEFAULT_HUB_DISCOVERY_INTERVAL    3
-#define DEFAULT_ALLOC_STR_GROW            256
 #define DEFAULT_LINE_BUFSIZE              256
 #define DEFAULT_MAX_DEVICE_GROUP          4
 #define DEFAULT_MAX_DEVICE_FILTER         4
 #define DEFAULT_XBEE_PORT                 "tty0"
+#define DEFAULT_POLL_BUDGET               4
+#define DEFAULT_TIMER_TICK_MS             16
+#define DEFAULT_TIMER_WHEEL_BITS          4
+#define DEFAULT_TIMER_WHEEL_LEVELS        4
+#define DEFAULT_DEVICE_HASH_SIZE          2
+#define DEFAULT_TOKEN_HASH_SIZE           8
+#define DEFAULT_TOKEN_MAX                 32
+#define DEFAULT_PAIR_INDEX_MIN            16
+#define DEFAULT_MESSAGE_INLINE_PAIRS      4
+#define DEFAULT_MESSAGE_INLINE_TEXT       64
+#define DEFAULT_POOL_SLAB_SIZE            512
+#define DEFAULT_SEND_BUFSIZE              128
+#define DEFAULT_SENDV_PAIRS               4
+#define DEFAULT_SEND_IOVMAX               32
+#define DEFAULT_REQUEST_HASH_SIZE         2
+#define DEFAULT_DIRECTORY_HASH_SIZE       4
+#define DEFAULT_STATE_CACHE_SIZE          8
 // AVR only, config store in EEPROM
 #define DEFAULT_CONFIG_SIZE_MAX           512
 #define DEFAULT_XBEE_RESET_PORT           PORTB
@@ -36,6 +52,8 @@ extern "C" {
 #define CONFIG_DEVICE_FILTER          1
 // add the "remote-addr" field in hbeat.basic
 #define CONFIG_HBEAT_BASIC_EXTENSION  1
+// locks the state shared by the applications, they can run in several threads
+#define CONFIG_THREAD_SAFE            0
 // XBEE
 #define CONFIG_XBEE_RESET_PORT        PORTB
 #define CONFIG_XBEE_RESET_PIN         7
@@ -21,14 +21,37 @@ extern "C" {
 #define DEFAULT_HEARTBEAT_INTERVAL        300
 #define DEFAULT_CONFIG_HEARTBEAT_INTERVAL 60
 #define DEFAULT_HUB_DISCOVERY_INTERVAL    3
-#define DEFAULT_ALLOC_STR_GROW            256
 #define DEFAULT_LINE_BUFSIZE              256
 #define DEFAULT_MAX_DEVICE_GROUP          4
 #define DEFAULT_MAX_DEVICE_FILTER         4
 #define DEFAULT_XBEE_PORT                 "/dev/ttyUSB0"
+#define DEFAULT_POLL_BUDGET               32
+#define DEFAULT_TIMER_TICK_MS             1
+#define DEFAULT_TIMER_WHEEL_BITS          6
+#define DEFAULT_TIMER_WHEEL_LEVELS        4
+#define DEFAULT_DEVICE_HASH_SIZE          16
+#define DEFAULT_TOKEN_HASH_SIZE           64
+#define DEFAULT_TOKEN_MAX                 1024
+#define DEFAULT_PAIR_INDEX_MIN            8
+#define DEFAULT_MESSAGE_INLINE_PAIRS      8
+#define DEFAULT_MESSAGE_INLINE_TEXT       192
+#define DEFAULT_POOL_SLAB_SIZE            8192
+#define DEFAULT_SEND_BUFSIZE              1500
+#define DEFAULT_SENDV_PAIRS               8
+#define DEFAULT_SEND_IOVMAX               256
 // Unix only
 #define DEFAULT_CONFIG_HOME_DIRECTORY     ".gxpl"
 #define DEFAULT_CONFIG_SYS_DIRECTORY      "/etc/gxpl"
+#define DEFAULT_UDP_RING_SIZE             16
+#define DEFAULT_UDP_BUFSIZE               1500
+#define DEFAULT_UDP_SEND_BATCH            32
+#define DEFAULT_UDP_IOV_MAX               256
+#define DEFAULT_WORKER_MAX                64
+#define DEFAULT_SEND_QUEUE_SIZE           256
+#define DEFAULT_REQUEST_HASH_SIZE         16
+#define DEFAULT_DIRECTORY_HASH_SIZE       16
+#define DEFAULT_STATE_CACHE_SIZE          256
+#define DEFAULT_HUB_HASH_SIZE             16
 
 /* build options ============================================================ */
 #define CONFIG_DEVICE_CONFIGURABLE    1
@@ -36,6 +59,11 @@ extern "C" {
 #define CONFIG_DEVICE_FILTER          1
 // add the "remote-addr" field in hbeat.basic
 #define CONFIG_HBEAT_BASIC_EXTENSION  1
+// locks the state shared by the applications, they can run in several threads
+#define CONFIG_THREAD_SAFE            1
+// sysio provides the descriptor of the serial port of an XBee module
+// (iXBeeFileNo()), the xbeezb layer can then be used in an event loop
+#define CONFIG_XBEEZB_FILENO          0
 
 /* conditionals options ====================================================== */
 
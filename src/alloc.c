@@ -0,0 +1,285 @@
+/**
+ * @file
+ * Memory allocators
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL/alloc.h>
+#include "lock_p.h"
+
+/* constants ================================================================ */
+// memory allocated at once when a size class of a pool is empty
+#ifndef DEFAULT_POOL_SLAB_SIZE
+#define DEFAULT_POOL_SLAB_SIZE  8192
+#endif
+
+// sizes of the blocks of a pool, header included. The last classes hold the
+// messages and the receive buffers of an ethernet frame.
+static const size_t class_size[] = {
+  32, 64, 128, 256, 384, 512, 768, 1024, 1536, 2048
+};
+#define POOL_CLASSES (sizeof (class_size) / sizeof (class_size[0]))
+
+/* structures =============================================================== */
+
+/*
+ * Header of each block, stores the size requested and keeps the block aligned
+ * for any type
+ */
+typedef union _block_header {
+  size_t size;
+  long double ld;
+  long long ll;
+  void * ptr;
+} block_header;
+
+typedef struct _pool_block {
+  struct _pool_block * next;
+} pool_block;
+
+typedef struct _pool_slab {
+  struct _pool_slab * next;
+} pool_slab;
+
+typedef struct _gxPLPool {
+  gxPLAllocator allocator; /* must be the first */
+  pool_block * free[POOL_CLASSES];
+  pool_slab * slab;
+  gxPLMutex lock; /* the blocks may be released by another thread */
+} gxPLPool;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void *
+prvHeapAlloc (gxPLAllocator * allocator, size_t size) {
+
+  return malloc (size);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvHeapFree (gxPLAllocator * allocator, void * ptr, size_t size) {
+
+  free (ptr);
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the size class of a block, -1 if it is too large for the pool */
+static int
+prvPoolClass (size_t size) {
+
+  for (int c = 0; c < POOL_CLASSES; c++) {
+
+    if (size <= class_size[c]) {
+
+      return c;
+    }
+  }
+  return -1;
+}
+
+/* -----------------------------------------------------------------------------
+ * Fills an empty size class with the blocks of a new slab */
+static int
+prvPoolRefill (gxPLPool * pool, int c) {
+  size_t n = MAX (DEFAULT_POOL_SLAB_SIZE / class_size[c], 1);
+  pool_slab * slab = malloc (sizeof (block_header) + n * class_size[c]);
+
+  if (slab == NULL) {
+
+    return -1;
+  }
+  slab->next = pool->slab;
+  pool->slab = slab;
+
+  for (char * p = (char *) slab + sizeof (block_header); n > 0;
+       n--, p += class_size[c]) {
+    pool_block * b = (pool_block *) p;
+
+    b->next = pool->free[c];
+    pool->free[c] = b;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static void *
+prvPoolAlloc (gxPLAllocator * allocator, size_t size) {
+  gxPLPool * pool = (gxPLPool *) allocator;
+  int c = prvPoolClass (size);
+  pool_block * b = NULL;
+
+  if (c < 0) {
+
+    return malloc (size);
+  }
+
+  gxPLMutexLock (&pool->lock);
+  if ( (pool->free[c] != NULL) || (prvPoolRefill (pool, c) == 0)) {
+
+    b = pool->free[c];
+    pool->free[c] = b->next;
+  }
+  gxPLMutexUnlock (&pool->lock);
+  return b;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvPoolFree (gxPLAllocator * allocator, void * ptr, size_t size) {
+  gxPLPool * pool = (gxPLPool *) allocator;
+  int c = prvPoolClass (size);
+
+  if (c < 0) {
+
+    free (ptr);
+  }
+  else {
+    pool_block * b = (pool_block *) ptr;
+
+    gxPLMutexLock (&pool->lock);
+    b->next = pool->free[c];
+    pool->free[c] = b;
+    gxPLMutexUnlock (&pool->lock);
+  }
+}
+
+/* private variables ======================================================== */
+static gxPLAllocator heap = {
+  .alloc = prvHeapAlloc,
+  .free = prvHeapFree
+};
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+gxPLAllocator *
+gxPLAllocatorHeap (void) {
+
+  return &heap;
+}
+
+// -----------------------------------------------------------------------------
+gxPLAllocator *
+gxPLAllocatorPoolNew (void) {
+  gxPLPool * pool = calloc (1, sizeof (gxPLPool));
+
+  if (pool) {
+
+    pool->allocator.alloc = prvPoolAlloc;
+    pool->allocator.free = prvPoolFree;
+    gxPLMutexInit (&pool->lock);
+    return &pool->allocator;
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAllocatorPoolDelete (gxPLAllocator * allocator) {
+  gxPLPool * pool = (gxPLPool *) allocator;
+
+  if ( (allocator == NULL) || (allocator->alloc != prvPoolAlloc)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (gxPLAtomicGet (&allocator->live) > 0) {
+
+    errno = EBUSY;
+    return -1;
+  }
+
+  while (pool->slab) {
+    pool_slab * slab = pool->slab;
+
+    pool->slab = slab->next;
+    free (slab);
+  }
+  gxPLMutexDestroy (&pool->lock);
+  free (pool);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+void *
+gxPLAllocatorAlloc (gxPLAllocator * allocator, size_t size) {
+  block_header * h;
+
+  if (allocator == NULL) {
+
+    allocator = &heap;
+  }
+
+  h = allocator->alloc (allocator, sizeof (block_header) + size);
+  if (h == NULL) {
+
+    errno = ENOMEM;
+    return NULL;
+  }
+  h->size = size;
+  gxPLAtomicAdd (&allocator->live, 1);
+  gxPLAtomicAdd (&allocator->bytes, (long) size);
+  return h + 1;
+}
+
+// -----------------------------------------------------------------------------
+void *
+gxPLAllocatorRealloc (gxPLAllocator * allocator, void * ptr, size_t size) {
+  void * p;
+
+  if (ptr == NULL) {
+
+    return gxPLAllocatorAlloc (allocator, size);
+  }
+
+  p = gxPLAllocatorAlloc (allocator, size);
+  if (p) {
+    size_t old_size = ( (block_header *) ptr - 1)->size;
+
+    memcpy (p, ptr, MIN (old_size, size));
+    gxPLAllocatorFree (allocator, ptr);
+  }
+  return p;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLAllocatorFree (gxPLAllocator * allocator, void * ptr) {
+
+  if (ptr) {
+    block_header * h = (block_header *) ptr - 1;
+
+    if (allocator == NULL) {
+
+      allocator = &heap;
+    }
+    gxPLAtomicAdd (&allocator->live, -1);
+    gxPLAtomicAdd (&allocator->bytes, - (long) h->size);
+    allocator->free (allocator, h, sizeof (block_header) + h->size);
+  }
+}
+
+// -----------------------------------------------------------------------------
+long
+gxPLAllocatorLiveCount (const gxPLAllocator * allocator) {
+
+  return gxPLAtomicGet ( (allocator) ? &allocator->live : &heap.live);
+}
+
+// -----------------------------------------------------------------------------
+long
+gxPLAllocatorLiveBytes (const gxPLAllocator * allocator) {
+
+  return gxPLAtomicGet ( (allocator) ? &allocator->bytes : &heap.bytes);
+}
+
+/* ========================================================================== */
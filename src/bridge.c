@@ -17,6 +17,11 @@
 #define BROADCAST_KEY "broadcast"
 #define ALLOW_KEY     "allow"
 
+#ifndef DEFAULT_BRIDGE_POLL_SLICE
+// waiting period in ms of gxPLBridgePoll() without timeout and reactor
+#define DEFAULT_BRIDGE_POLL_SLICE 100
+#endif
+
 /* private functions ======================================================== */
 // -----------------------------------------------------------------------------
 static const void *
@@ -57,6 +62,33 @@ prvClientMatch (const void *key1, const void *key2) {
   return ret;
 }
 
+/* -----------------------------------------------------------------------------
+ * The timers of the clients belong to the outer application, this one is
+ * never replaced */
+static void
+prvClientDelete (void * elmt) {
+  gxPLBridgeClient * client = (gxPLBridgeClient *) elmt;
+
+  gxPLTimerStop (gxPLAppTimerWheel (client->bridge->out), &client->expiry);
+  free (client);
+}
+
+/* -----------------------------------------------------------------------------
+ * Track known inner xPL clients and determine when they have died and
+ * remove them from the list of local clients */
+static void
+prvClientTimeout (gxPLTimer * timer, void * udata) {
+  gxPLBridgeClient * client = (gxPLBridgeClient *) udata;
+  gxPLBridge * bridge = client->bridge;
+
+  PINFO ("Delete client %s.%s.%s after heartbeat timeout, "
+         "processing %d clients",
+         client->id.vendor, client->id.device, client->id.instance,
+         iVectorSize (&bridge->clients) - 1);
+  (void) iVectorRemove (&bridge->clients,
+                        iVectorFindFirstIndex (&bridge->clients, client));
+}
+
 // -----------------------------------------------------------------------------
 // Receive xPL messages from inside
 static void
@@ -64,19 +96,19 @@ prvHandleInnerMessage (gxPLApplication * app, gxPLMessage * message, void * udat
   gxPLBridge * bridge = (gxPLBridge *) udata;
   gxPLBridgeClient * client = NULL;
 
-  if ( (strcmp (gxPLMessageSchemaClassGet (message), "hbeat") == 0) ||
-       (strcmp (gxPLMessageSchemaClassGet (message), "config") == 0)) {
+  int class_token = gxPLMessageSchemaClassToken (message);
+
+  if ( (class_token == gxPLTokenHbeat) || (class_token == gxPLTokenConfig)) {
+    int type_token = gxPLMessageSchemaTypeToken (message);
     char * endptr;
-    long now;
     bool new_client = false;
 
     gxPLBridgeClient * src = calloc (1, sizeof (gxPLBridgeClient));
     assert (src);
 
-    now = gxPLTime();
     gxPLIdCopy (&src->id, gxPLMessageSourceIdGet (message));
 
-    if (strcmp (gxPLMessageSchemaTypeGet (message), "basic") == 0) {
+    if (type_token == gxPLTokenBasic) {
       int interval;
       const char * str_interval;
 
@@ -110,6 +142,8 @@ prvHandleInnerMessage (gxPLApplication * app, gxPLMessage * message, void * udat
 
         // New client
         client = src;
+        client->bridge = bridge;
+        gxPLTimerInit (&client->expiry, prvClientTimeout, client);
         new_client = true;
 
         // then adds to the list
@@ -125,9 +159,10 @@ prvHandleInnerMessage (gxPLApplication * app, gxPLMessage * message, void * udat
       }
 
       client->hbeat_period_max = interval * 60 * 2 + 60;
-      client->hbeat_last = now;
+      gxPLTimerStart (gxPLAppTimerWheel (bridge->out), &client->expiry,
+                      client->hbeat_period_max * 1000UL);
     }
-    else if (strcmp (gxPLMessageSchemaTypeGet (message), "end") == 0) {
+    else if (type_token == gxPLTokenEnd) {
       int c = iVectorFindFirstIndex (&bridge->clients, src);
 
       if (c >= 0) {
@@ -206,14 +241,34 @@ prvHandleOuterMessage (gxPLApplication * app, gxPLMessage * message, void * udat
         PINFO ("OUT --> IN  > %s.%s allowed to cross", s->class, s->type);
       }
 
-      for (int i = 0; i < iVectorSize (&bridge->clients); i++) {
+      int n = 0;
+      int size = iVectorSize (&bridge->clients);
+
+      if (size > bridge->dest_max) {
+
+        bridge->dest = realloc (bridge->dest, size * sizeof (gxPLIoAddr *));
+        assert (bridge->dest);
+        bridge->dest_max = size;
+      }
+
+      for (int i = 0; i < size; i++) {
 
         gxPLBridgeClient * client = pvVectorGet (&bridge->clients, i);
         if ( (gxPLIdCmp (&client->id, gxPLMessageTargetIdGet (message)) == 0) ||
              (allow >= 0)) {
 
-          PINFO ("OUT --> IN  > Deliver");
-          gxPLAppSendMessage (bridge->in, message, &client->addr);
+          bridge->dest[n++] = &client->addr;
+        }
+      }
+
+      if (n > 0) {
+        const char * str = gxPLMessageStringGet (message, &size);
+
+        // with a single operation of the io layer for all the clients
+        PINFO ("OUT --> IN  > Deliver to %d clients", n);
+        if (str) {
+
+          (void) gxPLAppSendRawMulti (bridge->in, str, size, bridge->dest, n);
         }
       }
     }
@@ -256,6 +311,28 @@ prvConfigChanged (gxPLDevice * device, void * udata) {
   prvSetConfig (udata);
 }
 
+/* -----------------------------------------------------------------------------
+ * Registers the inner and outer applications in a reactor if both io layers
+ * provide a file descriptor, otherwise they are polled one after the other */
+static void
+prvReactorSetup (gxPLBridge * bridge) {
+#ifdef __linux__
+
+  (void) gxPLReactorDelete (bridge->reactor);
+  bridge->reactor = gxPLReactorNew ();
+  if (bridge->reactor) {
+
+    if ( (gxPLReactorAdd (bridge->reactor, bridge->in) != 0) ||
+         (gxPLReactorAdd (bridge->reactor, bridge->out) != 0)) {
+
+      PDEBUG ("io layers can not be multiplexed, polled one after the other");
+      (void) gxPLReactorDelete (bridge->reactor);
+      bridge->reactor = NULL;
+    }
+  }
+#endif
+}
+
 /* public api functions ===================================================== */
 
 // -----------------------------------------------------------------------------
@@ -283,12 +360,12 @@ gxPLBridgeOpen (gxPLSetting * insetting, gxPLSetting * outsetting, uint8_t max_h
 
     if ( (bridge->in) && (bridge->out)) {
 
-      iVectorInit (&bridge->clients, 1, NULL, free);
+      iVectorInit (&bridge->clients, 1, NULL, prvClientDelete);
       iVectorInitSearch (&bridge->clients, prvClientKey, prvClientMatch);
       iVectorInit (&bridge->allow, 1, NULL, free);
       iVectorInitSearch (&bridge->allow, prvAllowKey, prvAllowMatch);
-      gxPLMessageListenerAdd (bridge->in, prvHandleInnerMessage, bridge);
-      gxPLMessageListenerAdd (bridge->out, prvHandleOuterMessage, bridge);
+      gxPLMessageListenerAddSync (bridge->in, prvHandleInnerMessage, bridge);
+      gxPLMessageListenerAddSync (bridge->out, prvHandleOuterMessage, bridge);
 
       if (max_hop == 0) {
 
@@ -299,6 +376,7 @@ gxPLBridgeOpen (gxPLSetting * insetting, gxPLSetting * outsetting, uint8_t max_h
         max_hop = 9;
       }
       bridge->max_hop = max_hop;
+      prvReactorSetup (bridge);
       return bridge;
     }
     free (bridge);
@@ -314,6 +392,11 @@ gxPLBridgeClose (gxPLBridge * bridge) {
   if (bridge) {
     int ret;
 
+#ifdef __linux__
+    (void) gxPLReactorDelete (bridge->reactor);
+#endif
+    // the timers of the clients belong to the outer application
+    vVectorDestroy (&bridge->clients);
     ret = gxPLAppClose (bridge->in);
     if (ret != 0) {
       PNOTICE ("Unable to close inner application");
@@ -323,7 +406,7 @@ gxPLBridgeClose (gxPLBridge * bridge) {
       PNOTICE ("Unable to close outer application");
     }
 
-    vVectorDestroy (&bridge->clients);
+    free (bridge->dest);
     free (bridge);
     return ret;
   }
@@ -354,7 +437,8 @@ gxPLBridgeSetNewInSetting (gxPLBridge * bridge, gxPLSetting * insetting) {
       gxPLBridgeClose (bridge);
       return -1;
     }
-    gxPLMessageListenerAdd (bridge->in, prvHandleInnerMessage, bridge);
+    gxPLMessageListenerAddSync (bridge->in, prvHandleInnerMessage, bridge);
+    prvReactorSetup (bridge);
   }
   return 0;
 }
@@ -364,46 +448,42 @@ int
 gxPLBridgePoll (gxPLBridge * bridge, int timeout_ms) {
   int ret = 0, i;
 
-  timeout_ms /= 2;
+#ifdef __linux__
+  if (bridge->reactor) {
 
-  if (timeout_ms < 1) {
-    timeout_ms = 1;
-  }
-
-  i = gxPLAppPoll (bridge->in, timeout_ms);
-  if (i != 0) {
+    // a single wait on both sides
+    if (gxPLReactorPoll (bridge->reactor, timeout_ms) < 0) {
 
-    ret = i;
-    PNOTICE ("Unable to poll inner application");
+      ret = -1;
+      PNOTICE ("Unable to poll applications");
+    }
   }
+  else
+#endif
+  {
+    if (timeout_ms < 0) {
 
-  i = gxPLAppPoll (bridge->out, timeout_ms);
-  if (i != 0) {
-
-    ret = i;
-    PNOTICE ("Unable to poll outer application");
-  }
-  bridge->timeout += timeout_ms;
+      // each side waits in turn, the other can not wake it up
+      timeout_ms = DEFAULT_BRIDGE_POLL_SLICE;
+    }
+    timeout_ms /= 2;
 
-  if (bridge->timeout >= 60000) { // every minute
-    long now;
+    if (timeout_ms < 1) {
+      timeout_ms = 1;
+    }
 
-    // Track known inner xPL clients and determine when they have died and
-    // remove them from the list of local clients
-    bridge->timeout = 0;
-    now = gxPLTime();
-    for (int i = 0; i < iVectorSize (&bridge->clients); i++) {
-      gxPLBridgeClient * client = pvVectorGet (&bridge->clients, i);
+    i = gxPLAppPoll (bridge->in, timeout_ms);
+    if (i != 0) {
 
-      if ( (now - client->hbeat_last) > client->hbeat_period_max) {
+      ret = i;
+      PNOTICE ("Unable to poll inner application");
+    }
 
-        PINFO ("Delete client %s.%s.%s after heartbeat timeout, "
-               "processing %d clients",
-               client->id.vendor, client->id.device, client->id.instance,
-               iVectorSize (&bridge->clients) - 1);
+    i = gxPLAppPoll (bridge->out, timeout_ms);
+    if (i != 0) {
 
-        iVectorRemove (&bridge->clients, i);
-      }
+      ret = i;
+      PNOTICE ("Unable to poll outer application");
     }
   }
   return ret;
@@ -10,6 +10,7 @@
 #define _GXPL_BRIDGE_PRIVATE_HEADER_
 
 #include <gxPL/defs.h>
+#include "internal_p.h"
 
 /* structures =============================================================== */
 
@@ -21,7 +22,8 @@ typedef struct _gxPLBridgeClient {
   gxPLIoAddr addr;
   gxPLId id;
   int hbeat_period_max; /**< (hbeat_interval * 2 + 60) */
-  long hbeat_last;
+  gxPLTimer expiry; /**< restarted on each heartbeat received */
+  struct _gxPLBridge * bridge;
 } gxPLBridgeClient;
 
 /**
@@ -33,7 +35,9 @@ typedef struct _gxPLBridge {
   gxPLDevice * device;
   xVector clients;
   xVector allow;
-  long timeout;
+  gxPLReactor * reactor; /* NULL if the io layers can not be multiplexed */
+  const gxPLIoAddr ** dest; /* addresses of the inside clients for the delivery */
+  int dest_max;
   uint8_t max_hop; /* only messages with a hop count less than or equal to max_hop cross the bridge */
 } gxPLBridge;
 
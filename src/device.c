@@ -14,14 +14,23 @@
 #include <gxPL.h>
 #include "device_p.h"
 
+/* constants ================================================================ */
+// listeners called by prvDeviceDispatchEvent()
+#define DISPATCH_SYNC 1 /* listeners of the library */
+#define DISPATCH_USER 2 /* listeners of the user, called by the workers if any */
+
 /* structures =============================================================== */
 typedef struct _listener_elmt {
   gxPLDeviceListener func;
   void * data;
   gxPLSchema schema;
   gxPLMessageType msg_type;
+  int issync; /* listener of the library, never called by a worker */
 } listener_elmt;
 
+/* private variables ======================================================== */
+static unsigned int device_seq; /* number of the devices created */
+
 /* private functions ======================================================== */
 // -----------------------------------------------------------------------------
 static const void *
@@ -131,13 +140,17 @@ prvHeartbeatMessageSendHello (gxPLDevice * device) {
     message = device->hbeat_msg;
   }
 
-  // Send the message
-  if (gxPLDeviceMessageSend (device, message) > 0) {
+  // Send the message, its text is formatted again only if it was modified
+  if (gxPLAppSendCachedMessage (device->parent, message, NULL) > 0) {
 
     // Update last heartbeat time
-    long now = gxPLTime();
-    PDEBUG ("Sent heartbeat message timestamp %s", gxPLTimeStr (now, NULL));
-    device->hbeat_last = now;
+#ifdef DEBUG
+    char str[16];
+
+    gxPLTimeToBuffer (gxPLTime(), NULL, str, sizeof (str));
+    PDEBUG ("Sent heartbeat message timestamp %s", str);
+#endif
+    device->hbeat_last = gxPLAppTimeMs (device->parent);
     return 0;
   }
   PERROR ("Unable to send heartbeat");
@@ -157,16 +170,97 @@ prvHeartbeatMessageSendGoodbye (gxPLDevice * device) {
 
     gxPLMessageDelete (device->hbeat_msg);
     device->hbeat_msg = NULL;
-    return 0;
+    ret = 0;
   }
   gxPLMessageDelete (message);
   return ret;
 }
 
+/* -----------------------------------------------------------------------------
+ * Returns the current heartbeat period of the device in seconds */
+static unsigned long
+prvHeartbeatPeriod (const gxPLDevice * device) {
+
+  if (device->ishubconfirmed == 0) {
+
+    // If we are still waiting to hear from the hub,
+    // then send a message every 3 seconds until we do
+    return DEFAULT_HUB_DISCOVERY_INTERVAL;
+  }
+
+  if (device->isconfigurable && !device->isconfigured) {
+
+    // If we are in configuration mode, we send out once a minute
+    return DEFAULT_CONFIG_HEARTBEAT_INTERVAL;
+  }
+
+  // For normal heartbeats, once each "hbeat_interval"
+  return device->hbeat_interval;
+}
+
+/* -----------------------------------------------------------------------------
+ * Schedules the next heartbeat one period after the last one sent */
+static void
+prvHeartbeatSchedule (gxPLDevice * device) {
+  long delay = prvHeartbeatPeriod (device) * 1000UL -
+               (gxPLAppTimeMs (device->parent) - device->hbeat_last);
+
+  gxPLTimerStart (gxPLAppTimerWheel (device->parent), &device->hbeat_timer,
+                  (delay > 0) ? delay : 0);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvHeartbeatTimeout (gxPLTimer * timer, void * udata) {
+  gxPLDevice * device = (gxPLDevice *) udata;
+
+  // an heartbeat may have been sent since the timer was started
+  if ( (gxPLAppTimeMs (device->parent) - device->hbeat_last) >=
+       prvHeartbeatPeriod (device) * 1000UL) {
+
+    if (prvHeartbeatMessageSendHello (device) != 0) {
+
+      // retry later
+      gxPLTimerStart (gxPLAppTimerWheel (device->parent), timer,
+                      DEFAULT_HUB_DISCOVERY_INTERVAL * 1000UL);
+      return;
+    }
+  }
+  prvHeartbeatSchedule (device);
+}
+
 // -----------------------------------------------------------------------------
-// Dispatch device messages to appropriate listeners
 static void
-prvDeviceDispatchEvent (gxPLDevice * device, gxPLMessage * message) {
+prvHeartbeatReplyTimeout (gxPLTimer * timer, void * udata) {
+  gxPLDevice * device = (gxPLDevice *) udata;
+
+  if (device->isenabled) {
+
+    PDEBUG ("Sending deferred heartbeat reply");
+    (void) prvHeartbeatMessageSendHello (device);
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Compares the tokens of the identifiers, or the identifiers themselves if
+ * the table of tokens was full when the device was created */
+static int
+prvDeviceIdIs (const gxPLDevice * device, int token, const gxPLId * id) {
+
+  if (device->id_token != GXPL_TOKEN_NONE) {
+
+    return token == device->id_token;
+  }
+  return gxPLIdCmp (id, &device->id) == 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Dispatch device messages to appropriate listeners, only the listeners
+ * selected by which are called, returns the number of the others that
+ * match the message */
+static int
+prvDeviceDispatchEvent (gxPLDevice * device, gxPLMessage * message, int which) {
+  int skipped = 0;
 
   for (int i = 0; i < iVectorSize (&device->listener); i++) {
 
@@ -193,10 +287,42 @@ prvDeviceDispatchEvent (gxPLDevice * device, gxPLMessage * message) {
     // the schema matches
     if (listener->func) {
 
+      if ( (which & (listener->issync ? DISPATCH_SYNC : DISPATCH_USER)) == 0) {
+
+        skipped++;
+        continue;
+      }
       // call the user listener
       listener->func (device, message, listener->data);
     }
   }
+  return skipped;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvListenerAdd (gxPLDevice * device, gxPLDeviceListener func,
+                gxPLMessageType type, char * schema_class, char * schema_type,
+                void * udata, int issync) {
+
+  listener_elmt * listener = calloc (1, sizeof (listener_elmt));
+  assert (listener);
+
+  listener->func = func;
+  listener->data = udata;
+  listener->msg_type = type;
+  listener->issync = issync;
+  gxPLSchemaClassSet (&listener->schema, schema_class);
+  gxPLSchemaTypeSet (&listener->schema, schema_type);
+
+  // the workers no longer read the vector
+  gxPLWorkersDrain (device->parent);
+  if (iVectorAppend (&device->listener, listener) == 0) {
+
+    return 0;
+  }
+  free (listener);
+  return -1;
 }
 
 /* private api functions ==================================================== */
@@ -217,7 +343,8 @@ gxPLDeviceMessageHandler (gxPLDevice * device, gxPLMessage * message,
   // and if so, dump it
   if (device->isreportownmsg == false) {
 
-    if (gxPLIdCmp (gxPLMessageSourceIdGet (message), &device->id) == 0) {
+    if (prvDeviceIdIs (device, gxPLMessageSourceToken (message),
+                       gxPLMessageSourceIdGet (message))) {
 
       PDEBUG ("Skipping message from self");
       return;
@@ -227,43 +354,38 @@ gxPLDeviceMessageHandler (gxPLDevice * device, gxPLMessage * message,
   // Is this a broadcast message?
   if (gxPLMessageIsBroadcast (message) == true) {
 
-    // See if this is a request for a heartbeat
-    if ( (gxPLMessageTypeGet (message) == gxPLMessageCommand)
-         && !strcasecmp (gxPLMessageSchemaClassGet (message), "hbeat")
-         && !strcasecmp (gxPLMessageSchemaTypeGet (message), "request")) {
+    // See if this is a request for a heartbeat, a disabled device does not
+    // answer
+    if ( (device->isenabled)
+         && (gxPLMessageTypeGet (message) == gxPLMessageCommand)
+         && gxPLTokenIs (gxPLMessageSchemaClassToken (message), gxPLTokenHbeat,
+                         gxPLMessageSchemaClassGet (message))
+         && gxPLTokenIs (gxPLMessageSchemaTypeToken (message), gxPLTokenRequest,
+                         gxPLMessageSchemaTypeGet (message))) {
 
       // Compute a response delay (.5 to 2.5 seconds)
       unsigned int ms = (unsigned int) ( ( (double) random() /
                                            (double) RAND_MAX) * 2000.0) + 500;
-      PDEBUG ("Sending heartbeat in response to discovery request "
-              "after a %u millisecond delay", ms);
-      gxPLTimeDelayMs (ms);
-      prvHeartbeatMessageSendHello (device);
+      if (!gxPLTimerIsPending (&device->hbeat_reply)) {
+
+        PDEBUG ("Sending heartbeat in response to discovery request "
+                "after a %u millisecond delay", ms);
+        gxPLTimerStart (gxPLAppTimerWheel (device->parent),
+                        &device->hbeat_reply, ms);
+      }
     }
 #if CONFIG_DEVICE_FILTER
 // -----------------------------------------------------------------------------
-    // If we have filters, see if they match // TODO
+    // If we have filters, see if they match, the message has been
+    // classified by the filter engine of the application
     if (device->havefilter) {
-      bool isfound = false;
-
-      // See if we have any groups and if any groups match
-      for (int i = 0; i < iVectorSize (&device->filter); i++) {
-
-        gxPLFilter * filter = (gxPLFilter *) pvVectorGet (&device->filter, i);
-
-        if (gxPLMessageFilterMatch (message, filter) == true) {
-
-          PDEBUG ("message matches my filters");
-          isfound = true;
-          break;
-        }
-      }
 
       // If we had filters and none match, skip this device
-      if (isfound == false) {
+      if (device->filter_match != gxPLAppFilterEngine (device->parent)->stamp) {
         PINFO ("skip message, does not match my filters");
         return;
       }
+      PDEBUG ("message matches my filters");
     }
 // -----------------------------------------------------------------------------
 #endif /* CONFIG_DEVICE_FILTER true */
@@ -275,7 +397,8 @@ gxPLDeviceMessageHandler (gxPLDevice * device, gxPLMessage * message,
 
     if (gxPLMessageIsGrouped (message) == false) {
       // Make sure this target matches
-      if (gxPLIdCmp (gxPLMessageTargetIdGet (message), &device->id) != 0) {
+      if (!prvDeviceIdIs (device, gxPLMessageTargetToken (message),
+                          gxPLMessageTargetIdGet (message))) {
 
         return;
       }
@@ -317,7 +440,34 @@ gxPLDeviceMessageHandler (gxPLDevice * device, gxPLMessage * message,
    * - targeted to this device
    * so dispatch it!
    */
-  prvDeviceDispatchEvent (device, message);
+  if (prvDeviceDispatchEvent (device, message, DISPATCH_SYNC) > 0) {
+
+    // the listeners of the user are called by the worker of the device
+    if (gxPLWorkersPost (device->parent, device->seq, device,
+                         NULL, NULL, message) != 0) {
+
+      (void) prvDeviceDispatchEvent (device, message, DISPATCH_USER);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLDeviceDispatchDeferred (gxPLDevice * device, gxPLMessage * message) {
+
+  (void) prvDeviceDispatchEvent (device, message, DISPATCH_USER);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLDeviceListenerAddSync (gxPLDevice * device,
+                           gxPLDeviceListener func,
+                           gxPLMessageType type,
+                           char * schema_class, char * schema_type,
+                           void * udata) {
+
+  return prvListenerAdd (device, func, type, schema_class, schema_type,
+                         udata, 1);
 }
 
 
@@ -331,7 +481,10 @@ gxPLDeviceNew (gxPLApplication * app,
   assert (device);
 
   device->parent = app;
+  device->seq = __atomic_add_fetch (&device_seq, 1, __ATOMIC_RELAXED);
   device->hbeat_interval = DEFAULT_HEARTBEAT_INTERVAL;
+  gxPLTimerInit (&device->hbeat_timer, prvHeartbeatTimeout, device);
+  gxPLTimerInit (&device->hbeat_reply, prvHeartbeatReplyTimeout, device);
 
   // init listener vector
   iVectorInit (&device->listener, 1, NULL, free);
@@ -369,6 +522,7 @@ gxPLDeviceNew (gxPLApplication * app,
     if (gxPLIdInstanceIdSet (&device->id, instance_id) == 0) {
 
       // setting up successful
+      device->id_token = gxPLTokenInternId (&device->id);
       return device;
     }
 
@@ -380,6 +534,7 @@ gxPLDeviceNew (gxPLApplication * app,
                               GXPL_INSTANCEID_MAX) == GXPL_INSTANCEID_MAX) {
 
       // setting up successful
+      device->id_token = gxPLTokenInternId (&device->id);
       return device;
     }
   }
@@ -393,9 +548,17 @@ void
 gxPLDeviceDelete (gxPLDevice * device) {
 
   if (device) {
+    gxPLTimerWheel * wheel = gxPLAppTimerWheel (device->parent);
+
+    // the workers no longer use the device
+    gxPLWorkersDrain (device->parent);
 
     // Disable any heartbeats
     gxPLDeviceEnable (device, false);
+    // the timers must not be run after the device is released, even if it
+    // was already disabled
+    gxPLTimerStop (wheel, &device->hbeat_timer);
+    gxPLTimerStop (wheel, &device->hbeat_reply);
 
     // Release heartbeat message, if any
     gxPLMessageDelete (device->hbeat_msg);
@@ -431,7 +594,7 @@ gxPLMessage *
 gxPLDeviceMessageNew (gxPLDevice * device, gxPLMessageType type) {
 
   if (type != gxPLMessageAny) {
-    gxPLMessage * message = gxPLMessageNew (type);
+    gxPLMessage * message = gxPLMessageAllocNew (gxPLAppAllocator (device->parent), type);
     assert (message);
 
     gxPLMessageSourceIdSet (message, &device->id);
@@ -467,20 +630,8 @@ gxPLDeviceListenerAdd (gxPLDevice * device,
                        char * schema_class, char * schema_type,
                        void * udata) {
 
-  listener_elmt * listener = calloc (1, sizeof (listener_elmt));
-  assert (listener);
-
-  listener->func = func;
-  listener->data = udata;
-  listener->msg_type = type;
-  gxPLSchemaClassSet (&listener->schema, schema_class);
-  gxPLSchemaTypeSet (&listener->schema, schema_type);
-  if (iVectorAppend (&device->listener, listener) == 0) {
-
-    return 0;
-  }
-  free (listener);
-  return -1;
+  return prvListenerAdd (device, func, type, schema_class, schema_type,
+                         udata, 0);
 }
 
 // -----------------------------------------------------------------------------
@@ -489,6 +640,8 @@ gxPLDeviceListenerRemove (gxPLDevice * device,
                           gxPLDeviceListener listener) {
 
   int i = iVectorFindFirstIndex (&device->listener, &listener);
+
+  gxPLWorkersDrain (device->parent);
   return iVectorRemove (&device->listener, i);
 }
 
@@ -497,6 +650,7 @@ int
 gxPLDeviceIdSet (gxPLDevice * device,  const gxPLId * id) {
 
   if (gxPLIdCmp (id, &device->id) != 0) {
+    gxPLId old_id;
 
     if (device->isenabled) {
 
@@ -506,7 +660,12 @@ gxPLDeviceIdSet (gxPLDevice * device,  const gxPLId * id) {
       }
     }
 
+    // the identifier is the key of the worker of the device
+    gxPLWorkersDrain (device->parent);
+    gxPLIdCopy (&old_id, &device->id);
     gxPLIdCopy (&device->id, id);
+    device->id_token = gxPLTokenInternId (&device->id);
+    gxPLAppDeviceIdChanged (device->parent, device, &old_id);
 
     if (device->isenabled) {
 
@@ -591,6 +750,9 @@ gxPLDeviceEnable (gxPLDevice * device, bool enabled) {
     // Handle enabling a disabled device
     if (device->isenabled) {
 
+      // called outside of the poll, the time of the application can be late
+      (void) gxPLTimerWheelUpdate (gxPLAppTimerWheel (device->parent));
+
       // If there is an existing heartbeat, release it and rebuild it
       if (device->hbeat_msg != NULL) {
 
@@ -599,11 +761,16 @@ gxPLDeviceEnable (gxPLDevice * device, bool enabled) {
       }
 
       // Start sending heartbeats
-      return prvHeartbeatMessageSendHello (device);
+      int ret = prvHeartbeatMessageSendHello (device);
+      prvHeartbeatSchedule (device);
+      return ret;
     }
     else {
+      gxPLTimerWheel * wheel = gxPLAppTimerWheel (device->parent);
 
-      // Send goodby heartbeat
+      // Stop the heartbeats then send goodby heartbeat
+      gxPLTimerStop (wheel, &device->hbeat_timer);
+      gxPLTimerStop (wheel, &device->hbeat_reply);
       return prvHeartbeatMessageSendGoodbye (device);
     }
   }
@@ -616,6 +783,12 @@ int
 gxPLDeviceHeartbeatIntervalSet (gxPLDevice * device, int interval) {
 
   device->hbeat_interval = interval;
+  if (device->isenabled) {
+
+    (void) gxPLTimerWheelUpdate (gxPLAppTimerWheel (device->parent));
+
+    prvHeartbeatSchedule (device);
+  }
   return 0;
 }
 
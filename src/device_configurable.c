@@ -241,8 +241,8 @@ prvConfigNew (gxPLDevice * device, xVector * config) {
 
 // -----------------------------------------------------------------------------
 static void
-prvConfigSet (gxPLDevice * device, xVector * config, int index) {
-  char * new_instance = NULL;
+prvConfigSet (gxPLDevice * device, const xVector * config, int index) {
+  const char * new_instance = NULL;
   int new_interval = -1;
   bool restart_needed = false;
   bool was_enabled = device->isenabled;
@@ -251,7 +251,7 @@ prvConfigSet (gxPLDevice * device, xVector * config, int index) {
   PDEBUG ("Parse to set config at index = % d", index);
   for (int i = index; i < iVectorSize (config); i++) {
 
-    gxPLPair * p = pvVectorGet (config, i);
+    const gxPLPair * p = pvVectorGet (config, i);
 
     // Check for instance change
     if (strcmp (p->name, "newconf") == 0) {
@@ -287,7 +287,14 @@ prvConfigSet (gxPLDevice * device, xVector * config, int index) {
     // Check for filters
     else if (strcmp (p->name, "filter") == 0) {
 
-      gxPLDeviceFilterAddFromStr (device, p->value);
+      // the filter is split in place, the message is not modified
+      char * filter = strdup (p->value);
+
+      if (filter) {
+
+        gxPLDeviceFilterAddFromStr (device, filter);
+        free (filter);
+      }
     }
 #endif  /* CONFIG_DEVICE_FILTER set */
     // Anything else had better be a configurable
@@ -345,12 +352,13 @@ prvConfigSet (gxPLDevice * device, xVector * config, int index) {
 // Handle configuration messages -> schema.class = config
 static void
 prvConfigHandler (gxPLDevice * device, gxPLMessage * message, void * udata) {
+  int type_token = gxPLMessageSchemaTypeToken (message);
   const char * schema_type = gxPLMessageSchemaTypeGet (message);
   const char * cmd = gxPLMessagePairGet (message, "command");
 
   // See if this is a request for a list of configurable elements
   if (gxPLMessageTypeGet (message) == gxPLMessageCommand) {
-    if (strcasecmp (schema_type, "response") == 0) {
+    if (gxPLTokenIs (type_token, gxPLTokenResponse, schema_type)) {
 
       gxPLDeviceConfigItemClearAll (device);
       
@@ -362,19 +370,19 @@ prvConfigHandler (gxPLDevice * device, gxPLMessage * message, void * udata) {
       gxPLDeviceGroupClearAll (device);
 #endif  /* CONFIG_DEVICE_GROUP set */
 
-      prvConfigSet (device, gxPLMessageBodyGet (message), 0);
+      prvConfigSet (device, gxPLMessageBodyGetConst (message), 0);
     }
     else {
 
       if (cmd != NULL) {
 
-        if ( (strcasecmp (schema_type, "list") == 0) &&
-             (strcasecmp (cmd, "request") == 0)) {
+        if (gxPLTokenIs (type_token, gxPLTokenList, schema_type) &&
+            (strcasecmp (cmd, "request") == 0)) {
 
           prvSendConfigList (device);
         }
-        else if ( (strcasecmp (schema_type, "current") == 0) &&
-                  (strcasecmp (cmd, "request") == 0)) {
+        else if (gxPLTokenIs (type_token, gxPLTokenCurrent, schema_type) &&
+                 (strcasecmp (cmd, "request") == 0)) {
 
           prvDeviceConfigSendCurrent (device);
         }
@@ -417,8 +425,8 @@ gxPLDeviceConfigNew (gxPLApplication * app, const char * vendor_id,
   if (ret == 0) {
 
     // Install a configuration listener for this device
-    if (gxPLDeviceListenerAdd (device, prvConfigHandler, gxPLMessageAny,
-                               "config", NULL, NULL) == 0) {
+    if (gxPLDeviceListenerAddSync (device, prvConfigHandler, gxPLMessageAny,
+                                   "config", NULL, NULL) == 0) {
 
       // If there is a config file, attempt to load it
       if (device->config->filename != NULL) {
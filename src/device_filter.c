@@ -15,6 +15,41 @@
 #include <gxPL.h>
 #include "device_p.h"
 
+/* private functions ======================================================== */
+
+/* -----------------------------------------------------------------------------
+ * Compiles a filter in the engine of the application and adds it to the
+ * device, the rule is released if an error occurs */
+static int
+prvFilterAppend (gxPLDevice * device, gxPLFilterRule * rule) {
+  gxPLFilterEngine * engine = gxPLAppFilterEngine (device->parent);
+
+  if (gxPLFilterRuleAdd (engine, rule, &device->filter_match) == 0) {
+
+    if (iVectorAppend (&device->filter, rule) == 0) {
+
+      device->havefilter = 1;
+      return 0;
+    }
+    gxPLFilterRuleRemove (engine, rule);
+  }
+  PERROR ("Unable to compile the filter");
+  free (rule);
+  return -1;
+}
+
+/* -----------------------------------------------------------------------------
+ * Removes the filters of the device from the engine of the application */
+static void
+prvFilterRemoveAll (gxPLDevice * device) {
+  gxPLFilterEngine * engine = gxPLAppFilterEngine (device->parent);
+
+  for (int i = 0; i < iVectorSize (&device->filter); i++) {
+
+    gxPLFilterRuleRemove (engine, pvVectorGet (&device->filter, i));
+  }
+}
+
 /* internal public functions ================================================ */
 
 // -----------------------------------------------------------------------------
@@ -29,6 +64,7 @@ gxPLDeviceFilterInit (gxPLDevice * device) {
 void
 gxPLDeviceFilterDelete (gxPLDevice * device) {
 
+  prvFilterRemoveAll (device);
   device->havefilter = 0;
   vVectorDestroy (&device->filter);
 }
@@ -42,17 +78,29 @@ gxPLDeviceFilterAddListOfItems (gxPLDevice * device, gxPLMessage * message) {
 
 // -----------------------------------------------------------------------------
 const char * gxPLDeviceFilterToString (const gxPLFilter * filter) {
-  static char buf[62];
-  snprintf (buf, sizeof (buf), "%s.%s.%s.%s.%s.%s",
-            gxPLMessageTypeToString (filter->type),
-            filter->source.vendor,
-            filter->source.device,
-            filter->source.instance,
-            filter->schema.class,
-            filter->schema.type
-           );
+  static char buf[GXPL_FILTER_STR_MAX];
+
+  (void) gxPLDeviceFilterToBuffer (filter, buf, sizeof (buf));
   return buf;
+}
 
+// -----------------------------------------------------------------------------
+int
+gxPLDeviceFilterToBuffer (const gxPLFilter * filter, char * buf, int len) {
+  int count = snprintf (buf, len, "%s.%s.%s.%s.%s.%s",
+                        gxPLMessageTypeToString (filter->type),
+                        filter->source.vendor,
+                        filter->source.device,
+                        filter->source.instance,
+                        filter->schema.class,
+                        filter->schema.type
+                       );
+  if (count >= len) {
+
+    errno = ENOBUFS;
+    return -1;
+  }
+  return count;
 }
 // -----------------------------------------------------------------------------
 int
@@ -63,7 +111,10 @@ gxPLDeviceFilterAddCurrentValues (gxPLDevice * device, gxPLMessage * message) {
     for (int i = 0; i < iVectorSize (&device->filter); i++) {
 
       gxPLFilter * filter = pvVectorGet (&device->filter, i);
-      gxPLMessagePairAdd (message, "filter", gxPLDeviceFilterToString (filter));
+      char str[GXPL_FILTER_STR_MAX];
+
+      gxPLDeviceFilterToBuffer (filter, str, sizeof (str));
+      gxPLMessagePairAdd (message, "filter", str);
     }
   }
   else {
@@ -80,19 +131,13 @@ gxPLDeviceFilterAdd (gxPLDevice * device, gxPLMessageType type,
                      const gxPLId * source, const gxPLSchema * schema) {
 
   if (iVectorSize (&device->filter) < device->filter_max) {
-    int ret;
-
-    gxPLFilter * filter = malloc (sizeof (gxPLFilter));
-    assert (filter);
-    filter->type = type;
-    gxPLIdCopy (&filter->source, source);
-    gxPLSchemaCopy (&filter->schema, schema);
-    ret = iVectorAppend (&device->filter, filter);
-    if ( (ret == 0) && (iVectorSize (&device->filter) > 0)) {
 
-      device->havefilter = 1;
-    }
-    return ret;
+    gxPLFilterRule * rule = malloc (sizeof (gxPLFilterRule));
+    assert (rule);
+    rule->filter.type = type;
+    gxPLIdCopy (&rule->filter.source, source);
+    gxPLSchemaCopy (&rule->filter.schema, schema);
+    return prvFilterAppend (device, rule);
   }
   PERROR ("Unable to add a new filter, overflow !");
   return -1;
@@ -139,19 +184,15 @@ gxPLDeviceFilterAddFromStr (gxPLDevice * device, char * str) {
 
         type = gxPLMessageTypeFromString (stype);
         if (type != gxPLMessageUnknown) {
-          gxPLFilter * filter = malloc (sizeof (gxPLFilter));
-          assert (filter);
+          gxPLFilterRule * rule = malloc (sizeof (gxPLFilterRule));
+          assert (rule);
+          gxPLFilter * filter = &rule->filter;
 
           filter->type = type;
           if (gxPLIdSet (&filter->source, id_vendor, id_device, id_instance) == 0) {
             if (gxPLSchemaSet (&filter->schema, schema_class, schema_type) == 0) {
 
-              int ret = iVectorAppend (&device->filter, filter);
-              if ( (ret == 0) && (iVectorSize (&device->filter) > 0)) {
-
-                device->havefilter = 1;
-              }
-              return ret;
+              return prvFilterAppend (device, rule);
             }
             else {
 
@@ -162,7 +203,7 @@ gxPLDeviceFilterAddFromStr (gxPLDevice * device, char * str) {
 
             PERROR ("Unable to set id filter");
           }
-          free (filter);
+          free (rule);
         }
       }
       else {
@@ -193,6 +234,7 @@ gxPLDeviceFilterHave (const gxPLDevice * device) {
 int
 gxPLDeviceFilterClearAll (gxPLDevice * device) {
 
+  prvFilterRemoveAll (device);
   device->havefilter = 0;
   return iVectorClear (&device->filter);
 }
@@ -13,6 +13,39 @@
 #include <string.h>
 #include <gxPL.h>
 #include "device_p.h"
+#include "internal_p.h"
+
+/* private functions ======================================================== */
+
+/* -----------------------------------------------------------------------------
+ * Adds a group to the device and to the routing table of its application */
+static int
+prvGroupAppend (gxPLDevice * device, const char * name) {
+  int ret;
+
+  PDEBUG ("  Set new group %s", name);
+  char * new_group = malloc (strlen (name) + 1);
+  assert (new_group);
+  strcpy (new_group, name);
+  ret = iVectorAppend (&device->group, new_group);
+  if ( (ret == 0) && (iVectorSize (&device->group) > 0)) {
+    device->havegroup = 1;
+    ret = gxPLAppGroupJoin (device->parent, device, name);
+  }
+  return ret;
+}
+
+/* -----------------------------------------------------------------------------
+ * Removes the device from the routing table of its application */
+static void
+prvGroupLeaveAll (gxPLDevice * device) {
+
+  for (int i = 0; i < iVectorSize (&device->group); i++) {
+
+    gxPLAppGroupLeave (device->parent, device,
+                       (const char *) pvVectorGet (&device->group, i));
+  }
+}
 
 /* internal public functions ================================================ */
 // -----------------------------------------------------------------------------
@@ -27,6 +60,7 @@ gxPLDeviceGroupInit (gxPLDevice * device) {
 void
 gxPLDeviceGroupDelete (gxPLDevice * device) {
 
+  prvGroupLeaveAll (device);
   device->havegroup = 0;
   vVectorDestroy (&device->group);
 }
@@ -65,16 +99,8 @@ gxPLDeviceGroupAdd (gxPLDevice * device, const char * group_name) {
   if (group_name) {
     if (strlen (group_name) > 0) {
       if (iVectorSize (&device->group) < device->group_max) {
-        int ret;
-        PDEBUG ("  Set new group %s", group_name);
-        char * new_group = malloc (strlen (group_name) + 1);
-        assert (new_group);
-        strcpy (new_group, group_name);
-        ret = iVectorAppend (&device->group, new_group);
-        if ( (ret == 0) && (iVectorSize (&device->group) > 0)) {
-          device->havegroup = 1;
-        }
-        return ret;
+
+        return prvGroupAppend (device, group_name);
       }
     }
     else {
@@ -103,17 +129,8 @@ gxPLDeviceGroupAddFromString (gxPLDevice * device, const char * str) {
       if (iVectorSize (&device->group) < device->group_max) {
         const char * name = &str[name_index];
         if (strlen (name) > 0) {
-          int ret;
-
-          PDEBUG ("  Set new group %s", name);
-          char * new_group = malloc (strlen (name) + 1);
-          assert (new_group);
-          strcpy (new_group, name);
-          ret = iVectorAppend (&device->group, new_group);
-          if ( (ret == 0) && (iVectorSize (&device->group) > 0)) {
-            device->havegroup = 1;
-          }
-          return ret;
+
+          return prvGroupAppend (device, name);
         }
         return 0;
       }
@@ -142,6 +159,7 @@ gxPLDeviceGroupHave (const gxPLDevice * device) {
 int
 gxPLDeviceGroupClearAll (gxPLDevice * device) {
 
+  prvGroupLeaveAll (device);
   device->havegroup = 0;
   return iVectorClear (&device->group);
 }
@@ -32,13 +32,17 @@ struct _gxPLDeviceConfig {
 struct _gxPLDevice {
   
   gxPLId id;
+  int id_token; /**< interned identifier, compared to the messages tokens */
+  unsigned int seq; /**< number of the device, key of its worker */
   char * version;
   gxPLApplication * parent;
   xVector listener; /**< vector of listener_elmt (message received) */
   
   int hbeat_interval; /**< heartbeat interval in seconds */
-  long hbeat_last;
+  unsigned long hbeat_last; /**< monotonic time in ms of the last heartbeat */
   gxPLMessage * hbeat_msg;
+  gxPLTimer hbeat_timer; /**< next periodic heartbeat */
+  gxPLTimer hbeat_reply; /**< deferred response to a heartbeat request */
     
   // Optionnal fields
 #if CONFIG_DEVICE_CONFIGURABLE
@@ -51,8 +55,9 @@ struct _gxPLDevice {
 #endif /* CONFIG_DEVICE_GROUP true */
 
 #if CONFIG_DEVICE_FILTER
-  xVector filter;  /**< vector of gxPLFilter* */
+  xVector filter;  /**< vector of gxPLFilterRule* */
   uint8_t filter_max;
+  unsigned long filter_match; /**< stamp of the last message matched */
 #endif /* CONFIG_DEVICE_FILTER true */
 
   union {
@@ -0,0 +1,317 @@
+/**
+ * @file
+ * Directory of the devices alive on the network (source code)
+ *
+ * The devices are indexed by identifier in a hash table and kept in an array
+ * to be read by index, the last device takes the place of a removed one.
+ * Each device has a timer on the wheel of the application, restarted by its
+ * heartbeats.
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL.h>
+#include "gxpl_p.h"
+
+/* constants ================================================================ */
+#ifndef DEFAULT_DIRECTORY_HASH_SIZE
+#define DEFAULT_DIRECTORY_HASH_SIZE 16
+#endif
+
+/* structures =============================================================== */
+typedef struct _directory_elmt {
+  gxPLHashNode node;            /* indexed by the identifier */
+  gxPLDirectoryEntry entry;
+  gxPLTimer expiry;             /* restarted on each heartbeat received */
+  struct _gxPLDirectory * dir;
+  int index;                    /* position in the array */
+} directory_elmt;
+
+struct _gxPLDirectory {
+  gxPLApplication * app;
+  gxPLHash index;
+  directory_elmt ** elmt;
+  int count;
+  int max;
+  gxPLDirectoryListener func;
+  void * udata;
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static int
+prvMatch (const gxPLHashNode * node, const void * key) {
+  const directory_elmt * e = gxPLHashEntry (node, directory_elmt, node);
+
+  return gxPLIdCmp (&e->entry.id, (const gxPLId *) key);
+}
+
+// -----------------------------------------------------------------------------
+static directory_elmt *
+prvFind (const gxPLDirectory * dir, const gxPLId * id, unsigned long hash) {
+  gxPLHashNode * node = gxPLHashFind (&dir->index, hash, id, prvMatch);
+
+  return (node) ? gxPLHashEntry (node, directory_elmt, node) : NULL;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvNotify (gxPLDirectory * dir, directory_elmt * e, gxPLDirectoryEvent event) {
+
+  if (dir->func) {
+
+    dir->func (dir->app, &e->entry, event, dir->udata);
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Removes a device from the directory, the listener is called before it is
+ * released */
+static void
+prvRemove (gxPLDirectory * dir, directory_elmt * e, gxPLDirectoryEvent event) {
+
+  gxPLTimerStop (gxPLAppTimerWheel (dir->app), &e->expiry);
+  (void) gxPLHashRemove (&dir->index, &e->node);
+  dir->elmt[e->index] = dir->elmt[--dir->count];
+  dir->elmt[e->index]->index = e->index;
+  prvNotify (dir, e, event);
+  free (e);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvExpiry (gxPLTimer * timer, void * udata) {
+  directory_elmt * e = (directory_elmt *) udata;
+
+  prvRemove (e->dir, e, gxPLDirectoryExpired);
+}
+
+/* -----------------------------------------------------------------------------
+ * Copies the value of a pair of the message, returns true if the value has
+ * changed */
+static int
+prvPairCopy (const gxPLMessage * msg, const char * name, char * value,
+             int size) {
+  char old[GXPL_NETADDR_STR_MAX];
+  const char * str = gxPLMessagePairGet (msg, name);
+
+  strcpy (old, value);
+  value[0] = '\0';
+  if (str) {
+
+    strncpy (value, str, size - 1);
+    value[size - 1] = '\0';
+  }
+  return strcmp (old, value) != 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Adds or updates a device from its heartbeat */
+static void
+prvUpdate (gxPLDirectory * dir, const gxPLMessage * msg, int isconfig) {
+  const gxPLId * id = gxPLMessageSourceIdGet (msg);
+  const char * str = gxPLMessagePairGet (msg, "interval");
+  unsigned long hash = gxPLHashId (id);
+  gxPLDirectoryEvent event = gxPLDirectoryAdded;
+  directory_elmt * e;
+  int interval, ischanged = 0;
+  char * endptr;
+
+  if (str == NULL) {
+
+    PDEBUG ("heartbeat without interval - ignored");
+    return;
+  }
+  interval = strtol (str, &endptr, 10);
+  if ( (*endptr != '\0') || (interval < 0)) {
+
+    PDEBUG ("heartbeat with invalid interval %s - ignored", str);
+    return;
+  }
+
+  e = prvFind (dir, id, hash);
+  if (e) {
+
+    event = gxPLDirectoryChanged;
+    ischanged = (e->entry.interval != interval) ||
+                (e->entry.isconfig != isconfig);
+  }
+  else {
+
+    if (dir->count == dir->max) {
+      int max = (dir->max) ? dir->max * 2 : DEFAULT_DIRECTORY_HASH_SIZE;
+      directory_elmt ** p = realloc (dir->elmt, max * sizeof (directory_elmt *));
+
+      if (p == NULL) {
+
+        return;
+      }
+      dir->elmt = p;
+      dir->max = max;
+    }
+
+    e = calloc (1, sizeof (directory_elmt));
+    if (e == NULL) {
+
+      return;
+    }
+    gxPLIdCopy (&e->entry.id, id);
+    e->dir = dir;
+    gxPLTimerInit (&e->expiry, prvExpiry, e);
+    gxPLHashAdd (&dir->index, &e->node, hash);
+    e->index = dir->count++;
+    dir->elmt[e->index] = e;
+    ischanged = 1;
+  }
+
+  e->entry.interval = interval;
+  e->entry.isconfig = isconfig;
+  e->entry.last_seen = gxPLAppTimeMs (dir->app);
+  ischanged |= prvPairCopy (msg, "version", e->entry.version,
+                            sizeof (e->entry.version));
+  if (gxPLMessagePairGet (msg, "remote-addr")) {
+
+    // hbeat.basic extension
+    ischanged |= prvPairCopy (msg, "remote-addr", e->entry.addr,
+                              sizeof (e->entry.addr));
+  }
+  else {
+
+    ischanged |= prvPairCopy (msg, "remote-ip", e->entry.addr,
+                              sizeof (e->entry.addr));
+  }
+  str = gxPLMessagePairGet (msg, "port");
+  if ( (str ? atoi (str) : 0) != e->entry.port) {
+
+    e->entry.port = str ? atoi (str) : 0;
+    ischanged = 1;
+  }
+
+  // considered gone after twice its interval plus one minute
+  gxPLTimerStart (gxPLAppTimerWheel (dir->app), &e->expiry,
+                  (interval * 120UL + 60UL) * 1000UL);
+
+  if (ischanged) {
+
+    prvNotify (dir, e, event);
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvHeartbeatListener (gxPLApplication * app, gxPLMessage * msg, void * udata) {
+  gxPLDirectory * dir = (gxPLDirectory *) udata;
+  int class_token = gxPLMessageSchemaClassToken (msg);
+
+  if ( ( (class_token == gxPLTokenHbeat) || (class_token == gxPLTokenConfig)) &&
+       (gxPLMessageTypeGet (msg) != gxPLMessageCommand)) {
+    int type_token = gxPLMessageSchemaTypeToken (msg);
+
+    if ( (type_token == gxPLTokenApp) || (type_token == gxPLTokenBasic)) {
+
+      prvUpdate (dir, msg, class_token == gxPLTokenConfig);
+    }
+    else if (type_token == gxPLTokenEnd) {
+      const gxPLId * id = gxPLMessageSourceIdGet (msg);
+      directory_elmt * e = prvFind (dir, id, gxPLHashId (id));
+
+      if (e) {
+
+        prvRemove (dir, e, gxPLDirectoryRemoved);
+      }
+    }
+  }
+}
+
+/* api functions ============================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppDirectoryOpen (gxPLApplication * app, gxPLDirectoryListener listener,
+                      void * udata) {
+  gxPLDirectory * dir;
+
+  if (app->directory) {
+
+    errno = EBUSY;
+    return -1;
+  }
+
+  dir = calloc (1, sizeof (gxPLDirectory));
+  if (dir == NULL) {
+
+    return -1;
+  }
+  dir->app = app;
+  dir->func = listener;
+  dir->udata = udata;
+
+  if (gxPLHashInit (&dir->index, DEFAULT_DIRECTORY_HASH_SIZE) == 0) {
+
+    if (gxPLMessageListenerAddSync (app, prvHeartbeatListener, dir) == 0) {
+
+      app->directory = dir;
+      return 0;
+    }
+    gxPLHashDestroy (&dir->index);
+  }
+  free (dir);
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppDirectoryClose (gxPLApplication * app) {
+  gxPLDirectory * dir = app->directory;
+
+  if (dir) {
+
+    (void) gxPLMessageListenerRemove (app, prvHeartbeatListener);
+    for (int i = 0; i < dir->count; i++) {
+
+      gxPLTimerStop (gxPLAppTimerWheel (app), &dir->elmt[i]->expiry);
+      free (dir->elmt[i]);
+    }
+    free (dir->elmt);
+    gxPLHashDestroy (&dir->index);
+    free (dir);
+    app->directory = NULL;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppDirectoryCount (const gxPLApplication * app) {
+
+  return (app->directory) ? app->directory->count : 0;
+}
+
+// -----------------------------------------------------------------------------
+const gxPLDirectoryEntry *
+gxPLAppDirectoryAt (const gxPLApplication * app, int index) {
+  const gxPLDirectory * dir = app->directory;
+
+  if ( (dir) && (index >= 0) && (index < dir->count)) {
+
+    return &dir->elmt[index]->entry;
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+const gxPLDirectoryEntry *
+gxPLAppDirectoryFind (const gxPLApplication * app, const gxPLId * id) {
+  const gxPLDirectory * dir = app->directory;
+  directory_elmt * e = (dir) ? prvFind (dir, id, gxPLHashId (id)) : NULL;
+
+  return (e) ? &e->entry : NULL;
+}
+
+/* ========================================================================== */
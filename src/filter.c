@@ -0,0 +1,215 @@
+/**
+ * @file
+ * Compiled message filters
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL/message.h>
+#include "internal_p.h"
+
+/* macros =================================================================== */
+#define WILD(field) (1 << (field))
+
+/* private functions ======================================================== */
+
+/* -----------------------------------------------------------------------------
+ * Sets the token of a field, its wildcard bit or its literal bit if the
+ * string can not be interned */
+static void
+prvFieldCompile (gxPLFilterRule * rule, gxPLFilterField field, const char * str) {
+
+  rule->str[field] = str;
+  if (strcmp (str, "*") == 0) {
+
+    rule->wild |= WILD (field);
+    rule->token[field] = GXPL_TOKEN_NONE;
+    return;
+  }
+  rule->token[field] = gxPLTokenIntern (str);
+  if (rule->token[field] == GXPL_TOKEN_NONE) {
+
+    rule->literal |= WILD (field);
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the list of the rules of a schema class */
+static gxPLFilterRule **
+prvList (gxPLFilterEngine * engine, const gxPLFilterRule * rule) {
+
+  return &engine->rule[ ( (rule->wild | rule->literal) & WILD (gxPLFilterClass)) ?
+                        0 : rule->token[gxPLFilterClass]];
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvRuleMatch (const gxPLFilterRule * rule, gxPLMessageType type,
+              const int * token, const char * const * str) {
+
+  if ( (rule->filter.type != gxPLMessageAny) && (rule->filter.type != type)) {
+
+    return false;
+  }
+
+  for (int f = 0; f < gxPLFilterFields; f++) {
+
+    if (rule->wild & WILD (f)) {
+
+      continue;
+    }
+    if (rule->literal & WILD (f)) {
+
+      if (strcmp (rule->str[f], str[f]) != 0) {
+
+        return false;
+      }
+    }
+    else if (rule->token[f] != token[f]) {
+
+      return false;
+    }
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvListClassify (gxPLFilterRule * rule, gxPLMessageType type,
+                 const int * token, const char * const * str,
+                 unsigned long stamp) {
+
+  for (; rule; rule = rule->next) {
+
+    if (prvRuleMatch (rule, type, token, str)) {
+
+      *rule->mark = stamp;
+    }
+  }
+}
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+void
+gxPLFilterEngineInit (gxPLFilterEngine * engine) {
+
+  memset (engine, 0, sizeof (gxPLFilterEngine));
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLFilterEngineDestroy (gxPLFilterEngine * engine) {
+
+  free (engine->rule);
+  memset (engine, 0, sizeof (gxPLFilterEngine));
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLFilterRuleAdd (gxPLFilterEngine * engine, gxPLFilterRule * rule,
+                   unsigned long * mark) {
+  gxPLFilterRule ** head;
+  const gxPLFilter * f = &rule->filter;
+
+  rule->wild = 0;
+  rule->literal = 0;
+  prvFieldCompile (rule, gxPLFilterVendor, f->source.vendor);
+  prvFieldCompile (rule, gxPLFilterDevice, f->source.device);
+  prvFieldCompile (rule, gxPLFilterInstance, f->source.instance);
+  prvFieldCompile (rule, gxPLFilterClass, f->schema.class);
+  prvFieldCompile (rule, gxPLFilterType, f->schema.type);
+
+  if (rule->token[gxPLFilterClass] >= engine->size) {
+    int size = rule->token[gxPLFilterClass] + 1;
+    gxPLFilterRule ** list = realloc (engine->rule, size * sizeof (gxPLFilterRule *));
+
+    if (list == NULL) {
+
+      return -1;
+    }
+    memset (&list[engine->size], 0,
+            (size - engine->size) * sizeof (gxPLFilterRule *));
+    engine->rule = list;
+    engine->size = size;
+  }
+
+  head = prvList (engine, rule);
+  rule->mark = mark;
+  rule->next = *head;
+  *head = rule;
+  engine->count++;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLFilterRuleRemove (gxPLFilterEngine * engine, gxPLFilterRule * rule) {
+
+  if (engine->rule) {
+    gxPLFilterRule ** p = prvList (engine, rule);
+
+    while (*p) {
+
+      if (*p == rule) {
+
+        *p = rule->next;
+        rule->next = NULL;
+        engine->count--;
+        return;
+      }
+      p = & (*p)->next;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+unsigned long
+gxPLFilterEngineClassify (gxPLFilterEngine * engine,
+                          const gxPLMessage * message) {
+  int token[gxPLFilterFields];
+  const char * str[gxPLFilterFields];
+  gxPLFilterRule * list = NULL;
+  const gxPLId * source;
+
+  engine->stamp++;
+  if (engine->count == 0) {
+
+    return engine->stamp;
+  }
+
+  // the tokens of the schema are computed when the message is decoded
+  token[gxPLFilterClass] = gxPLMessageSchemaClassToken (message);
+  if ( (token[gxPLFilterClass] != GXPL_TOKEN_NONE) &&
+       (token[gxPLFilterClass] < engine->size)) {
+
+    list = engine->rule[token[gxPLFilterClass]];
+  }
+
+  if ( (list == NULL) && (engine->rule[0] == NULL)) {
+
+    // no rule can match this class
+    return engine->stamp;
+  }
+
+  source = gxPLMessageSourceIdGet (message);
+  str[gxPLFilterVendor] = source->vendor;
+  str[gxPLFilterDevice] = source->device;
+  str[gxPLFilterInstance] = source->instance;
+  str[gxPLFilterClass] = gxPLMessageSchemaClassGet (message);
+  str[gxPLFilterType] = gxPLMessageSchemaTypeGet (message);
+  gxPLTokenLookupArray (str, token, gxPLFilterClass);
+  token[gxPLFilterType] = gxPLMessageSchemaTypeToken (message);
+
+  prvListClassify (list, gxPLMessageTypeGet (message), token, str,
+                   engine->stamp);
+  prvListClassify (engine->rule[0], gxPLMessageTypeGet (message), token, str,
+                   engine->stamp);
+  return engine->stamp;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,99 @@
+/**
+ * @file
+ * Compiled message filters internal include
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_FILTER_PRIVATE_HEADER_
+#define _GXPL_FILTER_PRIVATE_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/* constants ================================================================ */
+/*
+ * @brief Fields of a filter compared as tokens
+ */
+typedef enum {
+  gxPLFilterVendor = 0,
+  gxPLFilterDevice,
+  gxPLFilterInstance,
+  gxPLFilterClass,
+  gxPLFilterType,
+  gxPLFilterFields
+} gxPLFilterField;
+
+/* structures =============================================================== */
+
+/*
+ * @brief Compiled filter
+ *
+ * The strings of the filter are replaced by tokens, the wildcards by a bit
+ * of wild (1 << gxPLFilterField). When the table of tokens is full, the bit
+ * of literal is set and the string of the filter is compared.
+ */
+typedef struct _gxPLFilterRule {
+  gxPLFilter filter; /* must be the first member, a rule is used as a filter */
+  struct _gxPLFilterRule * next;
+  unsigned long * mark; /* receives the stamp of the messages that match */
+  int token[gxPLFilterFields];
+  const char * str[gxPLFilterFields];
+  uint8_t wild;
+  uint8_t literal;
+} gxPLFilterRule;
+
+/*
+ * @brief Filters of all devices of an application
+ *
+ * The rules are listed by token of schema class, the list 0 contains the
+ * rules whose class is a wildcard or a literal. A message is compared only to the rules
+ * of its class and to the rules of the list 0.
+ */
+typedef struct _gxPLFilterEngine {
+  gxPLFilterRule ** rule;
+  int size;
+  int count;
+  unsigned long stamp; /* incremented for each message classified */
+} gxPLFilterEngine;
+
+/* internal private functions =============================================== */
+
+/*
+ * @brief Initializes an empty engine
+ */
+void gxPLFilterEngineInit (gxPLFilterEngine * engine);
+
+/*
+ * @brief Releases the lists, the rules are not released
+ */
+void gxPLFilterEngineDestroy (gxPLFilterEngine * engine);
+
+/*
+ * @brief Compiles the filter of a rule and adds it to an engine
+ * @param rule rule whose filter member is set
+ * @param mark variable that receives the stamp of the messages matched
+ * @return 0, -1 if an error occurs
+ */
+int gxPLFilterRuleAdd (gxPLFilterEngine * engine, gxPLFilterRule * rule,
+                       unsigned long * mark);
+
+/*
+ * @brief Removes a rule from an engine
+ */
+void gxPLFilterRuleRemove (gxPLFilterEngine * engine, gxPLFilterRule * rule);
+
+/*
+ * @brief Classifies a message against all the rules of an engine
+ *
+ * The mark of each rule that matches receives the new stamp of the engine.
+ * @return the stamp of the message
+ */
+unsigned long gxPLFilterEngineClassify (gxPLFilterEngine * engine,
+                                        const gxPLMessage * message);
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_FILTER_PRIVATE_HEADER_ defined */
@@ -8,6 +8,7 @@
  * Licensed under the Apache License, Version 2.0 (the "License")
  */
 #include "config.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
@@ -25,10 +26,34 @@
 #define DEFAULT_IO_TIMEMOUT 30
 #endif
 
+#ifndef DEFAULT_POLL_BUDGET
+#define DEFAULT_POLL_BUDGET 32
+#endif
+
+#ifndef DEFAULT_DEVICE_HASH_SIZE
+#define DEFAULT_DEVICE_HASH_SIZE 16
+#endif
+
+// messages up to this size are formatted on the stack before sending
+#ifndef DEFAULT_SEND_BUFSIZE
+#define DEFAULT_SEND_BUFSIZE 1500
+#endif
+
+// messages with this number of pairs or more are sent by fragments
+#ifndef DEFAULT_SENDV_PAIRS
+#define DEFAULT_SENDV_PAIRS 8
+#endif
+
+// maximum number of fragments of a message sent without copy
+#ifndef DEFAULT_SEND_IOVMAX
+#define DEFAULT_SEND_IOVMAX 256
+#endif
+
 /* structures =============================================================== */
 typedef struct _listener_elmt {
   gxPLMessageListener func;
   void * data;
+  int issync; /* listener of the library, never called by a worker */
 } listener_elmt;
 
 /* private functions ======================================================== */
@@ -49,25 +74,107 @@ prvListenerMatch (const void *key1, const void *key2) {
 }
 
 // -----------------------------------------------------------------------------
-static const void *
-prvDeviceKey (const void * elmt) {
-  gxPLDevice * d = (gxPLDevice *) elmt;
+static int
+prvDeviceMatch (const gxPLHashNode * node, const void * key) {
+  const gxPLAppDevice * e = gxPLHashEntry (node, gxPLAppDevice, node);
 
-  return gxPLDeviceId (d);
+  return gxPLIdCmp (gxPLDeviceId (e->device), (const gxPLId *) key);
 }
 
 // -----------------------------------------------------------------------------
 static int
-prvDeviceMatch (const void *key1, const void *key2) {
+prvDeviceIs (const gxPLHashNode * node, const void * key) {
+  const gxPLAppDevice * e = gxPLHashEntry (node, gxPLAppDevice, node);
 
-  return gxPLIdCmp ( (gxPLId *) key1, (gxPLId *) key2);
+  return e->device != key;
 }
 
 // -----------------------------------------------------------------------------
+static int
+prvGroupMatch (const gxPLHashNode * node, const void * key) {
+  const gxPLAppGroup * g = gxPLHashEntry (node, gxPLAppGroup, node);
+
+  return strcmp (g->name, (const char *) key);
+}
+
+// -----------------------------------------------------------------------------
+static gxPLAppGroup *
+prvGroupFind (const gxPLApplication * app, const char * name) {
+  gxPLHashNode * node = gxPLHashFind (&app->group_index,
+                                      gxPLHashStr (GXPL_HASH_INIT, name),
+                                      name, prvGroupMatch);
+
+  return node ? gxPLHashEntry (node, gxPLAppGroup, node) : NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * Releases all the groups, the devices are not released */
 static void
-prvDeviceDelete (void * d) {
+prvGroupDeleteAll (gxPLApplication * app) {
+
+  for (unsigned long i = 0; i <= app->group_index.mask; i++) {
+    gxPLHashNode * node = app->group_index.bucket[i];
+
+    while (node) {
+      gxPLAppGroup * g = gxPLHashEntry (node, gxPLAppGroup, node);
 
-  gxPLDeviceDelete ( (gxPLDevice *) d);
+      node = node->next;
+      free (g->member);
+      free (g->name);
+      free (g);
+    }
+  }
+  gxPLHashDestroy (&app->group_index);
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the entry of a device, found by its identifier hash */
+static gxPLAppDevice *
+prvDeviceEntry (const gxPLApplication * app, const gxPLDevice * device,
+                const gxPLId * id) {
+  gxPLHashNode * node = gxPLHashFind (&app->device_index, gxPLHashId (id),
+                                      device, prvDeviceIs);
+
+  return node ? gxPLHashEntry (node, gxPLAppDevice, node) : NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * Adds a device to the registry, the device is released if its identifier
+ * is already used */
+static gxPLDevice *
+prvDeviceAdd (gxPLApplication * app, gxPLDevice * device) {
+  const gxPLId * id = gxPLDeviceId (device);
+  unsigned long hash = gxPLHashId (id);
+
+  // verifies that the device does not exist
+  if (gxPLHashFind (&app->device_index, hash, id, prvDeviceMatch) == NULL) {
+    gxPLAppDevice * e = malloc (sizeof (gxPLAppDevice));
+    assert (e);
+
+    if (app->device_count == app->device_max) {
+      int max = MAX (app->device_max * 2, 2);
+      gxPLAppDevice ** array = realloc (app->device, max * sizeof (gxPLAppDevice *));
+
+      if (array == NULL) {
+
+        free (e);
+        gxPLDeviceDelete (device);
+        return NULL;
+      }
+      app->device = array;
+      app->device_max = max;
+    }
+
+    // if not, add it to the list
+    e->device = device;
+    e->index = app->device_count++;
+    app->device[e->index] = e;
+    gxPLHashAdd (&app->device_index, &e->node, hash);
+    return device;
+  }
+  // failure exit
+  gxPLDeviceDelete (device);
+  return NULL;
 }
 
 // -----------------------------------------------------------------------------
@@ -77,9 +184,9 @@ prvDeviceDelete (void * d) {
 int gxPLAppDisableAllDevices (gxPLApplication * app) {
   gxPLDevice * device;
 
-  for (int i = 0; i < iVectorSize (&app->device); i++) {
+  for (int i = 0; i < app->device_count; i++) {
 
-    device = pvVectorGet (&app->device, i);
+    device = app->device[i]->device;
     if (gxPLDeviceEnable (device, false) != 0) {
       return -1;
     }
@@ -87,74 +194,46 @@ int gxPLAppDisableAllDevices (gxPLApplication * app) {
   return 0;
 }
 
-/* -----------------------------------------------------------------------------
- * Private
- * Check each known device for when it last sent a heart
- * beat and if it's time to send another, do it. */
+// -----------------------------------------------------------------------------
+// Run the passed message by each device and see who is interested
+// Only the broadcast messages are passed to each device, the targeted and
+// grouped messages are routed to their owners
 static void
-prvHeartbeatPoll (gxPLApplication * app) {
+prvDeviceMessageDispatcher (gxPLApplication * app, gxPLMessage * message,
+                            void * udata) {
   gxPLDevice * device;
-  long now = gxPLTime();
-  long elapsed;
-
-  for (int i = 0; i < iVectorSize (&app->device); i++) {
-
-    device = pvVectorGet (&app->device, i);
 
-    if (gxPLDeviceIsEnabled (device)) {
-      int interval = gxPLDeviceHeartbeatInterval (device);
-      time_t last = gxPLDeviceHeartbeatLast (device);
+  if (gxPLMessageIsBroadcast (message) == true) {
 
-      // See how much time has gone by
-      elapsed = now - last;
+    // marks the devices whose filters match, once for all devices
+    (void) gxPLFilterEngineClassify (&app->filter, message);
+    for (int i = 0; i < app->device_count; i++) {
 
-      if (gxPLDeviceIsHubConfirmed (device)) {
-
-        if (last >= 1) {
-
-          if (gxPLDeviceIsConfigurale (device) &&
-              !gxPLDeviceIsConfigured (device)) {
-
-            // If we are in configuration mode, we send out once a minute
-            if (elapsed < DEFAULT_CONFIG_HEARTBEAT_INTERVAL) {
-
-              continue;
-            }
-          }
-
-          // For normal heartbeats, once each "hbeat_interval"
-          if (elapsed < interval) {
-
-            continue;
-          }
-        }
-      }
-      else {
-
-        // If we are still waiting to hear from the hub,
-        // then send a message every 3 seconds until we do
-        if (elapsed < DEFAULT_HUB_DISCOVERY_INTERVAL) {
+      device = app->device[i]->device;
+      gxPLDeviceMessageHandler (device, message, udata);
+    }
+  }
+  else if (gxPLMessageIsGrouped (message) == false) {
 
-          continue;
-        }
-      }
+    device = gxPLAppDeviceFind (app, gxPLMessageTargetIdGet (message));
+    if (device) {
 
-      gxPLDeviceHeartbeatSend (device, gxPLHeartbeatHello);
+      gxPLDeviceMessageHandler (device, message, udata);
     }
   }
-}
+  else {
+    gxPLAppGroup * g = prvGroupFind (app, gxPLMessageTargetInstanceIdGet (message));
 
-// -----------------------------------------------------------------------------
-// Run the passed message by each device and see who is interested
-static void
-prvDeviceMessageDispatcher (gxPLApplication * app, gxPLMessage * message,
-                            void * udata) {
-  gxPLDevice * device;
+    // a handler can remove a member, the last one takes its place
+    for (int i = 0; g && (i < g->count); i++) {
+      device = g->member[i];
 
-  for (int i = 0; i < iVectorSize (&app->device); i++) {
+      gxPLDeviceMessageHandler (device, message, udata);
+      if ( (i < g->count) && (g->member[i] != device)) {
 
-    device = pvVectorGet (&app->device, i);
-    gxPLDeviceMessageHandler (device, message, udata);
+        i--;
+      }
+    }
   }
 }
 
@@ -191,8 +270,245 @@ prvEncodeLong (unsigned long value, char * str, int size) {
   }
 }
 
+// -----------------------------------------------------------------------------
+static int
+prvMessageListenerAdd (gxPLApplication * app, gxPLMessageListener listener,
+                       void * udata, int issync) {
+  listener_elmt * h = malloc (sizeof (listener_elmt));
+  assert (h);
+
+  h->func = listener;
+  h->data = udata;
+  h->issync = issync;
+
+  // the workers no longer read the vector
+  gxPLWorkersDrain (app);
+  if (iVectorAppend (&app->msg_listener, h) == 0) {
+    return 0;
+  }
+  free (h);
+  return -1;
+}
+
+/* -----------------------------------------------------------------------------
+ * Receives the next datagram of the network in a buffer allocated by
+ * *allocator, terminated by a null character. The buffer of the receive ring of
+ * the io layer is handed over if it can, *allocator receives its allocator.
+ * Return the size of the datagram, 0 if none, -1 on error */
+static int
+prvDatagramRecv (gxPLApplication * app, int size, char ** buffer,
+                 gxPLAllocator ** allocator) {
+  int ret = gxPLIoRecvBuffer (app->io, buffer, allocator);
+
+  if ( (ret < 0) && (errno == ENOSYS)) {
+
+    // the io layer does not keep its buffers, the datagram is copied
+    *buffer = gxPLAllocatorAlloc (*allocator, size + 1);
+    assert (*buffer);
+
+    ret = gxPLIoRecv (app->io, *buffer, size, NULL);
+    if (ret == size) {
+
+      // append null character to terminate the string
+      (*buffer)[size] = '\0';
+    }
+    else {
+
+      gxPLAllocatorFree (*allocator, *buffer);
+      ret = (ret < 0) ? -1 : 0;
+    }
+  }
+  return ret;
+}
+
+/* -----------------------------------------------------------------------------
+ * Decodes a received datagram and dispatches it to the listeners,
+ * the buffer, allocated by allocator, is released by this function */
+static void
+prvDatagramDispatch (gxPLApplication * app, char * buffer,
+                     gxPLAllocator * allocator) {
+  gxPLMessage * msg = app->partial;
+
+  if (msg == NULL) {
+
+    // new message, decoded in place, the message owns the buffer
+    msg = gxPLMessageAllocFromBuffer (allocator, buffer);
+    buffer = NULL;
+  }
+  else {
+
+    // next part of an incomplete message
+    msg = gxPLMessageFromString (msg, buffer);
+  }
+
+  if (msg) {
+
+    if (gxPLMessageIsError (msg)) {
+      PINFO ("Error parsing network message - ignored");
+    }
+    else if (gxPLMessageIsValid (msg)) {
+
+      // Dispatch the message
+      PDEBUG ("Now dispatching valid message");
+
+      // the listeners of the library first, they may modify the message, then
+      // the listeners of the user, called by the workers if any
+      gxPLWorkersHold (app);
+      for (int issync = 1; issync >= 0; issync--) {
+
+        if (issync == 0) {
+
+          // the message is no longer modified, the jobs posted by the devices
+          // are handed over to the workers
+          gxPLWorkersRelease (app);
+        }
+
+        for (int i = 0; i < iVectorSize (&app->msg_listener); i++) {
+
+          listener_elmt * h = pvVectorGet (&app->msg_listener, i);
+          if ( (h->func) && (h->issync == issync)) {
+
+            if ( (issync) ||
+                 (gxPLWorkersPost (app, (int) gxPLHashId (gxPLMessageSourceIdGet (msg)),
+                                   NULL, h->func, h->data, msg) != 0)) {
+
+              h->func (app, msg, h->data);
+            }
+          }
+        }
+      }
+    }
+
+    if (gxPLMessageIsValid (msg) || gxPLMessageIsError (msg)) {
+
+      // Release the message
+      gxPLMessageDelete (msg);
+      msg = NULL;
+    }
+  }
+  else {
+
+    PINFO ("Error parsing network message - ignored");
+  }
+  app->partial = msg;
+  gxPLAllocatorFree (allocator, buffer);
+}
+
 /* internal public functions ================================================ */
 
+// -----------------------------------------------------------------------------
+int
+gxPLMessageListenerAddSync (gxPLApplication * app,
+                            gxPLMessageListener listener, void * udata) {
+
+  return prvMessageListenerAdd (app, listener, udata, 1);
+}
+
+// -----------------------------------------------------------------------------
+gxPLTimerWheel *
+gxPLAppTimerWheel (gxPLApplication * app) {
+
+  return &app->timer;
+}
+
+// -----------------------------------------------------------------------------
+gxPLFilterEngine *
+gxPLAppFilterEngine (gxPLApplication * app) {
+
+  return &app->filter;
+}
+
+// -----------------------------------------------------------------------------
+unsigned long
+gxPLAppTimeMs (const gxPLApplication * app) {
+
+  return gxPLTimerWheelNow (&app->timer);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppTimerPoll (gxPLApplication * app) {
+
+  (void) gxPLTimerWheelUpdate (&app->timer);
+  return gxPLTimerWheelRun (&app->timer);
+}
+
+// -----------------------------------------------------------------------------
+long
+gxPLAppTimerNext (gxPLApplication * app) {
+
+  (void) gxPLTimerWheelUpdate (&app->timer);
+  return gxPLTimerWheelNext (&app->timer);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppRawListenerSet (gxPLApplication * app, gxPLRawListener listener,
+                       void * udata) {
+
+  app->raw_listener = listener;
+  app->raw_data = udata;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppSendRaw (gxPLApplication * app, const char * buffer, int count,
+                const gxPLIoAddr * client) {
+  int ret = gxPLIoSend (app->io, buffer, count, client);
+
+  if (ret < 0) {
+    PERROR ("Unable to send message: [%.10s...]", buffer);
+  }
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppSendRawMulti (gxPLApplication * app, const char * buffer, int count,
+                     const gxPLIoAddr * const * clients, int nclients) {
+  int ret = gxPLIoSendMulti (app->io, buffer, count, clients, nclients);
+
+  if (ret < nclients) {
+    PERROR ("Unable to send message to %d clients: [%.10s...]",
+            nclients - MAX (ret, 0), buffer);
+  }
+  return ret;
+}
+
+/* -----------------------------------------------------------------------------
+ * Sends a message by fragments pointing to its pairs, without copy.
+ * Returns -2 if the message must be formatted in a contiguous buffer.
+ */
+static int
+prvSendMessageVec (gxPLApplication * app, const gxPLMessage * message,
+                   const gxPLIoAddr * client) {
+  gxPLIoVec iov[DEFAULT_SEND_IOVMAX];
+  int ret, iovcnt;
+
+  iovcnt = gxPLMessageToIoVec (message, iov, DEFAULT_SEND_IOVMAX);
+  if (iovcnt < 0) {
+
+    return -2;
+  }
+
+  ret = gxPLIoSendv (app->io, iov, iovcnt, client);
+  if (ret < 0) {
+
+    if (errno == ENOSYS) {
+
+      app->noiovec = 1;
+      return -2;
+    }
+
+    if (errno == EMSGSIZE) {
+
+      return -2;
+    }
+    PERROR ("Unable to send message: [%.10s...]", (const char *) iov[0].base);
+  }
+  return ret;
+}
 
 /* api functions ============================================================ */
 // -----------------------------------------------------------------------------
@@ -241,6 +557,7 @@ gxPLAppOpen (gxPLSetting * setting) {
   gxPLApplication * app = calloc (1, sizeof (gxPLApplication));
   assert (app);
 
+  app->alloc = gxPLAllocatorHeap();
   vLogSetMask (LOG_UPTO (setting->log));
   app->io = gxPLIoOpen (setting);
 
@@ -262,20 +579,21 @@ gxPLAppOpen (gxPLSetting * setting) {
       if (iVectorInitSearch (&app->msg_listener, prvListenerKey,
                              prvListenerMatch) == 0) {
 
-        if (iVectorInit (&app->device, 2, NULL, prvDeviceDelete) == 0) {
+        if ( (gxPLHashInit (&app->device_index, DEFAULT_DEVICE_HASH_SIZE) == 0) &&
+             (gxPLHashInit (&app->group_index, DEFAULT_DEVICE_HASH_SIZE) == 0)) {
 
-          if (iVectorInitSearch (&app->device, prvDeviceKey,
-                                 prvDeviceMatch) == 0) {
+          // everything was done, we copy the network information and returns.
+          (void) gxPLIoCtl (app, gxPLIoFuncGetNetInfo, &app->net_info);
+          if (gxPLMessageListenerAddSync (app, prvDeviceMessageDispatcher, NULL) == 0) {
 
-            // everything was done, we copy the network information and returns.
-            (void) gxPLIoCtl (app, gxPLIoFuncGetNetInfo, &app->net_info);
-            if (gxPLMessageListenerAdd (app, prvDeviceMessageDispatcher, NULL) == 0) {
-
-              srand (gxPLRandomSeed (app));
-              return app;
-            }
+            gxPLTimerWheelInit (&app->timer);
+            gxPLFilterEngineInit (&app->filter);
+            srand (gxPLRandomSeed (app));
+            return app;
           }
         }
+        gxPLHashDestroy (&app->device_index);
+        gxPLHashDestroy (&app->group_index);
       }
     }
   }
@@ -291,8 +609,25 @@ gxPLAppClose (gxPLApplication * app) {
   if (app) {
     int ret;
 
+#if CONFIG_THREAD_SAFE
+    // the messages handed over are processed first, they can be sent
+    (void) gxPLAppWorkersStop (app);
+    (void) gxPLAppSendQueueClose (app);
+#endif
+    gxPLRequestTableDelete (app);
+    (void) gxPLAppDirectoryClose (app);
+    (void) gxPLAppStateCacheClose (app);
     // for each device, sends a goodbye heartbeat and removes all listeners,
-    vVectorDestroy (&app->device);
+    for (int i = 0; i < app->device_count; i++) {
+
+      gxPLDeviceDelete (app->device[i]->device);
+      free (app->device[i]);
+    }
+    free (app->device);
+    gxPLHashDestroy (&app->device_index);
+    prvGroupDeleteAll (app);
+    gxPLFilterEngineDestroy (&app->filter);
+    gxPLMessageDelete (app->partial);
     // and close !
     ret = gxPLIoClose (app->io);
     // then releases all message listeners
@@ -310,17 +645,8 @@ gxPLAppClose (gxPLApplication * app) {
 // -----------------------------------------------------------------------------
 int
 gxPLMessageListenerAdd (gxPLApplication * app, gxPLMessageListener listener, void * udata) {
-  listener_elmt * h = malloc (sizeof (listener_elmt));
-  assert (h);
-
-  h->func = listener;
-  h->data = udata;
 
-  if (iVectorAppend (&app->msg_listener, h) == 0) {
-    return 0;
-  }
-  free (h);
-  return -1;
+  return prvMessageListenerAdd (app, listener, udata, 0);
 }
 
 // -----------------------------------------------------------------------------
@@ -328,109 +654,191 @@ int
 gxPLMessageListenerRemove (gxPLApplication * app, gxPLMessageListener listener) {
   int i = iVectorFindFirstIndex (&app->msg_listener, &listener);
 
-
+  gxPLWorkersDrain (app);
   return iVectorRemove (&app->msg_listener, i);
 }
 
 // -----------------------------------------------------------------------------
 int
 gxPLAppPoll (gxPLApplication * app, int timeout_ms) {
-  int ret, size = 0;
+  int ret;
+
+  ret = gxPLAppPollBudget (app, timeout_ms, DEFAULT_POLL_BUDGET);
+  return (ret < 0) ? -1 : 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppPollBudget (gxPLApplication * app, int timeout_ms, int budget) {
+  int ret, size = 0, count = 0;
+  long next = gxPLAppTimerNext (app);
+
+  if ( (next >= 0) && ( (timeout_ms < 0) || (next < timeout_ms))) {
+
+    // wakes up for the next timer
+    timeout_ms = next;
+  }
 
   ret = gxPLIoCtl (app, gxPLIoFuncPoll, &size, timeout_ms);
+  // the datagrams and the timers below are processed at this time
+  (void) gxPLTimerWheelUpdate (&app->timer);
+  // the messages queued by the other threads are sent first
+  (void) gxPLSendQueueDrain (app);
 
-  if (ret == 0)  {
+  while ( (ret == 0) && (size > 0) && (count < budget)) {
+    gxPLAllocator * alloc = app->alloc;
+    char * buffer;
 
-    if (size > 0) {
-      char * buffer = malloc (size + 1);
-      assert (buffer);
+    // the buffer of the datagram is handed over to the message, not copied
+    ret = prvDatagramRecv (app, size, &buffer, &alloc);
+    if (ret == size) {
 
-      ret = gxPLIoRecv (app->io, buffer, size, NULL);
-      if (ret == size) {
-        static gxPLMessage * msg;
+      if (bLogIsDaemonized ()) {
 
-        // We receive a message, append null character to terminate the string
-        buffer[size] = '\0';
-        if (bLogIsDaemonized ()) {
+        PDEBUG ("Just read %d bytes", size);
+      }
+      else {
 
-          PDEBUG ("Just read %d bytes", size);
-        }
-        else {
+        PDEBUG ("Just read %d bytes, raw buffer below >>>\n%s<<<", size, buffer);
+      }
 
-          PDEBUG ("Just read %d bytes, raw buffer below >>>\n%s<<<", size, buffer);
-        }
+      if ( (app->raw_listener == NULL) ||
+           (app->raw_listener (app, buffer, size, app->raw_data) == false)) {
 
-        // TODO: Send the raw message to any raw message msg_listener ?
+        prvDatagramDispatch (app, buffer, alloc);
+      }
+      else {
 
-        msg = gxPLMessageFromString (msg, buffer);
-        if (msg) {
+        // already processed, without decoding
+        gxPLAllocatorFree (alloc, buffer);
+      }
+      count++;
 
-          if (gxPLMessageIsError (msg)) {
-            PINFO ("Error parsing network message - ignored");
-          }
-          else if (gxPLMessageIsValid (msg)) {
+      // the datagrams already received are processed without waiting
+      size = 0;
+      ret = gxPLIoCtl (app, gxPLIoFuncPoll, &size, 0);
+    }
+    else {
 
-            // Dispatch the message
-            PDEBUG ("Now dispatching valid message");
+      ret = (ret < 0) ? -1 : 0;
+      size = 0;
+    }
+  }
 
-            for (int i = 0; i < iVectorSize (&app->msg_listener); i++) {
+  // datagrams can remain if the budget was exhausted
+  app->isbusy = (count >= budget);
 
-              listener_elmt * h = pvVectorGet (&app->msg_listener, i);
-              if (h->func) {
+  if (ret == 0) {
 
-                h->func (app, msg, h->data);
-              }
-            }
-          }
+    // timers are run even if the network is never idle
+    (void) gxPLTimerWheelRun (&app->timer);
+    return count;
+  }
 
-          if (gxPLMessageIsValid (msg) || gxPLMessageIsError (msg)) {
+  PNOTICE ("gxPLIoCtl(gxPLIoFuncPoll) return %d", ret);
+  return -1;
+}
 
-            // Release the message
-            gxPLMessageDelete (msg);
-            msg = NULL;
-            ret = 0;
-          }
-        }
-        else {
+// -----------------------------------------------------------------------------
+int
+gxPLAppFd (gxPLApplication * app) {
+  int fd = -1;
 
-          PINFO ("Error parsing network message - ignored");
-        }
-      }
-      free (buffer);
-    }
-    else {
+  if (gxPLIoCtl (app, gxPLIoFuncGetFd, &fd) != 0) {
 
-      prvHeartbeatPoll (app);
-    }
+    return -1;
   }
-  else {
+  return fd;
+}
+
+// -----------------------------------------------------------------------------
+long
+gxPLAppNextDeadlineMs (gxPLApplication * app) {
+
+  if (app->isbusy) {
 
-    PNOTICE ("gxPLIoCtl(gxPLIoFuncPoll) return %d", ret);
+    // the descriptor may not be readable any more
+    return 0;
   }
-  return ret;
+  return gxPLAppTimerNext (app);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppProcessReady (gxPLApplication * app) {
+
+  return gxPLAppPollBudget (app, 0, DEFAULT_POLL_BUDGET);
 }
 
+#ifndef __AVR__
+// -----------------------------------------------------------------------------
+int
+gxPLAppSendQueueFd (const gxPLApplication * app) {
+
+  return gxPLSendQueueFd (app);
+}
+#endif
+
 // -----------------------------------------------------------------------------
 int
 gxPLAppSendMessage (gxPLApplication * app, const gxPLMessage * message,
                     const gxPLIoAddr * client) {
+  char buf[DEFAULT_SEND_BUFSIZE];
+  char * str = buf;
   int ret = -1;
   int count;
-  char * str = gxPLMessageToString (message);
 
-  if (str) {
+  if ( (!app->noiovec) &&
+       (gxPLMessageBodySize (message) >= DEFAULT_SENDV_PAIRS)) {
 
-    count = strlen (str);
-    ret = gxPLIoSend (app->io, str, count, client);
-    if (ret < 0) {
-      PERROR ("Unable to send message: [%10s...]", str);
+    // large body, the pairs are sent where they are
+    ret = prvSendMessageVec (app, message, client);
+    if (ret != -2) {
+
+      return ret;
     }
-    free (str);
+    ret = -1;
   }
 
+  count = gxPLMessageToBuffer (message, buf, sizeof (buf));
+
+  if ( (count < 0) && (errno == ENOBUFS)) {
+
+    // too large for the stack
+    count = gxPLMessageSerializedSize (message);
+    str = gxPLAllocatorAlloc (app->alloc, count + 1);
+    if (str) {
+
+      count = gxPLMessageToBuffer (message, str, count + 1);
+    }
+  }
+
+  if ( (str) && (count >= 0)) {
+
+    ret = gxPLAppSendRaw (app, str, count, client);
+  }
+
+  if (str != buf) {
+
+    gxPLAllocatorFree (app->alloc, str);
+  }
   return ret;
 }
 
+// -----------------------------------------------------------------------------
+int
+gxPLAppSendCachedMessage (gxPLApplication * app, gxPLMessage * message,
+                          const gxPLIoAddr * client) {
+  int count;
+  const char * str = gxPLMessageStringGet (message, &count);
+
+  if (str) {
+
+    return gxPLAppSendRaw (app, str, count, client);
+  }
+  return gxPLAppSendMessage (app, message, client);
+}
+
 // -----------------------------------------------------------------------------
 int
 gxPLAppBroadcastMessage (gxPLApplication * app, const gxPLMessage * message) {
@@ -443,11 +851,12 @@ gxPLAppBroadcastMessage (gxPLApplication * app, const gxPLMessage * message) {
 int
 gxPLAppIsHubEchoMessage (const gxPLApplication * app, const gxPLMessage * msg,
                          const gxPLId * my_id) {
+  int class_token = gxPLMessageSchemaClassToken (msg);
 
-  if ( (strcmp (gxPLMessageSchemaClassGet (msg), "hbeat") == 0) ||
-       (strcmp (gxPLMessageSchemaClassGet (msg), "config") == 0)) {
+  if ( (class_token == gxPLTokenHbeat) || (class_token == gxPLTokenConfig)) {
+    int type_token = gxPLMessageSchemaTypeToken (msg);
 
-    if (strcmp (gxPLMessageSchemaTypeGet (msg), "app") == 0) {
+    if (type_token == gxPLTokenApp) {
       const char * remote_ip = gxPLMessagePairGet (msg, "remote-ip");
 
       if (remote_ip) {
@@ -468,7 +877,7 @@ gxPLAppIsHubEchoMessage (const gxPLApplication * app, const gxPLMessage * msg,
         }
       }
     }
-    else if (strcmp (gxPLMessageSchemaTypeGet (msg), "basic") == 0) {
+    else if (type_token == gxPLTokenBasic) {
 #if CONFIG_HBEAT_BASIC_EXTENSION
       const char * remote_addr = gxPLMessagePairGet (msg, "remote-addr");
       if (remote_addr) {
@@ -497,21 +906,8 @@ gxPLAppAddDevice (gxPLApplication * app, const char * vendor_id,
                   const char * device_id, const char * instance_id) {
 
   gxPLDevice * device = gxPLDeviceNew (app, vendor_id, device_id, instance_id);
-  if (device) {
-
-    // verifies that the device does not exist
-    if (pvVectorFindFirst (&app->device, gxPLDeviceId (device)) == NULL) {
-
-      // if not, add it to the list
-      if (iVectorAppend (&app->device, device) == 0) {
 
-        return device;
-      }
-    }
-  }
-  // failure exit
-  gxPLDeviceDelete (device);
-  return NULL;
+  return (device) ? prvDeviceAdd (app, device) : NULL;
 }
 
 // -----------------------------------------------------------------------------
@@ -520,30 +916,25 @@ gxPLAppAddConfigurableDevice (gxPLApplication * app, const char * vendor_id,
                               const char * device_id, const char * filename) {
   gxPLDevice * device = gxPLDeviceConfigNew (app,
                         vendor_id, device_id, filename);
-  if (device) {
-
-    // verifies that the device does not exist
-    if (pvVectorFindFirst (&app->device, gxPLDeviceId (device)) == NULL) {
-
-      // if not, add it to the list
-      if (iVectorAppend (&app->device, device) == 0) {
 
-        return device;
-      }
-    }
-  }
-  // failure exit
-  gxPLDeviceDelete (device);
-  return NULL;
+  return (device) ? prvDeviceAdd (app, device) : NULL;
 }
 
 // -----------------------------------------------------------------------------
 int
 gxPLAppRemoveDevice (gxPLApplication * app, gxPLDevice * device) {
 
-  int index = iVectorFindFirstIndex (&app->device, device);
-  if (index >= 0) {
-    return iVectorRemove (&app->device, index);
+  gxPLAppDevice * e = prvDeviceEntry (app, device, gxPLDeviceId (device));
+
+  if (e) {
+
+    // the last device takes the place of the removed one
+    (void) gxPLHashRemove (&app->device_index, &e->node);
+    app->device[e->index] = app->device[--app->device_count];
+    app->device[e->index]->index = e->index;
+    free (e);
+    gxPLDeviceDelete (device);
+    return 0;
   }
   return -1;
 }
@@ -552,21 +943,106 @@ gxPLAppRemoveDevice (gxPLApplication * app, gxPLDevice * device) {
 int
 gxPLAppDeviceCount (gxPLApplication * app) {
 
-  return iVectorSize (&app->device);
+  return app->device_count;
 }
 
 // -----------------------------------------------------------------------------
 gxPLDevice *
 gxPLAppDeviceAt (gxPLApplication * app, int index) {
 
-  return (gxPLDevice *) pvVectorGet (&app->device, index);
+  if ( (index >= 0) && (index < app->device_count)) {
+
+    return app->device[index]->device;
+  }
+  return NULL;
 }
 
 // -----------------------------------------------------------------------------
 int
 gxPLAppDeviceIndex (gxPLApplication * app, const gxPLDevice * device) {
+  gxPLAppDevice * e = prvDeviceEntry (app, device, gxPLDeviceId (device));
 
-  return iVectorFindFirstIndex (&app->device, device);
+  return (e) ? e->index : -1;
+}
+
+// -----------------------------------------------------------------------------
+gxPLDevice *
+gxPLAppDeviceFind (gxPLApplication * app, const gxPLId * id) {
+  gxPLHashNode * node = gxPLHashFind (&app->device_index, gxPLHashId (id),
+                                      id, prvDeviceMatch);
+
+  return node ? gxPLHashEntry (node, gxPLAppDevice, node)->device : NULL;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLAppDeviceIdChanged (gxPLApplication * app, gxPLDevice * device,
+                        const gxPLId * old_id) {
+  gxPLAppDevice * e = prvDeviceEntry (app, device, old_id);
+
+  if (e) {
+
+    (void) gxPLHashRemove (&app->device_index, &e->node);
+    gxPLHashAdd (&app->device_index, &e->node, gxPLHashId (gxPLDeviceId (device)));
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppGroupJoin (gxPLApplication * app, gxPLDevice * device,
+                  const char * name) {
+  gxPLAppGroup * g = prvGroupFind (app, name);
+
+  if (g == NULL) {
+
+    g = calloc (1, sizeof (gxPLAppGroup));
+    assert (g);
+    g->name = malloc (strlen (name) + 1);
+    assert (g->name);
+    strcpy (g->name, name);
+    gxPLHashAdd (&app->group_index, &g->node, gxPLHashStr (GXPL_HASH_INIT, name));
+  }
+
+  for (int i = 0; i < g->count; i++) {
+
+    if (g->member[i] == device) {
+
+      return 0;
+    }
+  }
+
+  if (g->count == g->max) {
+    int max = MAX (g->max * 2, 2);
+    gxPLDevice ** member = realloc (g->member, max * sizeof (gxPLDevice *));
+
+    if (member == NULL) {
+
+      return -1;
+    }
+    g->member = member;
+    g->max = max;
+  }
+  g->member[g->count++] = device;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLAppGroupLeave (gxPLApplication * app, gxPLDevice * device,
+                   const char * name) {
+  gxPLAppGroup * g = prvGroupFind (app, name);
+
+  if (g) {
+
+    for (int i = 0; i < g->count; i++) {
+
+      if (g->member[i] == device) {
+
+        g->member[i] = g->member[--g->count];
+        break;
+      }
+    }
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -596,11 +1072,13 @@ gxPLIoCtl (gxPLApplication * app, int c, ...) {
 // -----------------------------------------------------------------------------
 const char *
 gxPLIoLocalAddrGet (const gxPLApplication * app) {
-  static char * str;
+  char * str;
 
   if (gxPLIoCtl ( (gxPLApplication *) app, gxPLIoFuncNetAddrToString, &app->net_info, &str) == 0) {
+    char * dst = ( (gxPLApplication *) app)->local_addr_str;
 
-    return str;
+    strncpy (dst, str, GXPL_NETADDR_STR_MAX - 1);
+    return dst;
   }
   return "";
 }
@@ -621,13 +1099,15 @@ gxPLIoLocalAddrList (const gxPLApplication * app) {
 const char *
 gxPLIoBcastAddrGet (const gxPLApplication * app) {
   gxPLIoAddr addr;
-  static char * str;
+  char * str;
 
   if (gxPLIoCtl ( (gxPLApplication *) app, gxPLIoFuncGetBcastAddr, &addr) == 0) {
 
     if (gxPLIoCtl ( (gxPLApplication *) app, gxPLIoFuncNetAddrToString, &addr, &str) == 0) {
+      char * dst = ( (gxPLApplication *) app)->bcast_addr_str;
 
-      return str;
+      strncpy (dst, str, GXPL_NETADDR_STR_MAX - 1);
+      return dst;
     }
   }
   return "";
@@ -654,6 +1134,22 @@ gxPLAppSetting (gxPLApplication * app) {
   return app->setting;
 }
 
+// -----------------------------------------------------------------------------
+int
+gxPLAppAllocatorSet (gxPLApplication * app, gxPLAllocator * allocator) {
+
+  // the messages already allocated keep their allocator
+  app->alloc = (allocator) ? allocator : gxPLAllocatorHeap();
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+gxPLAllocator *
+gxPLAppAllocator (const gxPLApplication * app) {
+
+  return app->alloc;
+}
+
 // -----------------------------------------------------------------------------
 const char *
 gxPLIoInterfaceGet (const gxPLApplication * app) {
@@ -14,6 +14,29 @@
 
 /* structures =============================================================== */
 
+/*
+ * @brief Entry of the device registry of an application
+ */
+typedef struct _gxPLAppDevice {
+  gxPLHashNode node; /**< indexed by the identifier of the device */
+  gxPLDevice * device;
+  int index; /**< position in the array of the application */
+} gxPLAppDevice;
+
+/*
+ * @brief Devices members of a group, to route the grouped messages
+ *
+ * A group without member is kept until the application is closed, so that
+ * a device can leave a group while a message is dispatched to it.
+ */
+typedef struct _gxPLAppGroup {
+  gxPLHashNode node; /**< indexed by the name of the group */
+  char * name;
+  gxPLDevice ** member;
+  int count;
+  int max;
+} gxPLAppGroup;
+
 /*
  * @brief xPL Application
  */
@@ -22,8 +45,29 @@ struct _gxPLApplication {
   gxPLSetting * setting;
   gxPLIo * io;  /**< abstract structure can not be used directly on top level */
   xVector msg_listener;
-  xVector device;
+  gxPLAppDevice ** device; /**< devices, the last one replaces a removed one */
+  int device_count;
+  int device_max;
+  gxPLHash device_index; /**< devices indexed by their identifier */
+  gxPLHash group_index; /**< gxPLAppGroup indexed by their name */
+  gxPLFilterEngine filter; /**< filters of all devices */
+  gxPLTimerWheel timer; /**< heartbeats and other protocol timers */
+  gxPLAllocator * alloc; /**< messages and receive buffers */
+  int noiovec; /**< the io layer needs a contiguous frame */
+  int isbusy; /**< the budget of the last poll was exhausted */
+  gxPLRawListener raw_listener; /**< called before decoding, NULL if none */
+  void * raw_data;
+  gxPLMessage * partial; /**< message received in several datagrams */
+  gxPLRequestTable * requests; /**< requests of gxPLAppRequest(), NULL if none */
+  gxPLDirectory * directory; /**< devices of the network, NULL if not opened */
+  gxPLStateCache * statecache; /**< last status of the devices, NULL if not opened */
+#if CONFIG_THREAD_SAFE
+  gxPLWorkerPool * workers; /**< NULL if the listeners are called by the poll */
+  gxPLSendQueue * sendq; /**< messages of gxPLAppSendAsync(), NULL if none */
+#endif
   gxPLIoAddr net_info;
+  char local_addr_str[GXPL_NETADDR_STR_MAX]; /**< gxPLIoLocalAddrGet() */
+  char bcast_addr_str[GXPL_NETADDR_STR_MAX]; /**< gxPLIoBcastAddrGet() */
 };
 
 
@@ -35,5 +79,23 @@ struct _gxPLApplication {
  */
 int gxPLRandomSeed (gxPLApplication * app);
 
+/*
+ * @brief Runs the timers of the application that have expired
+ *
+ * The time of the application is updated before.
+ * @param app
+ * @return number of expired timers
+ */
+int gxPLAppTimerPoll (gxPLApplication * app);
+
+/*
+ * @brief Time before the next timer of the application expires
+ *
+ * The time of the application is updated before.
+ * @param app
+ * @return delay in milliseconds, -1 if no timer is scheduled
+ */
+long gxPLAppTimerNext (gxPLApplication * app);
+
 /* ========================================================================== */
 #endif /* _GXPL_PRIVATE_HEADER_ defined */
@@ -0,0 +1,156 @@
+/**
+ * @file
+ * Hash table with chaining
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL/util.h>
+#include "hash_p.h"
+
+/* constants ================================================================ */
+#define FNV_PRIME 16777619UL
+
+/* private functions ======================================================== */
+
+/* -----------------------------------------------------------------------------
+ * Doubles the number of buckets */
+static void
+prvGrow (gxPLHash * table) {
+  unsigned long size = (table->mask + 1) * 2;
+  gxPLHashNode ** bucket = calloc (size, sizeof (gxPLHashNode *));
+
+  if (bucket == NULL) {
+
+    // the chains become longer, that's all
+    return;
+  }
+
+  for (unsigned long i = 0; i <= table->mask; i++) {
+    gxPLHashNode * node = table->bucket[i];
+
+    while (node) {
+      gxPLHashNode * next = node->next;
+      gxPLHashNode ** head = &bucket[node->hash & (size - 1)];
+
+      node->next = *head;
+      *head = node;
+      node = next;
+    }
+  }
+  free (table->bucket);
+  table->bucket = bucket;
+  table->mask = size - 1;
+}
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLHashInit (gxPLHash * table, int size) {
+  unsigned long n = 1;
+
+  while (n < size) {
+
+    n <<= 1;
+  }
+  table->bucket = calloc (n, sizeof (gxPLHashNode *));
+  if (table->bucket) {
+
+    table->mask = n - 1;
+    table->count = 0;
+    return 0;
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLHashDestroy (gxPLHash * table) {
+
+  free (table->bucket);
+  table->bucket = NULL;
+  table->count = 0;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLHashAdd (gxPLHash * table, gxPLHashNode * node, unsigned long hash) {
+  gxPLHashNode ** head;
+
+  if (table->count > table->mask) {
+
+    prvGrow (table);
+  }
+  head = &table->bucket[hash & table->mask];
+  node->hash = hash;
+  node->next = *head;
+  *head = node;
+  table->count++;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLHashRemove (gxPLHash * table, gxPLHashNode * node) {
+  gxPLHashNode ** p = &table->bucket[node->hash & table->mask];
+
+  while (*p) {
+
+    if (*p == node) {
+
+      *p = node->next;
+      node->next = NULL;
+      table->count--;
+      return 0;
+    }
+    p = & (*p)->next;
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+gxPLHashNode *
+gxPLHashFind (const gxPLHash * table, unsigned long hash,
+              const void * key, gxPLHashMatch match) {
+  gxPLHashNode * node = table->bucket[hash & table->mask];
+
+  while (node) {
+
+    if ( (node->hash == hash) && (match (node, key) == 0)) {
+
+      return node;
+    }
+    node = node->next;
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+unsigned long
+gxPLHashStr (unsigned long hash, const char * str) {
+
+  while (*str) {
+
+    hash ^= (unsigned char) *str++;
+    hash = (hash * FNV_PRIME) & 0xFFFFFFFFUL;
+  }
+  return hash;
+}
+
+// -----------------------------------------------------------------------------
+unsigned long
+gxPLHashId (const gxPLId * id) {
+  unsigned long hash = gxPLHashStr (GXPL_HASH_INIT, id->vendor);
+
+  // separators, so that "ab"+"c" and "a"+"bc" differ
+  hash = gxPLHashStr (hash, "-");
+  hash = gxPLHashStr (hash, id->device);
+  hash = gxPLHashStr (hash, ".");
+  return gxPLHashStr (hash, id->instance);
+}
+
+/* ========================================================================== */
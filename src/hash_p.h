@@ -0,0 +1,115 @@
+/**
+ * @file
+ * Hash table internal include
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_HASH_PRIVATE_HEADER_
+#define _GXPL_HASH_PRIVATE_HEADER_
+
+#include <stddef.h>
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/* constants ================================================================ */
+#define GXPL_HASH_INIT 2166136261UL /* FNV-1a offset basis */
+
+/* macros =================================================================== */
+/*
+ * @brief Returns the element of type containing the node
+ */
+#define gxPLHashEntry(node, type, member) \
+  ((type *) ((char *) (node) - offsetof (type, member)))
+
+/* structures =============================================================== */
+
+/*
+ * @brief Node of a hash table, embedded in the element it indexes
+ */
+typedef struct _gxPLHashNode {
+  struct _gxPLHashNode * next;
+  unsigned long hash;
+} gxPLHashNode;
+
+/*
+ * @brief Compares the element of a node with a key
+ * @return 0 if they match
+ */
+typedef int (*gxPLHashMatch) (const gxPLHashNode * node, const void * key);
+
+/*
+ * @brief Hash table with chaining
+ *
+ * The table does not allocate memory for its elements, the number of buckets
+ * is doubled when it is exceeded by the number of elements.
+ */
+typedef struct _gxPLHash {
+  gxPLHashNode ** bucket;
+  unsigned long mask; /* number of buckets - 1 */
+  int count;
+} gxPLHash;
+
+/* internal private functions =============================================== */
+
+/*
+ * @brief Initializes an empty table
+ * @param size initial number of buckets, rounded up to a power of 2
+ * @return 0, -1 if an error occurs
+ */
+int gxPLHashInit (gxPLHash * table, int size);
+
+/*
+ * @brief Releases the buckets, the elements are not released
+ */
+void gxPLHashDestroy (gxPLHash * table);
+
+/*
+ * @brief Adds a node, no check is made on duplicates
+ * @param hash hash of the key of the element
+ */
+void gxPLHashAdd (gxPLHash * table, gxPLHashNode * node, unsigned long hash);
+
+/*
+ * @brief Removes a node
+ * @return 0, -1 if the node is not in the table
+ */
+int gxPLHashRemove (gxPLHash * table, gxPLHashNode * node);
+
+/*
+ * @brief Finds the first node matching a key
+ * @param hash hash of the key
+ * @param key passed to match
+ * @param match comparison function
+ * @return the node, NULL if not found
+ */
+gxPLHashNode * gxPLHashFind (const gxPLHash * table, unsigned long hash,
+                             const void * key, gxPLHashMatch match);
+
+/*
+ * @brief Number of elements
+ */
+static inline int
+gxPLHashSize (const gxPLHash * table) {
+
+  return table->count;
+}
+
+/*
+ * @brief Adds a string to a hash (FNV-1a)
+ * @param hash GXPL_HASH_INIT or the result of a previous call
+ * @param str
+ * @return the new hash
+ */
+unsigned long gxPLHashStr (unsigned long hash, const char * str);
+
+/*
+ * @brief Hash of a xPL identifier
+ */
+unsigned long gxPLHashId (const gxPLId * id);
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_HASH_PRIVATE_HEADER_ defined */
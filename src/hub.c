@@ -8,11 +8,21 @@
  */
 #ifndef  __AVR__
 #include "config.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <gxPL.h>
 #include "hub_p.h"
 
+/* constants ================================================================ */
+#ifndef DEFAULT_HUB_HASH_SIZE
+#define DEFAULT_HUB_HASH_SIZE 16
+#endif
+
+#ifndef DEFAULT_SEND_BUFSIZE
+#define DEFAULT_SEND_BUFSIZE 1500
+#endif
+
 /* private functions ======================================================== */
 // -----------------------------------------------------------------------------
 static const void *
@@ -42,111 +52,369 @@ prvClientMatch (const void *key1, const void *key2) {
   return 0;
 }
 
-// --------------------------------------------------------------------------
-// Receive xPL network messages
+// -----------------------------------------------------------------------------
+static int
+prvClientIdMatch (const gxPLHashNode * node, const void * key) {
+
+  return gxPLIdCmp (&gxPLHashEntry (node, gxPLHubClient, node)->id,
+                    (const gxPLId *) key);
+}
+
+// -----------------------------------------------------------------------------
 static void
-prvHandleMessage (gxPLApplication * app, gxPLMessage * message, void * udata) {
-  gxPLHub * hub = (gxPLHub *) udata;
+prvClientDelete (void * elmt) {
+  gxPLHubClient * client = (gxPLHubClient *) elmt;
 
-  if ( (strcmp (gxPLMessageSchemaClassGet (message), "hbeat") == 0) ||
-       (strcmp (gxPLMessageSchemaClassGet (message), "config") == 0)) {
+  gxPLTimerStop (gxPLAppTimerWheel (client->hub->app), &client->expiry);
+  if (client->id.vendor[0]) {
 
-    // When the hub receives a hbeat.app or config.app message
-    // the hub should extract the "remote-ip" value from the message body
-    const char * str_addr = gxPLMessagePairGet (message, "remote-ip");
-    const char * str_port = gxPLMessagePairGet (message, "port");
+    (void) gxPLHashRemove (&client->hub->client_index, &client->node);
+  }
+  free (client);
+}
 
-    if ( (str_addr) && (str_port)) {
+/* -----------------------------------------------------------------------------
+ * Track known local xPL applications and determine when they have died and
+ * remove them from the list of local applications */
+static void
+prvClientTimeout (gxPLTimer * timer, void * udata) {
+  gxPLHubClient * client = (gxPLHubClient *) udata;
+  gxPLHub * hub = client->hub;
+  char * str;
 
-      // and compare the IP address with the list of addresses the hub is
-      // currently bound to for the  local computer.
-      if (iVectorFindFirstIndex (hub->local_addr_list, str_addr) >= 0) {
-        gxPLHubClient * client;
-        gxPLIoAddr clinfo;
-        char * endptr;
-        long now;
+  if (gxPLIoCtl (hub->app, gxPLIoFuncNetAddrToString, &client->addr, &str) == 0) {
 
-        now = gxPLTime();
+    PINFO ("remove application %s:%d after heartbeat timeout, "
+           "processing %d applications",
+           str, client->addr.port,
+           iVectorSize (&hub->clients) - 1);
+  }
+  (void) iVectorRemove (&hub->clients,
+                        iVectorFindFirstIndex (&hub->clients, &client->addr));
+}
 
-        // remote-ip matches with local address, converts to gxPLIoAddr
-        if (gxPLIoCtl (hub->app, gxPLIoFuncNetAddrFromString, &clinfo, str_addr) != 0) {
+/* -----------------------------------------------------------------------------
+ * Discovery of new xPL applications on the computer from the body of their
+ * hbeat or config message, source is NULL if the message is not decoded */
+static void
+prvClientUpdate (gxPLHub * hub, const gxPLId * source, const char * schema_type,
+                 const char * str_addr, const char * str_port,
+                 const char * str_interval) {
+
+  if ( (str_addr) && (str_port)) {
+
+    // and compare the IP address with the list of addresses the hub is
+    // currently bound to for the  local computer.
+    if (iVectorFindFirstIndex (hub->local_addr_list, str_addr) >= 0) {
+      gxPLHubClient * client;
+      gxPLIoAddr clinfo;
+      char * endptr;
+
+      // remote-ip matches with local address, converts to gxPLIoAddr
+      if (gxPLIoCtl (hub->app, gxPLIoFuncNetAddrFromString, &clinfo, str_addr) != 0) {
+
+        PERROR ("unable to convert %s to ip address", str_addr);
+        return;
+      }
+
+      // Gets the ip port
+      clinfo.port = strtol (str_port, &endptr, 10);
+      if (endptr == NULL) {
+
+        PERROR ("unable to convert %s to udp port", str_port);
+        return;
+      }
+
+      if (strcmp (schema_type, "app") == 0) {
+        int interval;
 
-          PERROR ("unable to convert %s to ip address", str_addr);
+        // Gets heartbeat interval for update
+        if (str_interval == NULL) {
+
+          PERROR ("unable to find heartbeat interval");
           return;
         }
-
-        // Gets the ip port
-        clinfo.port = strtol (str_port, &endptr, 10);
+        interval =  strtol (str_interval, &endptr, 10);
         if (endptr == NULL) {
 
-          PERROR ("unable to convert %s to udp port", str_port);
+          PERROR ("unable to convert %s to heartbeat interval", str_interval);
           return;
         }
 
-        if (strcmp (gxPLMessageSchemaTypeGet (message), "app") == 0) {
-          int interval;
-          const char * str_interval;
+        client = pvVectorFindFirst (&hub->clients, &clinfo);
+        if (client == NULL) {
 
-          // Gets heartbeat interval for update
-          str_interval = gxPLMessagePairGet (message, "interval");
-          interval =  strtol (str_interval, &endptr, 10);
-          if (endptr == NULL) {
+          // New client
+          client = calloc (1, sizeof (gxPLHubClient));
+          assert (client);
 
-            PERROR ("unable to convert %s to heartbeat interval", str_interval);
-            return;
-          }
+          // Copies address and port for this client
+          memcpy (&client->addr, &clinfo, sizeof (clinfo));
+          client->hub = hub;
+          gxPLTimerInit (&client->expiry, prvClientTimeout, client);
 
-          client = pvVectorFindFirst (&hub->clients, &clinfo);
-          if (client == NULL) {
+          // then adds to the list
+          if (iVectorAppend (&hub->clients, client) != 0) {
 
-            // New client
-            client = calloc (1, sizeof (gxPLHubClient));
-            assert (client);
+            PERROR ("unable to append client");
+            free (client);
+            return;
+          }
+          PINFO ("add application %s:%s, processing %d applications",
+                str_addr, str_port,
+                iVectorSize (&hub->clients));
+        }
 
-            // Copies address and port for this client
-            memcpy (&client->addr, &clinfo, sizeof (clinfo));
+        if ( (source) && (gxPLIdCmp (&client->id, source) != 0)) {
 
-            // then adds to the list
-            if (iVectorAppend (&hub->clients, client) != 0) {
+          // the application may have changed its instance id
+          if (client->id.vendor[0]) {
 
-              PERROR ("unable to append client");
-              free (client);
-              return;
-            }
-            PINFO ("add application %s:%s, processing %d applications",
-                  str_addr, str_port,
-                  iVectorSize (&hub->clients));
+            (void) gxPLHashRemove (&hub->client_index, &client->node);
           }
-
-          client->hbeat_period_max = interval * 60 * 2 + 60;
-          client->hbeat_last = now;
+          memcpy (&client->id, source, sizeof (gxPLId));
+          gxPLHashAdd (&hub->client_index, &client->node, gxPLHashId (source));
         }
-        else if (strcmp (gxPLMessageSchemaTypeGet (message), "end") == 0) {
-          int c = iVectorFindFirstIndex (&hub->clients, &clinfo);
+        client->hbeat_period_max = interval * 60 * 2 + 60;
+        gxPLTimerStart (gxPLAppTimerWheel (hub->app), &client->expiry,
+                        client->hbeat_period_max * 1000UL);
+      }
+      else if (strcmp (schema_type, "end") == 0) {
+        int c = iVectorFindFirstIndex (&hub->clients, &clinfo);
 
-          if (c >= 0) {
+        if (c >= 0) {
 
-            iVectorRemove (&hub->clients, c);
-            PINFO ("remove application %s:%s after receiving his"
-                  " heartbeat end , processing %d applications",
-                  str_addr, str_port,
-                  iVectorSize (&hub->clients));
-          }
+          iVectorRemove (&hub->clients, c);
+          PINFO ("remove application %s:%s after receiving his"
+                " heartbeat end , processing %d applications",
+                str_addr, str_port,
+                iVectorSize (&hub->clients));
         }
       }
-      // If the address does not match any local addresses, the packet moves on
-      // to the delivery/rebroadcast step.
     }
+    // If the address does not match any local addresses, the packet moves on
+    // to the delivery/rebroadcast step.
   }
+}
 
-  // Deliver/Rebroadcast those messages to all xPL applications on the same computer
-  for (int i = 0; i < iVectorSize (&hub->clients); i++) {
+/* -----------------------------------------------------------------------------
+ * Deliver/Rebroadcast a datagram to all xPL applications on the same computer,
+ * with a single operation of the io layer */
+static void
+prvDeliver (gxPLHub * hub, const char * buffer, int size) {
+  int n = iVectorSize (&hub->clients);
+
+  if (n > hub->dest_max) {
 
+    hub->dest = realloc (hub->dest, n * sizeof (gxPLIoAddr *));
+    assert (hub->dest);
+    hub->dest_max = n;
+  }
+
+  for (int i = 0; i < n; i++) {
     gxPLHubClient * client = pvVectorGet (&hub->clients, i);
-    gxPLAppSendMessage (hub->app, message, &client->addr);
+
+    hub->dest[i] = &client->addr;
+  }
+
+  if (n > 0) {
+
+    (void) gxPLAppSendRawMulti (hub->app, buffer, size, hub->dest, n);
   }
 }
 
+/* -----------------------------------------------------------------------------
+ * Returns the local application whose heartbeats have this source, NULL if
+ * none */
+static gxPLHubClient *
+prvClientFind (gxPLHub * hub, const gxPLId * source) {
+  gxPLHashNode * node = gxPLHashFind (&hub->client_index, gxPLHashId (source),
+                                      source, prvClientIdMatch);
+
+  return (node) ? gxPLHashEntry (node, gxPLHubClient, node) : NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * Delivers the status of the device targeted by a request to the local
+ * application that sent it if the state cache has a fresh one, returns true
+ * if the request has been answered */
+static int
+prvAnswerFromCache (gxPLHub * hub, const gxPLMessage * message) {
+  const char * device;
+  gxPLHubClient * client;
+  gxPLMessage * status;
+  unsigned long age;
+  int answered = 0;
+
+  if ( (gxPLMessageTypeGet (message) != gxPLMessageCommand) ||
+       (gxPLMessageSchemaTypeToken (message) != gxPLTokenRequest) ||
+       (gxPLMessageIsBroadcast (message))) {
+
+    return 0;
+  }
+
+  device = gxPLMessagePairGet (message, "device");
+  if (device == NULL) {
+
+    return 0;
+  }
+
+  // a requester on another computer does not receive the deliveries of the
+  // hub, its request is delivered as is
+  client = prvClientFind (hub, gxPLMessageSourceIdGet (message));
+  if (client == NULL) {
+
+    return 0;
+  }
+
+  status = gxPLAppStateCacheGet (hub->app, gxPLMessageTargetIdGet (message),
+                                 gxPLMessageSchemaClassGet (message),
+                                 hub->reply_type, device, &age);
+  if (status) {
+
+    if (age <= (unsigned long) hub->cache_max_age) {
+      // the status is shared with the cache, it is formatted on the stack, a
+      // status too large is not answered
+      char buf[DEFAULT_SEND_BUFSIZE];
+      int len = gxPLMessageToBuffer (status, buf, sizeof (buf));
+
+      if (len > 0) {
+
+        // the status is the one sent by the device, only the requester
+        // receives it
+        (void) gxPLAppSendRaw (hub->app, buf, len, &client->addr);
+        answered = 1;
+      }
+    }
+    gxPLMessageDelete (status);
+  }
+  return answered;
+}
+
+// --------------------------------------------------------------------------
+// Receive xPL network messages
+static void
+prvHandleMessage (gxPLApplication * app, gxPLMessage * message, void * udata) {
+  gxPLHub * hub = (gxPLHub *) udata;
+
+  int class_token = gxPLMessageSchemaClassToken (message);
+
+  if ( (class_token == gxPLTokenHbeat) || (class_token == gxPLTokenConfig)) {
+
+    // When the hub receives a hbeat.app or config.app message
+    // the hub should extract the "remote-ip" value from the message body
+    prvClientUpdate (hub, gxPLMessageSourceIdGet (message),
+                     gxPLMessageSchemaTypeGet (message),
+                     gxPLMessagePairGet (message, "remote-ip"),
+                     gxPLMessagePairGet (message, "port"),
+                     gxPLMessagePairGet (message, "interval"));
+  }
+
+  // Deliver/Rebroadcast those messages to all xPL applications on the same computer
+  if ( (iVectorSize (&hub->clients) > 0) &&
+       ( (hub->cache_max_age == 0) || (prvAnswerFromCache (hub, message) == 0))) {
+    int size;
+    const char * str = gxPLMessageStringGet (message, &size);
+
+    if (str) {
+
+      prvDeliver (hub, str, size);
+    }
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Checks if the token of len characters is equal to str */
+static int
+prvTokenIs (const char * token, int len, const char * str) {
+
+  return (len == strlen (str)) && (strncmp (token, str, len) == 0);
+}
+
+/* -----------------------------------------------------------------------------
+ * Copies the value of the line name=value ended by end, if name matches */
+static int
+prvLineValueGet (const char * line, const char * end, const char * name,
+                 char * value, int size) {
+  int len = strlen (name);
+
+  if ( (end - line > len) && (line[len] == '=') &&
+       (strncmp (line, name, len) == 0)) {
+
+    len = end - line - len - 1;
+    if (len < size) {
+
+      memcpy (value, end - len, len);
+      value[len] = '\0';
+      return true;
+    }
+  }
+  return false;
+}
+
+// --------------------------------------------------------------------------
+// Receive xPL network datagrams, forward only mode
+static int
+prvHandleDatagram (gxPLApplication * app, const char * buffer, int size,
+                   void * udata) {
+  gxPLHub * hub = (gxPLHub *) udata;
+  const char * schema;
+  const char * dot;
+  const char * p;
+
+  // only the header block and the schema line are scanned
+  if ( (strncmp (buffer, "xpl-", 4) != 0) ||
+       ( (p = strstr (buffer, "\n}\n")) == NULL)) {
+
+    // left to the decoder, that rejects it
+    return false;
+  }
+  schema = p + 3;
+  if ( ( (p = strchr (schema, '\n')) == NULL) || (strncmp (p, "\n{\n", 3) != 0) ||
+       ( (dot = memchr (schema, '.', p - schema)) == NULL)) {
+
+    return false;
+  }
+
+  if (prvTokenIs (schema, dot - schema, "hbeat") ||
+      prvTokenIs (schema, dot - schema, "config")) {
+    char type[GXPL_TYPE_MAX + 1];
+    char str_addr[64] = "";
+    char str_port[8] = "";
+    char str_interval[8] = "";
+    const char * line = p + 3;
+    const char * end;
+
+    if (p - dot - 1 > GXPL_TYPE_MAX) {
+
+      return false;
+    }
+    memcpy (type, dot + 1, p - dot - 1);
+    type[p - dot - 1] = '\0';
+
+    // the body is scanned for the fields needed by the discovery
+    while ( ( (end = strchr (line, '\n')) != NULL) && (*line != '}')) {
+
+      if (!prvLineValueGet (line, end, "remote-ip", str_addr, sizeof (str_addr)) &&
+          !prvLineValueGet (line, end, "port", str_port, sizeof (str_port))) {
+
+        (void) prvLineValueGet (line, end, "interval", str_interval,
+                                sizeof (str_interval));
+      }
+      line = end + 1;
+    }
+
+    prvClientUpdate (hub, NULL, type,
+                     str_addr[0] ? str_addr : NULL,
+                     str_port[0] ? str_port : NULL,
+                     str_interval[0] ? str_interval : NULL);
+  }
+
+  // Deliver/Rebroadcast the datagram as is
+  prvDeliver (hub, buffer, size);
+  return true;
+}
+
 /* public api functions ===================================================== */
 
 // -----------------------------------------------------------------------------
@@ -162,10 +430,23 @@ gxPLHubOpen (gxPLSetting * setting) {
   hub->app = gxPLAppOpen (setting);
   if (hub->app) {
 
-    if (iVectorInit (&hub->clients, 1, NULL, free) == 0) {
+    if ( (gxPLHashInit (&hub->client_index, DEFAULT_HUB_HASH_SIZE) == 0) &&
+         (iVectorInit (&hub->clients, 1, NULL, prvClientDelete) == 0)) {
       if (iVectorInitSearch (&hub->clients, prvClientKey, prvClientMatch) == 0) {
-        // Add a listener for all xPL messages
-        if (gxPLMessageListenerAdd (hub->app, prvHandleMessage, hub) == 0) {
+        int ret;
+
+        if (setting->forward) {
+
+          // the datagrams are relayed without being decoded
+          ret = gxPLAppRawListenerSet (hub->app, prvHandleDatagram, hub);
+        }
+        else {
+
+          // Add a listener for all xPL messages
+          ret = gxPLMessageListenerAddSync (hub->app, prvHandleMessage, hub);
+        }
+
+        if (ret == 0) {
 
           hub->local_addr_list = gxPLIoLocalAddrList (hub->app);
           return hub;
@@ -174,6 +455,7 @@ gxPLHubOpen (gxPLSetting * setting) {
     }
   }
   PERROR ("unable to open hub");
+  gxPLHashDestroy (&hub->client_index);
   free (hub);
   return NULL;
 }
@@ -184,8 +466,11 @@ gxPLHubClose (gxPLHub * hub) {
 
   if (hub) {
 
-    int ret = gxPLAppClose (hub->app);
+    // the clients are released before the timers of the application
     vVectorDestroy (&hub->clients);
+    gxPLHashDestroy (&hub->client_index);
+    int ret = gxPLAppClose (hub->app);
+    free (hub->dest);
     free (hub);
     return ret;
   }
@@ -197,33 +482,48 @@ int
 gxPLHubPoll (gxPLHub * hub, int timeout_ms) {
   int ret;
 
+  // the clients expiry is managed by the timers of the application
   ret = gxPLAppPoll (hub->app, timeout_ms);
-  hub->timeout += timeout_ms;
-
-  if (hub->timeout >= 60000) {
-    long now;
-
-    // Track known local xPL applications and determine when they have died and
-    // remove them from the list of local applications
-    hub->timeout = 0;
-    now = gxPLTime();
-    for (int i = 0; i < iVectorSize (&hub->clients); i++) {
-      gxPLHubClient * client = pvVectorGet (&hub->clients, i);
-
-      if ( (now - client->hbeat_last) > client->hbeat_period_max) {
-        char * str;
-        if (gxPLIoCtl (hub->app, gxPLIoFuncNetAddrToString, &client->addr, &str) == 0) {
-
-          PINFO ("remove application %s:%d after heartbeat timeout, "
-                "processing %d applications",
-                str, client->addr.port,
-                iVectorSize (&hub->clients) - 1);
-        }
-        iVectorRemove (&hub->clients, i);
-      }
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLHubStateCacheEnable (gxPLHub * hub, int size, int max_age_ms,
+                         const char * reply_type) {
+  gxPLSchema schema;
+
+  if (gxPLAppSetting (hub->app)->forward) {
+
+    errno = ENOSYS;
+    return -1;
+  }
+
+  if (max_age_ms > 0) {
+
+    if (gxPLSchemaTypeSet (&schema, (reply_type) ? reply_type : "basic") != 0) {
+
+      errno = EINVAL;
+      return -1;
     }
+    strcpy (hub->reply_type, schema.type);
   }
-  return ret;
+
+  if (max_age_ms <= 0) {
+
+    hub->cache_max_age = 0;
+    return gxPLAppStateCacheClose (hub->app);
+  }
+
+  if (hub->cache_max_age == 0) {
+
+    if (gxPLAppStateCacheOpen (hub->app, size) != 0) {
+
+      return -1;
+    }
+  }
+  hub->cache_max_age = max_age_ms;
+  return 0;
 }
 
 // -----------------------------------------------------------------------------
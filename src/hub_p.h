@@ -10,6 +10,7 @@
 #define _GXPL_HUB_PRIVATE_HEADER_
 
 #include <gxPL/defs.h>
+#include "internal_p.h"
 
 /* structures =============================================================== */
 
@@ -18,9 +19,12 @@
  */
 typedef struct _gxPLHubClient {
   
+  gxPLHashNode node; /**< indexed by id, if not empty */
   gxPLIoAddr addr;
+  gxPLId id; /**< source of the heartbeats, empty in forward only mode */
   int hbeat_period_max; /**< (hbeat_interval * 2 + 60) */
-  long hbeat_last;
+  gxPLTimer expiry; /**< restarted on each heartbeat received */
+  struct _gxPLHub * hub;
 } gxPLHubClient;
 
 /**
@@ -29,8 +33,12 @@ typedef struct _gxPLHubClient {
 typedef struct _gxPLHub {
   gxPLApplication * app;
   xVector clients;
+  gxPLHash client_index; /**< clients indexed by the source of their heartbeats */
   const xVector * local_addr_list;
-  long timeout;
+  const gxPLIoAddr ** dest; /**< addresses of the clients for the delivery */
+  int dest_max;
+  int cache_max_age; /**< in ms, 0 if the requests are not answered by the hub */
+  char reply_type[GXPL_TYPE_MAX + 1]; /**< schema type of the answers */
 } gxPLHub;
 
 /* ========================================================================== */
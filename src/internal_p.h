@@ -10,6 +10,10 @@
 #define _GXPL_INTERNAL_PRIVATE_HEADER_
 
 #include <gxPL.h>
+#include "timer_p.h"
+#include "hash_p.h"
+#include "filter_p.h"
+#include "token_p.h"
 
 __BEGIN_C_DECLS
 /* ========================================================================== */
@@ -69,6 +73,172 @@ void gxPLDeviceMessageHandler (gxPLDevice * device, gxPLMessage * message,
  */
 int gxPLDeviceHeartbeatSend (gxPLDevice * device, gxPLHeartbeatType type);
 
+/**
+ * @brief Timer wheel of an application
+ *
+ * Used by the devices, the hub and the bridge to schedule their timers.
+ * @param app
+ * @return pointer on the wheel
+ */
+gxPLTimerWheel * gxPLAppTimerWheel (gxPLApplication * app);
+
+/**
+ * @brief Filter engine of an application
+ *
+ * Contains the compiled filters of all devices of the application.
+ * @param app
+ * @return pointer on the engine
+ */
+gxPLFilterEngine * gxPLAppFilterEngine (gxPLApplication * app);
+
+/**
+ * @brief Time of an application
+ *
+ * Monotonic time in milliseconds read once per poll, after waiting for the
+ * network. It must be used for all protocol delays.
+ * @param app
+ * @return time in milliseconds
+ */
+unsigned long gxPLAppTimeMs (const gxPLApplication * app);
+
+/**
+ * @brief Updates the device registry after a change of the identifier of
+ * a device
+ * @param app
+ * @param device
+ * @param old_id identifier before the change
+ */
+void gxPLAppDeviceIdChanged (gxPLApplication * app, gxPLDevice * device,
+                             const gxPLId * old_id);
+
+/**
+ * @brief Adds a device to the members of a group of its application
+ *
+ * A device already member is not added again.
+ * @param app
+ * @param device
+ * @param name name of the group
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppGroupJoin (gxPLApplication * app, gxPLDevice * device,
+                      const char * name);
+
+/**
+ * @brief Removes a device from the members of a group of its application
+ * @param app
+ * @param device
+ * @param name name of the group
+ */
+void gxPLAppGroupLeave (gxPLApplication * app, gxPLDevice * device,
+                        const char * name);
+
+/**
+ * @brief Creates a new empty message, like gxPLMessageNew()
+ * @param allocator provides the memory of the message, the heap if NULL
+ * @param type
+ * @return the message, NULL if an error occurs
+ */
+gxPLMessage * gxPLMessageAllocNew (gxPLAllocator * allocator,
+                                   gxPLMessageType type);
+
+/**
+ * @brief Decodes a message in place, like gxPLMessageFromBuffer()
+ * @param allocator provides the memory of the message, the buffer has been
+ * allocated by it with gxPLAllocatorAlloc(). If NULL, the heap is used and
+ * the buffer has been allocated with malloc().
+ * @param buffer
+ * @return the message, NULL if an error occurs
+ */
+gxPLMessage * gxPLMessageAllocFromBuffer (gxPLAllocator * allocator,
+                                          char * buffer);
+
+/**
+ * @brief Tokens of the header of a message
+ *
+ * The tokens of a message received are computed when it is decoded, the
+ * others on the first call after a change.
+ * @param message
+ * @return the token, GXPL_TOKEN_NONE if an error occurs
+ */
+int gxPLMessageSchemaClassToken (const gxPLMessage * message);
+int gxPLMessageSchemaTypeToken (const gxPLMessage * message);
+int gxPLMessageSourceToken (const gxPLMessage * message);
+int gxPLMessageTargetToken (const gxPLMessage * message);
+
+/**
+ * @brief Prepares a message to be read by several threads
+ *
+ * Computes the tokens, the index and the body view that the read functions
+ * compute on their first call, so that they no longer modify the message.
+ * @param message
+ * @return 0, -1 if an error occurs
+ */
+int gxPLMessageShare (gxPLMessage * message);
+
+/**
+ * @brief Function called for each datagram received, before decoding
+ * @param app
+ * @param buffer null-terminated datagram, it must not be modified
+ * @param size number of bytes of the datagram
+ * @param udata
+ * @return true if the datagram has been processed and must not be decoded
+ */
+typedef int (*gxPLRawListener) (gxPLApplication * app, const char * buffer,
+                                int size, void * udata);
+
+/**
+ * @brief Sets the function called for each datagram received
+ * @param app
+ * @param listener NULL to remove
+ * @param udata
+ * @return 0, -1 if an error occurs
+ */
+int gxPLAppRawListenerSet (gxPLApplication * app, gxPLRawListener listener,
+                           void * udata);
+
+/**
+ * @brief Sends a datagram as is
+ * @param app
+ * @param buffer
+ * @param count number of bytes
+ * @param client destination, NULL for broadcast
+ * @return number of bytes sent, -1 if an error occurs
+ */
+int gxPLAppSendRaw (gxPLApplication * app, const char * buffer, int count,
+                    const gxPLIoAddr * client);
+
+/**
+ * @brief Sends a datagram as is to several clients
+ *
+ * A single operation of the io layer is used if it is supported
+ * (gxPLIoSendMulti).
+ * @param app
+ * @param buffer
+ * @param count number of bytes
+ * @param clients array of destinations
+ * @param nclients number of destinations
+ * @return number of destinations reached, -1 if an error occurs
+ */
+int gxPLAppSendRawMulti (gxPLApplication * app, const char * buffer, int count,
+                         const gxPLIoAddr * const * clients, int nclients);
+
+/**
+ * @brief Sends a message with the text cached by the message
+ *
+ * The text is formatted by gxPLMessageStringGet() on the first send and kept
+ * until the message is modified, the message must not be shared with other
+ * threads: this is used for the messages of the library sent again and again
+ * by the thread that polls the application, as the heartbeats.
+ * gxPLAppSendMessage() formats the messages that may be shared in a buffer
+ * of the caller each time.
+ * @param app
+ * @param message
+ * @param client destination, NULL for broadcast
+ * @return number of bytes sent, -1 if an error occurs
+ */
+int gxPLAppSendCachedMessage (gxPLApplication * app, gxPLMessage * message,
+                              const gxPLIoAddr * client);
+
 /**
  * @brief
  * @param setting
@@ -77,6 +247,125 @@ int gxPLDeviceHeartbeatSend (gxPLDevice * device, gxPLHeartbeatType type);
  */
 void gxPLParseCommonArgs (gxPLSetting * setting, int argc, char *argv[]);
 
+/**
+ * @brief Adds a listener of the library to an application
+ *
+ * Unlike gxPLMessageListenerAdd(), the listener is always called by the
+ * thread that polls the application, even if workers are started, and before
+ * the listeners of the user. The devices of the application are dispatched
+ * by the first of them: the listeners added after can modify the message
+ * only if the application has no worker or no device.
+ * @param app
+ * @param listener
+ * @param udata
+ * @return 0, -1 if an error occurs
+ */
+int gxPLMessageListenerAddSync (gxPLApplication * app,
+                                gxPLMessageListener listener, void * udata);
+
+/**
+ * @brief Adds a listener of the library to a device
+ *
+ * Like gxPLMessageListenerAddSync(), for gxPLDeviceListenerAdd().
+ * @return 0, -1 if an error occurs
+ */
+int gxPLDeviceListenerAddSync (gxPLDevice * device,
+                               gxPLDeviceListener listener,
+                               gxPLMessageType type,
+                               char * schema_class, char * schema_type,
+                               void * udata);
+
+typedef struct _gxPLRequestTable gxPLRequestTable;
+typedef struct _gxPLDirectory gxPLDirectory;
+typedef struct _gxPLStateCache gxPLStateCache;
+
+/**
+ * @brief Releases the requests of an application
+ *
+ * The functions of the requests waiting are called without reply.
+ * @param app
+ */
+void gxPLRequestTableDelete (gxPLApplication * app);
+
+/**
+ * @brief Calls the listeners of the user of a device, from a worker
+ * @param device
+ * @param message
+ */
+void gxPLDeviceDispatchDeferred (gxPLDevice * device, gxPLMessage * message);
+
+#if CONFIG_THREAD_SAFE
+typedef struct _gxPLWorkerPool gxPLWorkerPool;
+
+/**
+ * @brief Hands a message over to a worker of an application
+ *
+ * The messages posted with the same key are processed in order by the same
+ * worker. A reference to the message is held until it is processed. Between
+ * gxPLWorkersHold() and gxPLWorkersRelease(), the jobs are kept by the pool.
+ * @param app
+ * @param key number of the device, or hash of the source of the message
+ * @param device the listeners of the user of this device are called, if not NULL
+ * @param func listener of the application called if device is NULL
+ * @param udata
+ * @param message
+ * @return 0, -1 if the message has not been posted (no worker started)
+ */
+int gxPLWorkersPost (gxPLApplication * app, int key, gxPLDevice * device,
+                     gxPLMessageListener func, void * udata,
+                     gxPLMessage * message);
+
+/**
+ * @brief Keeps the jobs posted until gxPLWorkersRelease()
+ *
+ * Called before the listeners of the library, which may still modify the
+ * message after a device posted it.
+ * @param app
+ */
+void gxPLWorkersHold (gxPLApplication * app);
+
+/**
+ * @brief Hands the jobs kept over to the workers
+ *
+ * The messages are prepared to be read by the workers first.
+ * @param app
+ */
+void gxPLWorkersRelease (gxPLApplication * app);
+
+/**
+ * @brief Waits for all the messages posted to be processed
+ *
+ * Called before modifying the listeners or deleting a device, does nothing
+ * if called by a worker.
+ * @param app
+ */
+void gxPLWorkersDrain (gxPLApplication * app);
+typedef struct _gxPLSendQueue gxPLSendQueue;
+
+/**
+ * @brief Sends the messages of the send queue of an application
+ *
+ * Called by the poll, does nothing if the queue is not opened.
+ * @param app
+ * @return number of messages removed from the queue
+ */
+int gxPLSendQueueDrain (gxPLApplication * app);
+
+/**
+ * @brief Descriptor readable when messages are added to the send queue
+ * @param app
+ * @return the descriptor, -1 if none
+ */
+int gxPLSendQueueFd (const gxPLApplication * app);
+#else
+#define gxPLWorkersPost(app,key,device,func,udata,message) (-1)
+#define gxPLWorkersHold(app)
+#define gxPLWorkersRelease(app)
+#define gxPLWorkersDrain(app)
+#define gxPLSendQueueDrain(app) (0)
+#define gxPLSendQueueFd(app) (-1)
+#endif /* CONFIG_THREAD_SAFE */
+
 /* ========================================================================== */
 __END_C_DECLS
 #endif /* _GXPL_INTERNAL_PRIVATE_HEADER_ defined */
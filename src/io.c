@@ -108,6 +108,18 @@ gxPLIoRecv (gxPLIo * io, void * buffer, int count, gxPLIoAddr * source) {
   return io->ops->recv (io, buffer, count, source);
 }
 
+// -----------------------------------------------------------------------------
+int
+gxPLIoRecvBuffer (gxPLIo * io, char ** buffer, gxPLAllocator ** allocator) {
+
+  if (io->ops->recvbuf) {
+
+    return io->ops->recvbuf (io, buffer, allocator);
+  }
+  errno = ENOSYS;
+  return -1;
+}
+
 // -----------------------------------------------------------------------------
 int
 gxPLIoSend (gxPLIo * io, const void * buffer, int count, gxPLIoAddr * target) {
@@ -115,6 +127,42 @@ gxPLIoSend (gxPLIo * io, const void * buffer, int count, gxPLIoAddr * target) {
   return io->ops->send (io, buffer, count, target);
 }
 
+// -----------------------------------------------------------------------------
+int
+gxPLIoSendMulti (gxPLIo * io, const void * buffer, int count,
+                 const gxPLIoAddr * const * targets, int ntargets) {
+
+  if (io->ops->sendmulti) {
+
+    return io->ops->sendmulti (io, buffer, count, targets, ntargets);
+  }
+  else {
+    int sent = 0;
+
+    for (int i = 0; i < ntargets; i++) {
+
+      if (io->ops->send (io, buffer, count, targets[i]) >= 0) {
+
+        sent++;
+      }
+    }
+    return ( (sent == 0) && (ntargets > 0)) ? -1 : sent;
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLIoSendv (gxPLIo * io, const gxPLIoVec * iov, int iovcnt,
+             const gxPLIoAddr * target) {
+
+  if (io->ops->sendv) {
+
+    return io->ops->sendv (io, iov, iovcnt, target);
+  }
+  errno = ENOSYS;
+  return -1;
+}
+
 // -----------------------------------------------------------------------------
 int
 gxPLIoIoCtl (gxPLIo * io, int c, va_list ap) {
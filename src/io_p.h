@@ -42,6 +42,14 @@ typedef struct _gxPLIoOps {
   int (*open)   (gxPLIo * io);
   int (*recv)   (gxPLIo * io, void * buffer, int count, gxPLIoAddr * source);
   int (*send)   (gxPLIo * io, const void * buffer, int count, const gxPLIoAddr * target);
+  /* optional, NULL if the layer does not keep its receive buffers */
+  int (*recvbuf) (gxPLIo * io, char ** buffer, gxPLAllocator ** allocator);
+  /* optional, NULL if the layer can not send to several targets at once */
+  int (*sendmulti) (gxPLIo * io, const void * buffer, int count,
+                    const gxPLIoAddr * const * targets, int ntargets);
+  /* optional, NULL if the layer needs a contiguous frame */
+  int (*sendv) (gxPLIo * io, const gxPLIoVec * iov, int iovcnt,
+                const gxPLIoAddr * target);
   int (*close)  (gxPLIo * io);
   int (*ctl)    (gxPLIo * io, int c, va_list ap);
 } gxPLIoOps;
@@ -0,0 +1,62 @@
+/**
+ * @file
+ * Locks of the state shared by the applications, internal include
+ *
+ * The library keeps a few process-wide objects: the table of the interned
+ * strings and the counters of the heap allocator. When CONFIG_THREAD_SAFE is
+ * set, they are protected by the primitives below, otherwise these primitives
+ * do nothing.
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_LOCK_PRIVATE_HEADER_
+#define _GXPL_LOCK_PRIVATE_HEADER_
+
+#include <gxPL/defs.h>
+#if CONFIG_THREAD_SAFE
+#include <pthread.h>
+#endif
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+#if CONFIG_THREAD_SAFE
+/* structures =============================================================== */
+typedef pthread_mutex_t gxPLMutex;
+
+/* constants ================================================================ */
+#define GXPL_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+/* macros =================================================================== */
+#define gxPLMutexInit(m)      pthread_mutex_init ((m), NULL)
+#define gxPLMutexDestroy(m)   pthread_mutex_destroy (m)
+#define gxPLMutexLock(m)      pthread_mutex_lock (m)
+#define gxPLMutexUnlock(m)    pthread_mutex_unlock (m)
+// adds v to the integer pointed to by p
+#define gxPLAtomicAdd(p,v)    __atomic_add_fetch ((p), (v), __ATOMIC_RELAXED)
+#define gxPLAtomicGet(p)      __atomic_load_n ((p), __ATOMIC_RELAXED)
+// drops a reference, the accesses of the other holders are completed when the
+// new count is seen by the last one
+#define gxPLAtomicUnref(p)    __atomic_sub_fetch ((p), 1, __ATOMIC_ACQ_REL)
+
+#else /* CONFIG_THREAD_SAFE == 0 */
+/* structures =============================================================== */
+typedef int gxPLMutex;
+
+/* constants ================================================================ */
+#define GXPL_MUTEX_INITIALIZER 0
+
+/* macros =================================================================== */
+#define gxPLMutexInit(m)      ((void) (m))
+#define gxPLMutexDestroy(m)   ((void) (m))
+#define gxPLMutexLock(m)      ((void) (m))
+#define gxPLMutexUnlock(m)    ((void) (m))
+#define gxPLAtomicAdd(p,v)    (*(p) += (v))
+#define gxPLAtomicGet(p)      (*(p))
+#define gxPLAtomicUnref(p)    (--*(p))
+#endif /* CONFIG_THREAD_SAFE == 0 */
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_LOCK_PRIVATE_HEADER_ defined */
@@ -16,80 +16,564 @@
 
 #include <gxPL/util.h>
 #include "message_p.h"
+#include "internal_p.h"
+#include "lock_p.h"
 
 /* constants ================================================================ */
-#ifndef DEFAULT_ALLOC_STR_GROW
-#define DEFAULT_ALLOC_STR_GROW  256
+// the body is indexed from this number of pairs
+#ifndef DEFAULT_PAIR_INDEX_MIN
+#define DEFAULT_PAIR_INDEX_MIN  8
 #endif
 
 /* private functions ======================================================== */
 
 // -----------------------------------------------------------------------------
 static int
-prvStrPrintf (char ** buf, int * buf_size, int index, const char * format, ...) {
-  va_list ap;
-  int buf_free = *buf_size - index - 1;
-  int size;
+prvIntLen (int value) {
+  int len = (value < 0) ? 2 : 1;
 
-  va_start (ap, format);
-  // trying to write the string in the buffer...
-  size = vsnprintf (& (*buf) [index], buf_free, format, ap);
+  while ( (value >= 10) || (value <= -10)) {
+
+    value /= 10;
+    len++;
+  }
+  return len;
+}
 
-  while (size >= buf_free) {
+/* -----------------------------------------------------------------------------
+ * Writes an integer in decimal, without printf, returns the end of the text */
+static char *
+prvIntPut (char * p, int value) {
+  unsigned int u = (value < 0) ? - (unsigned int) value : (unsigned int) value;
+  int len = prvIntLen (value);
 
-    // the buffer is too small, it reallocates memory...
-    *buf_size += DEFAULT_ALLOC_STR_GROW;
-    buf_free  += DEFAULT_ALLOC_STR_GROW;
-    *buf = realloc (*buf, *buf_size);
-    assert (buf);
+  if (value < 0) {
 
-    //  and try again !
-    va_end (ap);
-    va_start (ap, format);
-    size = vsnprintf (& (*buf) [index], buf_free, format, ap);
+    *p = '-';
   }
+  for (char * q = p + len - 1; q >= p + (value < 0); q--) {
 
-  va_end (ap);
-  return size;
+    *q = '0' + u % 10;
+    u /= 10;
+  }
+  return p + len;
 }
 
 // -----------------------------------------------------------------------------
-static gxPLPair *
-prvPairFromLine (char ** line) {
+static char *
+prvStrPut (char * p, const char * str) {
+  size_t len = strlen (str);
+
+  memcpy (p, str, len);
+  return p + len;
+}
+
+// -----------------------------------------------------------------------------
+static gxPLIoVec *
+prvIoVecPut (gxPLIoVec * iov, const char * str) {
+
+  iov->base = str;
+  iov->len = strlen (str);
+  return iov + 1;
+}
+
+// -----------------------------------------------------------------------------
+static gxPLIoVec *
+prvIoVecId (gxPLIoVec * iov, const gxPLId * id) {
+
+  iov = prvIoVecPut (iov, id->vendor);
+  iov = prvIoVecPut (iov, "-");
+  iov = prvIoVecPut (iov, id->device);
+  iov = prvIoVecPut (iov, ".");
+  return prvIoVecPut (iov, id->instance);
+}
+
+/* -----------------------------------------------------------------------------
+ * Beginning of the text of a message, up to the value of hop */
+static const char *
+prvTypeHead (gxPLMessageType type) {
+
+  switch (type) {
+    case gxPLMessageAny:
+      return "*\n{\nhop=";
+
+    case gxPLMessageCommand:
+      return "xpl-cmnd\n{\nhop=";
+
+    case gxPLMessageStatus:
+      return "xpl-stat\n{\nhop=";
+
+    case gxPLMessageTrigger:
+      return "xpl-trig\n{\nhop=";
+
+    default:
+      break;
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvIdLen (const gxPLId * id) {
+
+  return strlen (id->vendor) + strlen (id->device) + strlen (id->instance) + 2;
+}
+
+// -----------------------------------------------------------------------------
+static char *
+prvIdPut (char * p, const gxPLId * id) {
+
+  p = prvStrPut (p, id->vendor);
+  *p++ = '-';
+  p = prvStrPut (p, id->device);
+  *p++ = '.';
+  return prvStrPut (p, id->instance);
+}
+
+// -----------------------------------------------------------------------------
+// Splits the next line in a name/value pair, without copy (name=value\n)
+static int
+prvPairSplitLine (char ** line, gxPLPair * pair) {
   char * p = strsep (line, "\n");
 
   if (*line) {
     // line found
-    gxPLPair * pair = gxPLPairFromString (p);
-    if (pair) {
-      return pair;
+    char * value = p;
+
+    pair->name = strsep (&value, "=");
+    if (value) {
+
+      pair->value = value;
+      return 0;
     }
     PWARNING ("unable to find a '=' in this line: %s", p);
   }
-  return NULL;
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+// Allocates a pair on the heap and copies name and value
+static gxPLPair *
+prvPairNew (const char * name, const char * value) {
+  gxPLPair * p = malloc (sizeof (gxPLPair));
+  assert (p);
+
+  p->name = malloc (strlen (name) + 1);
+  assert (p->name);
+  strcpy (p->name, name);
+  p->value = malloc (strlen (value) + 1);
+  assert (p->value);
+  strcpy (p->value, value);
+  return p;
 }
 
+/* -----------------------------------------------------------------------------
+ * Allocates size bytes of text in the message, in the inline area while it
+ * is large enough, then in blocks on the heap released with the message */
+static char *
+prvTextAlloc (gxPLMessage * m, int size) {
+  char * p;
 
-/* internal public functions ================================================ */
+  if ( (m->text_used + size) <= DEFAULT_MESSAGE_INLINE_TEXT) {
+
+    p = &m->text_inline[m->text_used];
+    m->text_used += size;
+    return p;
+  }
+
+  if ( (m->text == NULL) || ( (m->text->used + size) > m->text->size)) {
+    int bsize = MAX (size, DEFAULT_MESSAGE_INLINE_TEXT);
+    gxPLTextBlock * b = gxPLAllocatorAlloc (m->alloc, sizeof (gxPLTextBlock) + bsize);
+
+    if (b == NULL) {
+
+      return NULL;
+    }
+    b->size = bsize;
+    b->used = 0;
+    b->next = m->text;
+    m->text = b;
+  }
+  p = &m->text->data[m->text->used];
+  m->text->used += size;
+  return p;
+}
 
 // -----------------------------------------------------------------------------
-gxPLMessage *
-gxPLMessageFromString (gxPLMessage * m, char * str) {
-  char *p, *line;
-  gxPLPair * pair;
+static char *
+prvTextDup (gxPLMessage * m, const char * str) {
+  char * p = prvTextAlloc (m, strlen (str) + 1);
 
-  if (strlen (str) == 0) {
+  if (p) {
 
-    PDEBUG ("empty message");
-    return m;
+    strcpy (p, str);
   }
+  return p;
+}
 
-  if (m == NULL) {
-    // New message
-    m = gxPLMessageNew (gxPLMessageAny);
-    assert (m);
-    m->isreceived = 1;
+// -----------------------------------------------------------------------------
+static void
+prvTextClear (gxPLMessage * m) {
+
+  while (m->text) {
+    gxPLTextBlock * b = m->text;
+
+    m->text = b->next;
+    gxPLAllocatorFree (m->alloc, b);
+  }
+  m->text_used = 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Releases a receive buffer, allocated with malloc() if allocator is NULL */
+static void
+prvRawFree (gxPLAllocator * allocator, char * buffer) {
+
+  if (allocator) {
+
+    gxPLAllocatorFree (allocator, buffer);
+  }
+  else {
+
+    free (buffer);
+  }
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvBodySize (const gxPLMessage * m) {
+
+  return (m->isvector) ? iVectorSize (&m->body) : m->pair_count;
+}
+
+// -----------------------------------------------------------------------------
+static gxPLPair *
+prvBodyAt (const gxPLMessage * m, int i) {
+
+  return (m->isvector) ? pvVectorGet (&m->body, i) : &m->pair[i];
+}
+
+/* -----------------------------------------------------------------------------
+ * Makes room for n more pairs, the inline pairs are moved on the heap when
+ * they are exceeded */
+static int
+prvBodyReserve (gxPLMessage * m, int n) {
+
+  if ( (m->pair_count + n) > m->pair_max) {
+    int max = MAX (m->pair_max * 2, m->pair_count + n);
+    gxPLPair * pair;
+
+    if (m->pair == m->pair_inline) {
+
+      pair = gxPLAllocatorAlloc (m->alloc, max * sizeof (gxPLPair));
+      if (pair) {
+
+        memcpy (pair, m->pair, m->pair_count * sizeof (gxPLPair));
+      }
+    }
+    else {
+
+      pair = gxPLAllocatorRealloc (m->alloc, m->pair, max * sizeof (gxPLPair));
+    }
+
+    if (pair == NULL) {
+
+      return -1;
+    }
+    m->pair = pair;
+    m->pair_max = max;
+    m->isview = 0;
+  }
+  return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Initializes the body vector, the pairs are released by the vector if
+ * destroy is not NULL */
+static int
+prvBodyVectorInit (gxPLMessage * m, int size, void (*destroy) (void *)) {
+
+  if (m->isbodyinit) {
+
+    vVectorDestroy (&m->body);
+    m->isbodyinit = 0;
+  }
+
+  if (iVectorInit (&m->body, MAX (size, 3), NULL, destroy) == 0) {
+
+    if (iVectorInitSearch (&m->body, gxPLPairKey, gxPLPairMatch) == 0) {
+
+      m->isbodyinit = 1;
+      return 0;
+    }
+    vVectorDestroy (&m->body);
+  }
+  return -1;
+}
+
+/* -----------------------------------------------------------------------------
+ * Moves the pairs on the heap in the body vector, the caller of
+ * gxPLMessageBodyGet() may modify them as it wants */
+static int
+prvBodyToVector (gxPLMessage * m) {
+
+  if (m->isvector == 0) {
+
+    if (prvBodyVectorInit (m, m->pair_count, gxPLPairDelete) != 0) {
+
+      return -1;
+    }
+
+    for (int i = 0; i < m->pair_count; i++) {
+      gxPLPair * p = prvPairNew (m->pair[i].name, m->pair[i].value);
+
+      if (iVectorAppend (&m->body, p) != 0) {
+
+        gxPLPairDelete (p);
+        (void) iVectorClear (&m->body);
+        return -1;
+      }
+    }
+
+    if (m->pair != m->pair_inline) {
+
+      gxPLAllocatorFree (m->alloc, m->pair);
+      m->pair = m->pair_inline;
+      m->pair_max = DEFAULT_MESSAGE_INLINE_PAIRS;
+    }
+    m->pair_count = 0;
+    prvTextClear (m);
+    m->isview = 0;
+    m->isvector = 1;
+  }
+  return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Releases the index of the body, it will be built again on the next lookup */
+static void
+prvIndexDrop (gxPLMessage * m) {
+
+  gxPLAllocatorFree (m->alloc, m->index);
+  m->index = NULL;
+  m->index_mask = 0;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvIndexInsert (gxPLMessage * m, int pos, unsigned long hash) {
+  unsigned long i = hash & m->index_mask;
+
+  // linear probing, the pairs with the same name stay in the order of the body
+  while (m->index[i].pos) {
+
+    i = (i + 1) & m->index_mask;
+  }
+  m->index[i].hash = hash;
+  m->index[i].pos = pos + 1;
+}
+
+/* -----------------------------------------------------------------------------
+ * Appends a pair at the end of the body. name and value are copied in the
+ * message if copy is true, otherwise they must live as long as the message
+ * (in place decoding of the receive buffer). Returns the pair, NULL if an
+ * error occurs */
+static gxPLPair *
+prvBodyAppend (gxPLMessage * m, char * name, char * value, int copy) {
+  gxPLPair * p;
+
+  if (m->isvector) {
+
+    p = prvPairNew (name, value);
+    if (iVectorAppend (&m->body, p) != 0) {
+
+      gxPLPairDelete (p);
+      return NULL;
+    }
+  }
+  else {
+
+    if (prvBodyReserve (m, 1) != 0) {
+
+      return NULL;
+    }
+    if (copy) {
+
+      name = prvTextDup (m, name);
+      value = prvTextDup (m, value);
+      if ( (name == NULL) || (value == NULL)) {
+
+        return NULL;
+      }
+    }
+    p = &m->pair[m->pair_count++];
+    p->name = name;
+    p->value = value;
+    m->isview = 0;
+  }
+
+  if (m->index) {
+    int size = prvBodySize (m);
+
+    if ( (size * 2) > m->index_mask) {
+
+      // too full, it will be built again
+      prvIndexDrop (m);
+    }
+    else {
+
+      prvIndexInsert (m, size - 1, gxPLHashStr (GXPL_HASH_INIT, name));
+    }
+  }
+  return p;
+}
+
+/* -----------------------------------------------------------------------------
+ * Builds the index of the body if it is large enough,
+ * returns 0 if the index can be used */
+static int
+prvIndexBuild (const gxPLMessage * message) {
+  gxPLMessage * m = (gxPLMessage *) message;
+  int size = prvBodySize (m);
+  int n = 16;
+
+  if (m->index) {
+
+    return 0;
+  }
+  if (size < DEFAULT_PAIR_INDEX_MIN) {
+
+    return -1;
+  }
+
+  // load factor below 1/2
+  while (n < (size * 2)) {
+
+    n <<= 1;
+  }
+  m->index = gxPLAllocatorAlloc (m->alloc, n * sizeof (gxPLPairSlot));
+  if (m->index == NULL) {
+
+    return -1;
+  }
+  memset (m->index, 0, n * sizeof (gxPLPairSlot));
+  m->index_mask = n - 1;
+
+  for (int i = 0; i < size; i++) {
+    const gxPLPair * p = prvBodyAt (m, i);
+
+    prvIndexInsert (m, i, gxPLHashStr (GXPL_HASH_INIT, p->name));
+  }
+  return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Calls func for each pair named name, stops on the first pair if func is NULL.
+ * Returns the number of pairs found, the last one in last */
+static int
+prvPairFind (const gxPLMessage * m, const char * name, gxPLPairCallback func,
+             void * udata, const gxPLPair ** last) {
+  int count = 0;
+  const gxPLPair * p;
+
+  if (prvIndexBuild (m) == 0) {
+    unsigned long hash = gxPLHashStr (GXPL_HASH_INIT, name);
+
+    for (unsigned long i = hash & m->index_mask; m->index[i].pos;
+         i = (i + 1) & m->index_mask) {
+
+      if (m->index[i].hash == hash) {
+
+        p = prvBodyAt (m, m->index[i].pos - 1);
+        if (strcmp (p->name, name) == 0) {
+
+          count++;
+          *last = p;
+          if ( (func == NULL) || (func (p, udata) != 0)) {
+
+            break;
+          }
+        }
+      }
+    }
+  }
+  else {
+
+    // small body, linear search
+    for (int i = 0; i < prvBodySize (m); i++) {
+
+      p = prvBodyAt (m, i);
+      if (strcmp (p->name, name) == 0) {
+
+        count++;
+        *last = p;
+        if ( (func == NULL) || (func (p, udata) != 0)) {
+
+          break;
+        }
+      }
+    }
+  }
+  return count;
+}
+
+/* -----------------------------------------------------------------------------
+ * Computes the tokens of the header at once, the strings of the messages
+ * are not interned */
+static void
+prvTokenLookup (const gxPLMessage * message) {
+  gxPLMessage * m = (gxPLMessage *) message;
+  int token[4];
+
+  gxPLTokenLookupHeader (&m->schema, &m->source, &m->target, token);
+  m->class_token = token[0];
+  m->type_token = token[1];
+  m->source_token = token[2];
+  m->target_token = token[3];
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvTokenReset (gxPLMessage * m) {
+
+  m->class_token = GXPL_TOKEN_UNKNOWN;
+  m->type_token = GXPL_TOKEN_UNKNOWN;
+  m->source_token = GXPL_TOKEN_UNKNOWN;
+  m->target_token = GXPL_TOKEN_UNKNOWN;
+}
+
+/* -----------------------------------------------------------------------------
+ * Allocates a message in a single block, the body vector is initialized
+ * only if it is requested by gxPLMessageBodyGet() or gxPLMessageBodyGetConst() */
+static gxPLMessage *
+prvMessageNew (gxPLAllocator * allocator, gxPLMessageType type) {
+  gxPLMessage * message;
+
+  if (allocator == NULL) {
+
+    allocator = gxPLAllocatorHeap();
   }
+  message = gxPLAllocatorAlloc (allocator, sizeof (gxPLMessage));
+  if (message == NULL) {
+
+    return NULL;
+  }
+  memset (message, 0, sizeof (gxPLMessage));
+  message->alloc = allocator;
+  message->pair = message->pair_inline;
+  message->pair_max = DEFAULT_MESSAGE_INLINE_PAIRS;
+  message->hop = 1;
+  message->type = type;
+  message->state = gxPLMessageStateInit;
+  prvTokenReset (message);
+  return message;
+}
+
+// -----------------------------------------------------------------------------
+static gxPLMessage *
+prvMessageDecode (gxPLMessage * m, char * str) {
+  char *p, *line;
+  gxPLPair pair;
 
   line = str;
   while ( (m->isreceived) && (m->isvalid == 0) &&
@@ -145,7 +629,7 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
 
         if (strcmp (p, "{") != 0) {
 
-          PWARNING ("incorrectly formatted message", p);
+          PWARNING ("incorrectly formatted message: %s", p);
           m->iserror = 1;
           break;
         }
@@ -155,31 +639,24 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
       case gxPLMessageStateHeaderHop:
         //--------------------------------------------------------------------
         // gets next pair
-        pair = prvPairFromLine (&line);
-
-        if (line == NULL) {
-          // no line found or ...
-          if (pair == NULL) {
-            // no '=' found
-            m->iserror = 1;
-          }
+        if (prvPairSplitLine (&line, &pair) != 0) {
+          // no line found or no '=' found
+          m->iserror = 1;
           break;
         }
 
-        if (strcmp (pair->name, "hop") == 0) {
+        if (strcmp (pair.name, "hop") == 0) {
           int hop;
           char *endptr;
 
-          hop = strtol (pair->value, &endptr, 10);
+          hop = strtol (pair.value, &endptr, 10);
           if (*endptr != '\0') {
 
             // invalid hop value
-            gxPLPairDelete (pair);
             PWARNING ("invalid hop count");
             m->iserror = 1;
             break;
           }
-          gxPLPairDelete (pair);
           m->hop = hop;
           m->state = gxPLMessageStateHeaderSource;
         }
@@ -194,29 +671,21 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
       case gxPLMessageStateHeaderSource:
         //--------------------------------------------------------------------
         // gets next pair
-        pair = prvPairFromLine (&line);
-
-        if (line == NULL) {
-          // no line found or ...
-          if (pair == NULL) {
-            // no '=' found
-            m->iserror = 1;
-          }
+        if (prvPairSplitLine (&line, &pair) != 0) {
+          // no line found or no '=' found
+          m->iserror = 1;
           break;
         }
 
-        if (strcmp (pair->name, "source") == 0) {
+        if (strcmp (pair.name, "source") == 0) {
 
-          if (gxPLIdFromString (&m->source, pair->value) != 0) {
+          if (gxPLIdFromString (&m->source, pair.value) != 0) {
 
             // illegal source value
-            gxPLPairDelete (pair);
             PWARNING ("invalid source");
             m->iserror = 1;
             break;
           }
-
-          gxPLPairDelete (pair);
           m->state = gxPLMessageStateHeaderTarget;
         }
         else {
@@ -230,28 +699,26 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
       case gxPLMessageStateHeaderTarget:
         //--------------------------------------------------------------------
         // gets next pair
-        pair = prvPairFromLine (&line);
-
-        if ( (line == NULL) || (pair == NULL)) {
+        if (prvPairSplitLine (&line, &pair) != 0) {
           // no line found or no '=' found
           m->iserror = 1;
           break;
         }
 
-        if (strcmp (pair->name, "target") == 0) {
+        if (strcmp (pair.name, "target") == 0) {
 
-          if (strcmp (pair->value, "*") == 0) {
+          if (strcmp (pair.value, "*") == 0) {
 
             strcpy (m->target.vendor, "*");
             m->isbroadcast = 1;
           }
           else {
 
-            if (gxPLIdFromString (&m->target, pair->value) != 0) {
+            if (gxPLIdFromString (&m->target, pair.value) != 0) {
 
               // illegal target value
               PWARNING ("invalid target");
-              gxPLPairDelete (pair);
+              m->iserror = 1;
               break;
             }
             if ( (strcmp (m->target.vendor, "xpl") == 0) &&
@@ -262,8 +729,6 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
               m->isgrouped = 1;
             }
           }
-
-          gxPLPairDelete (pair);
           m->state = gxPLMessageStateHeaderEnd;
         }
         else {
@@ -285,7 +750,7 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
 
         if (strcmp (p, "}") != 0) {
 
-          PWARNING ("incorrectly formatted message", p);
+          PWARNING ("incorrectly formatted message: %s", p);
           m->iserror = 1;
           break;
         }
@@ -319,6 +784,8 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
             m->iserror = 1;
             break;
           }
+          // the header is complete, computes its tokens
+          prvTokenLookup (m);
           m->state = gxPLMessageStateBodyBegin;
         }
         else {
@@ -350,14 +817,14 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
         //--------------------------------------------------------------------
         // gets next pair
         if (strchr (line, '=')) {
-          pair = prvPairFromLine (&line);
 
-          if (pair) {
-            if (iVectorAppend (&m->body, pair) == 0) {
+          if (prvPairSplitLine (&line, &pair) == 0) {
+
+            // the pairs of the receive buffer are not copied
+            if (prvBodyAppend (m, pair.name, pair.value, str != m->raw)) {
 
               break;
             }
-            gxPLPairDelete (pair);
           }
           m->iserror = 1;
           PWARNING ("unable to append a pair in the message body");
@@ -401,6 +868,151 @@ gxPLMessageFromString (gxPLMessage * m, char * str) {
   return m;
 }
 
+/* -----------------------------------------------------------------------------
+ * Formats a message as text, the length is stored in len */
+static char *
+prvMessageFormat (const gxPLMessage * message, int * len) {
+  char * buf;
+  int size = gxPLMessageSerializedSize (message);
+
+  if (size < 0) {
+
+    PERROR ("Unable to format message -- invalid/unknown message type %d",
+            message->type);
+    return NULL;
+  }
+
+  buf = gxPLAllocatorAlloc (message->alloc, size + 1);
+  if (buf) {
+
+    *len = gxPLMessageToBuffer (message, buf, size + 1);
+  }
+  return buf;
+}
+
+/* -----------------------------------------------------------------------------
+ * Must be called by all the functions that modify the content of a message,
+ * the text will be formatted again */
+static void
+prvMessageChanged (gxPLMessage * m) {
+
+  gxPLAllocatorFree (m->alloc, m->str);
+  m->str = NULL;
+  prvTokenReset (m);
+}
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLMessageSchemaClassToken (const gxPLMessage * message) {
+
+  if (message->class_token == GXPL_TOKEN_UNKNOWN) {
+
+    prvTokenLookup (message);
+  }
+  return message->class_token;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLMessageSchemaTypeToken (const gxPLMessage * message) {
+
+  if (message->type_token == GXPL_TOKEN_UNKNOWN) {
+
+    prvTokenLookup (message);
+  }
+  return message->type_token;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLMessageSourceToken (const gxPLMessage * message) {
+
+  if (message->source_token == GXPL_TOKEN_UNKNOWN) {
+
+    prvTokenLookup (message);
+  }
+  return message->source_token;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLMessageTargetToken (const gxPLMessage * message) {
+
+  if (message->target_token == GXPL_TOKEN_UNKNOWN) {
+
+    prvTokenLookup (message);
+  }
+  return message->target_token;
+}
+
+// -----------------------------------------------------------------------------
+gxPLMessage *
+gxPLMessageFromString (gxPLMessage * m, char * str) {
+
+  if (strlen (str) == 0) {
+
+    PDEBUG ("empty message");
+    return m;
+  }
+
+  if (m == NULL) {
+    // New message
+    m = gxPLMessageNew (gxPLMessageAny);
+    assert (m);
+    m->isreceived = 1;
+  }
+
+  prvMessageChanged (m);
+  prvIndexDrop (m);
+  return prvMessageDecode (m, str);
+}
+
+// -----------------------------------------------------------------------------
+gxPLMessage *
+gxPLMessageAllocFromBuffer (gxPLAllocator * allocator, char * buffer) {
+  gxPLMessage * m;
+  int lines = 0;
+
+  if (strlen (buffer) == 0) {
+
+    PDEBUG ("empty message");
+    prvRawFree (allocator, buffer);
+    return NULL;
+  }
+
+  // the number of lines is the upper limit of the number of pairs in the body
+  for (const char * c = buffer; (c = strchr (c, '\n')) != NULL; c++) {
+
+    lines++;
+  }
+
+  m = prvMessageNew (allocator, gxPLMessageAny);
+  // the header and the braces take 9 lines
+  if ( (m == NULL) || (prvBodyReserve (m, lines - 9) != 0)) {
+
+    gxPLMessageDelete (m);
+    prvRawFree (allocator, buffer);
+    return NULL;
+  }
+  m->raw = buffer;
+  m->israwalloc = (allocator != NULL);
+  m->isreceived = 1;
+
+  // if the message is incomplete, the next parts are decoded with
+  // gxPLMessageFromString(), their pairs are copied in the message.
+  return prvMessageDecode (m, buffer);
+}
+
+// -----------------------------------------------------------------------------
+gxPLMessage *
+gxPLMessageFromBuffer (char * buffer) {
+
+  // the buffer was allocated by the user with malloc()
+  return gxPLMessageAllocFromBuffer (NULL, buffer);
+}
+
 // -----------------------------------------------------------------------------
 const char *
 gxPLMessageTypeToString (gxPLMessageType type) {
@@ -447,99 +1059,240 @@ gxPLMessageTypeFromString (const char * str) {
 // -----------------------------------------------------------------------------
 char *
 gxPLMessageToString (const gxPLMessage * message) {
-  char * buf;
-  const char * str;
-  int index = 0;
-  int buf_size = DEFAULT_ALLOC_STR_GROW;
+  // formatted without the text cached by gxPLMessageStringGet(), the message
+  // may be shared by several threads
+  int len = gxPLMessageSerializedSize (message);
+
+  if (len >= 0) {
+    // the text returned is released by the caller with free()
+    char * buf = malloc (len + 1);
+    assert (buf);
+
+    (void) gxPLMessageToBuffer (message, buf, len + 1);
+    return buf;
+  }
+  return NULL;
+}
 
-  buf = malloc (buf_size);
-  assert (buf);
+// -----------------------------------------------------------------------------
+const char *
+gxPLMessageStringGet (const gxPLMessage * message, int * len) {
 
+  if (message->str == NULL) {
+    // the text is not part of the content of the message
+    gxPLMessage * m = (gxPLMessage *) message;
 
-  // Write the header block
-  str = gxPLMessageTypeToString (message->type);
-  if (str == NULL) {
+    m->str = prvMessageFormat (message, &m->str_len);
+    if (m->str == NULL) {
 
-    PERROR (
-          "Unable to format message -- invalid/unknown message type %d",
-          message->type);
-    free (buf);
-    return NULL;
+      return NULL;
+    }
+  }
+
+  if (len) {
+
+    *len = message->str_len;
+  }
+  return message->str;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLMessageSerializedSize (const gxPLMessage * message) {
+  const char * type = gxPLMessageTypeToString (message->type);
+  int size;
+
+  if (type == NULL) {
+
+    errno = EINVAL;
+    return -1;
   }
 
-  // Writes message type and begins the header block
-  index += prvStrPrintf (&buf, &buf_size, index, "%s\n{\nhop=%d\n",
-                         str, message->hop);
-  // Writes the source
-  const gxPLId * n = gxPLMessageSourceIdGet (message);
-  index += prvStrPrintf (&buf, &buf_size, index, "source=%s-%s.%s\n",
-                         n->vendor, n->device, n->instance);
-  // Writes the target and ends the header
+  // type\n{\nhop=n\nsource=id\n
+  size = strlen (type) + 8 + prvIntLen (message->hop) + 8 +
+         prvIdLen (&message->source);
+  // target=*\n}\n or target=id\n}\n
+  size += (message->isbroadcast) ? 11 : (10 + prvIdLen (&message->target));
+  // class.type\n{\n
+  size += strlen (message->schema.class) + strlen (message->schema.type) + 4;
+  // name=value\n for each pair
+  for (int i = 0; i < prvBodySize (message); i++) {
+    const gxPLPair * p = prvBodyAt (message, i);
+
+    size += strlen (p->name) + strlen (p->value) + 2;
+  }
+  // }\n
+  return size + 2;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLMessageToBuffer (const gxPLMessage * message, char * buf, int len) {
+  int size = gxPLMessageSerializedSize (message);
+  char * p = buf;
+
+  if (size < 0) {
+
+    return -1;
+  }
+
+  if (len <= size) {
+
+    errno = ENOBUFS;
+    return -1;
+  }
+
+  p = prvStrPut (p, gxPLMessageTypeToString (message->type));
+  p = prvStrPut (p, "\n{\nhop=");
+  p = prvIntPut (p, message->hop);
+  p = prvStrPut (p, "\nsource=");
+  p = prvIdPut (p, &message->source);
   if (message->isbroadcast) {
 
-    index += prvStrPrintf (&buf, &buf_size, index, "target=*\n}\n");
+    p = prvStrPut (p, "\ntarget=*\n}\n");
   }
   else {
 
-    n = gxPLMessageTargetIdGet (message);
-    index += prvStrPrintf (&buf, &buf_size, index, "target=%s-%s.%s\n}\n",
-                           n->vendor, n->device, n->instance);
+    p = prvStrPut (p, "\ntarget=");
+    p = prvIdPut (p, &message->target);
+    p = prvStrPut (p, "\n}\n");
   }
 
-  // Writes the schema and begins the body
-  const gxPLSchema * s = gxPLMessageSchemaGet (message);
-  index += prvStrPrintf (&buf, &buf_size, index, "%s.%s\n{\n", s->class, s->type);
+  p = prvStrPut (p, message->schema.class);
+  *p++ = '.';
+  p = prvStrPut (p, message->schema.type);
+  p = prvStrPut (p, "\n{\n");
 
-  // Writes the name/value pairs (body)
-  const xVector * body = gxPLMessageBodyGetConst (message);
-  for (int i = 0; i < iVectorSize (body); i++) {
-    const gxPLPair * p = (const gxPLPair *) pvVectorGet (body, i);
+  for (int i = 0; i < prvBodySize (message); i++) {
+    const gxPLPair * pair = prvBodyAt (message, i);
 
-    index += prvStrPrintf (&buf, &buf_size, index, "%s=%s\n", p->name, p->value);
+    p = prvStrPut (p, pair->name);
+    *p++ = '=';
+    p = prvStrPut (p, pair->value);
+    *p++ = '\n';
   }
+  p = prvStrPut (p, "}\n");
+  *p = '\0';
+  return p - buf;
+}
 
-  // Ends the body and message
-  index += prvStrPrintf (&buf, &buf_size, index, "}\n", s->class, s->type);
-  // shorten the memory block to the strict minimum
-  buf = realloc (buf, index + 1);
-  return buf;
+// -----------------------------------------------------------------------------
+int
+gxPLMessageToIoVec (const gxPLMessage * message, gxPLIoVec * iov, int iovmax) {
+  static const char digits[] = "0123456789";
+  const char * head = prvTypeHead (message->type);
+  gxPLIoVec * v = iov;
+  int size = prvBodySize (message);
+
+  if ( (head == NULL) || (message->hop < 0) || (message->hop > 9)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  // 14 fragments for the header and the schema (20 with a target), 4 by pair
+  if (iovmax < ( (message->isbroadcast ? 14 : 20) + size * 4)) {
+
+    errno = ENOBUFS;
+    return -1;
+  }
+
+  v = prvIoVecPut (v, head);
+  v->base = &digits[message->hop];
+  v->len = 1;
+  v = prvIoVecPut (v + 1, "\nsource=");
+  v = prvIoVecId (v, &message->source);
+  if (message->isbroadcast) {
+
+    v = prvIoVecPut (v, "\ntarget=*\n}\n");
+  }
+  else {
+
+    v = prvIoVecPut (v, "\ntarget=");
+    v = prvIoVecId (v, &message->target);
+    v = prvIoVecPut (v, "\n}\n");
+  }
+
+  v = prvIoVecPut (v, message->schema.class);
+  v = prvIoVecPut (v, ".");
+  v = prvIoVecPut (v, message->schema.type);
+  v = prvIoVecPut (v, "\n{\n");
+
+  for (int i = 0; i < size; i++) {
+    const gxPLPair * pair = prvBodyAt (message, i);
+
+    v = prvIoVecPut (v, pair->name);
+    v = prvIoVecPut (v, "=");
+    v = prvIoVecPut (v, pair->value);
+    v = prvIoVecPut (v, "\n");
+  }
+  v = prvIoVecPut (v, "}\n");
+  return v - iov;
 }
 
 // -----------------------------------------------------------------------------
 gxPLMessage *
 gxPLMessageNew (gxPLMessageType type) {
 
-  gxPLMessage * message = calloc (1, sizeof (gxPLMessage));
-  assert (message);
-
-  if (iVectorInit (&message->body, 3, NULL, gxPLPairDelete) == 0) {
+  return prvMessageNew (NULL, type);
+}
 
-    if (iVectorInitSearch (&message->body, gxPLPairKey, gxPLPairMatch) == 0) {
+// -----------------------------------------------------------------------------
+gxPLMessage *
+gxPLMessageAllocNew (gxPLAllocator * allocator, gxPLMessageType type) {
 
-      message->hop = 1;
-      message->type = type;
-      message->state = gxPLMessageStateInit;
-      return message;
-    }
-  }
-  free (message);
-  return NULL;
+  return prvMessageNew (allocator, type);
 }
 
 // -----------------------------------------------------------------------------
 void
 gxPLMessageDelete (gxPLMessage * message) {
 
-  if (message) {
-    vVectorDestroy (&message->body);
-    free (message);
+  if ( (message) && (gxPLAtomicUnref (&message->refs) < 0)) {
+    // last reference
+
+    if (message->isbodyinit) {
+
+      vVectorDestroy (&message->body);
+    }
+    if (message->pair != message->pair_inline) {
+
+      gxPLAllocatorFree (message->alloc, message->pair);
+    }
+    prvTextClear (message);
+    prvRawFree (message->israwalloc ? message->alloc : NULL, message->raw);
+    gxPLAllocatorFree (message->alloc, message->str);
+    gxPLAllocatorFree (message->alloc, message->index);
+    gxPLAllocatorFree (message->alloc, message);
   }
 }
 
+// -----------------------------------------------------------------------------
+gxPLMessage *
+gxPLMessageRef (gxPLMessage * message) {
+
+  (void) gxPLAtomicAdd (&message->refs, 1);
+  return message;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLMessageShare (gxPLMessage * message) {
+
+  // computes everything the read accessors would compute on their first call
+  (void) gxPLMessageSchemaClassToken (message);
+  (void) gxPLMessageSchemaTypeToken (message);
+  (void) gxPLMessageSourceToken (message);
+  (void) gxPLMessageTargetToken (message);
+  (void) prvIndexBuild (message);
+  return (gxPLMessageBodyGetConst (message) != NULL) ? 0 : -1;
+}
+
 // -----------------------------------------------------------------------------
 int
 gxPLMessageSchemaClassSet (gxPLMessage * message, const char * schema_class) {
 
+  prvMessageChanged (message);
   return gxPLSchemaClassSet (&message->schema, schema_class);
 }
 
@@ -547,6 +1300,7 @@ gxPLMessageSchemaClassSet (gxPLMessage * message, const char * schema_class) {
 int
 gxPLMessageSchemaTypeSet (gxPLMessage * message, const char * schema_type) {
 
+  prvMessageChanged (message);
   return gxPLSchemaTypeSet (&message->schema, schema_type);
 }
 
@@ -554,6 +1308,7 @@ gxPLMessageSchemaTypeSet (gxPLMessage * message, const char * schema_type) {
 int
 gxPLMessageSourceVendorIdSet (gxPLMessage * message, const char * vendor_id) {
 
+  prvMessageChanged (message);
   return gxPLIdVendorIdSet (&message->source, vendor_id);
 }
 
@@ -561,6 +1316,7 @@ gxPLMessageSourceVendorIdSet (gxPLMessage * message, const char * vendor_id) {
 int
 gxPLMessageSourceDeviceIdSet (gxPLMessage * message, const char * device_id) {
 
+  prvMessageChanged (message);
   return gxPLIdDeviceIdSet (&message->source, device_id);
 }
 
@@ -568,6 +1324,7 @@ gxPLMessageSourceDeviceIdSet (gxPLMessage * message, const char * device_id) {
 int
 gxPLMessageSourceInstanceIdSet (gxPLMessage * message, const char * instance_id) {
 
+  prvMessageChanged (message);
   return gxPLIdInstanceIdSet (&message->source, instance_id);
 }
 
@@ -576,6 +1333,7 @@ gxPLMessageSourceInstanceIdSet (gxPLMessage * message, const char * instance_id)
 int
 gxPLMessageTargetVendorIdSet (gxPLMessage * message, const char * vendor_id) {
 
+  prvMessageChanged (message);
   return gxPLIdVendorIdSet (&message->target, vendor_id);
 }
 
@@ -583,6 +1341,7 @@ gxPLMessageTargetVendorIdSet (gxPLMessage * message, const char * vendor_id) {
 int
 gxPLMessageTargetDeviceIdSet (gxPLMessage * message, const char * device_id) {
 
+  prvMessageChanged (message);
   return gxPLIdDeviceIdSet (&message->target, device_id);
 }
 
@@ -590,6 +1349,7 @@ gxPLMessageTargetDeviceIdSet (gxPLMessage * message, const char * device_id) {
 int
 gxPLMessageTargetInstanceIdSet (gxPLMessage * message, const char * instance_id) {
 
+  prvMessageChanged (message);
   return gxPLIdInstanceIdSet (&message->target, instance_id);
 }
 
@@ -603,27 +1363,20 @@ gxPLMessagePairAdd (gxPLMessage * message, const char * name, const char * value
       errno = EINVAL;
     }
     else {
-      gxPLPair * p = calloc (1, sizeof (gxPLPair));
-      assert (p);
+      char lname[GXPL_NAME_MAX + 1];
 
-      p->name = malloc (strlen (name) + 1);
-      assert (p->name);
-      if (gxPLStrCpy (p->name, name) > 0) {
+      prvMessageChanged (message);
+      if (gxPLStrCpy (lname, name) > 0) {
 
         if (value == NULL) {
 
           value = "";
         }
-        p->value = malloc (strlen (value) + 1);
-        assert (p->value);
-
-        strcpy (p->value, value);
-        if (iVectorAppend (&message->body, p) == 0) {
+        if (prvBodyAppend (message, lname, (char *) value, true)) {
 
           return 0;
         }
       }
-      gxPLPairDelete (p);
     }
   }
   errno = EFAULT;
@@ -665,40 +1418,42 @@ gxPLMessagePairSet (gxPLMessage * message, const char * name,
       errno = EINVAL;
     }
     else {
-      gxPLPair * p = pvVectorFindFirst (&message->body, name);
+      gxPLPair * p = NULL;
 
+      (void) prvPairFind (message, name, NULL, NULL, (const gxPLPair **) &p);
+      prvMessageChanged (message);
       if (p == NULL) {
 
         return gxPLMessagePairAdd (message, name, value);
       }
 
-      if (strcmp (p->name, name) != 0) {
-
-        if (strlen (p->name) != strlen (name)) {
-
-          p->name = realloc (p->name, strlen (name) + 1);
-          assert (p->name);
-        }
-
-        if (gxPLStrCpy (p->name, name) < 0) {
-
-          return -1;
-        }
-      }
-
       if (value == NULL) {
 
         value = "";
       }
 
       if (strcmp (p->value, value) != 0) {
-        if (strlen (p->value) != strlen (value)) {
+
+        if (strlen (p->value) >= strlen (value)) {
+
+          // the new value takes the place of the old one
+          strcpy (p->value, value);
+        }
+        else if (message->isvector) {
 
           p->value = realloc (p->value, strlen (value) + 1);
           assert (p->value);
+          strcpy (p->value, value);
         }
+        else {
+          char * v = prvTextDup (message, value);
+
+          if (v == NULL) {
 
-        strcpy (p->value, value);
+            return -1;
+          }
+          p->value = v;
+        }
         return 0;
       }
     }
@@ -759,15 +1514,29 @@ gxPLMessagePairValuesSet (gxPLMessage * message, ...) {
 // -----------------------------------------------------------------------------
 const char *
 gxPLMessagePairGet (const gxPLMessage * message, const char * name) {
+  const gxPLPair * p;
+
+  if (prvPairFind (message, name, NULL, NULL, &p) > 0) {
 
-  gxPLPair * p = (gxPLPair *) pvVectorFindFirst (&message->body, name);
-  if (p) {
     return p->value;
   }
-
   return NULL;
 }
 
+// -----------------------------------------------------------------------------
+int
+gxPLMessagePairForEach (const gxPLMessage * message, const char * name,
+                        gxPLPairCallback func, void * udata) {
+  const gxPLPair * p;
+
+  if ( (message) && (name) && (func)) {
+
+    return prvPairFind (message, name, func, udata, &p);
+  }
+  errno = EFAULT;
+  return -1;
+}
+
 // -----------------------------------------------------------------------------
 int
 gxPLMessagePairExist (const gxPLMessage * message, const char * name) {
@@ -882,6 +1651,7 @@ gxPLMessageStateGet (const gxPLMessage * message) {
 int
 gxPLMessageFlagClear (gxPLMessage * message) {
 
+  prvMessageChanged (message);
   return message->flag = 0;
 }
 
@@ -918,6 +1688,7 @@ int
 gxPLMessageSchemaSet (gxPLMessage * message, const char * schema_class,
                       const char * schema_type) {
 
+  prvMessageChanged (message);
   return gxPLSchemaSet (&message->schema, schema_class, schema_type);
 }
 
@@ -925,6 +1696,7 @@ gxPLMessageSchemaSet (gxPLMessage * message, const char * schema_class,
 int
 gxPLMessageSchemaCopy (gxPLMessage * message, const gxPLSchema * schema) {
 
+  prvMessageChanged (message);
   return gxPLSchemaCopy (&message->schema, schema);
 }
 
@@ -946,34 +1718,74 @@ gxPLMessageIsGrouped (const gxPLMessage * message) {
 xVector *
 gxPLMessageBodyGet (gxPLMessage * message) {
 
+  // the body can be modified by the caller, the pairs are moved in the vector
+  if (prvBodyToVector (message) != 0) {
+
+    return NULL;
+  }
+  prvMessageChanged (message);
+  prvIndexDrop (message);
   return &message->body;
 }
 
 // -----------------------------------------------------------------------------
 const xVector *
 gxPLMessageBodyGetConst (const gxPLMessage * message) {
+  gxPLMessage * m = (gxPLMessage *) message;
 
-  return &message->body;
+  if ( (m->isvector == 0) && (m->isview == 0)) {
+
+    // the vector is a view of the pairs, it does not release them
+    if (m->isbodyinit) {
+
+      (void) iVectorClear (&m->body);
+    }
+    else if (prvBodyVectorInit (m, m->pair_count, NULL) != 0) {
+
+      return NULL;
+    }
+
+    for (int i = 0; i < m->pair_count; i++) {
+
+      if (iVectorAppend (&m->body, &m->pair[i]) != 0) {
+
+        (void) iVectorClear (&m->body);
+        return NULL;
+      }
+    }
+    m->isview = 1;
+  }
+  return &m->body;
 }
 
 // -----------------------------------------------------------------------------
 int
 gxPLMessageBodySize (const gxPLMessage * message) {
 
-  return iVectorSize (&message->body);
+  return prvBodySize (message);
 }
 
 // -----------------------------------------------------------------------------
 int
 gxPLMessageBodyClear (gxPLMessage * message) {
 
-  return iVectorClear (&message->body);
+  prvMessageChanged (message);
+  prvIndexDrop (message);
+  if (message->isvector) {
+
+    return iVectorClear (&message->body);
+  }
+  message->pair_count = 0;
+  message->isview = 0;
+  prvTextClear (message);
+  return 0;
 }
 
 // -----------------------------------------------------------------------------
 int
 gxPLMessageTypeSet (gxPLMessage * message, gxPLMessageType type) {
 
+  prvMessageChanged (message);
   message->type = type;
   return 0;
 }
@@ -982,6 +1794,7 @@ gxPLMessageTypeSet (gxPLMessage * message, gxPLMessageType type) {
 int
 gxPLMessageBroadcastSet (gxPLMessage * message, bool isBroadcast) {
 
+  prvMessageChanged (message);
   message->isbroadcast = isBroadcast;
   return 0;
 }
@@ -1006,6 +1819,7 @@ gxPLMessageGroupedSet (gxPLMessage * message, bool isGrouped) {
 int
 gxPLMessageHopSet (gxPLMessage * message, int hop) {
 
+  prvMessageChanged (message);
   message->hop = hop;
   return 0;
 }
@@ -1014,6 +1828,7 @@ gxPLMessageHopSet (gxPLMessage * message, int hop) {
 int
 gxPLMessageHopInc (gxPLMessage * message) {
 
+  prvMessageChanged (message);
   message->hop++;
   return 0;
 }
@@ -1022,6 +1837,7 @@ gxPLMessageHopInc (gxPLMessage * message) {
 int
 gxPLMessageSourceIdSet (gxPLMessage * message, const gxPLId * id) {
 
+  prvMessageChanged (message);
   return gxPLIdCopy (&message->source, id);
 }
 
@@ -1029,6 +1845,7 @@ gxPLMessageSourceIdSet (gxPLMessage * message, const gxPLId * id) {
 int
 gxPLMessageTargetIdSet (gxPLMessage * message, const gxPLId * id) {
 
+  prvMessageChanged (message);
   return gxPLIdCopy (&message->target, id);
 }
 
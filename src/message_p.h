@@ -9,11 +9,47 @@
 #ifndef _GXPL_MESSAGE_PRIVATE_HEADER_
 #define _GXPL_MESSAGE_PRIVATE_HEADER_
 
+#include <gxPL/alloc.h>
 #include <gxPL/message.h>
+#include <gxPL/util.h>
+
+/* constants ================================================================ */
+// pairs stored in the message itself, the others are stored on the heap
+#ifndef DEFAULT_MESSAGE_INLINE_PAIRS
+#define DEFAULT_MESSAGE_INLINE_PAIRS  8
+#endif
+
+// bytes of names and values stored in the message itself
+#ifndef DEFAULT_MESSAGE_INLINE_TEXT
+#define DEFAULT_MESSAGE_INLINE_TEXT   192
+#endif
+
 /* structures =============================================================== */
 
+/*
+ * @brief Slot of the index of the body of a message
+ */
+typedef struct _gxPLPairSlot {
+  unsigned long hash;
+  int pos; /**< position of the pair in the body + 1, 0 if the slot is free */
+} gxPLPairSlot;
+
+/*
+ * @brief Block of names and values used when the text area of a message is full
+ */
+typedef struct _gxPLTextBlock {
+  struct _gxPLTextBlock * next;
+  int size;
+  int used;
+  char data[];
+} gxPLTextBlock;
+
 /*
  * @brief Describe a xPL message
+ *
+ * A message with a small body is a single block of memory: the pairs and
+ * their names and values are stored at the end of the structure, the larger
+ * bodies spill on the heap.
  */
 struct _gxPLMessage {
 
@@ -25,8 +61,24 @@ struct _gxPLMessage {
   gxPLSchema schema;
 
   gxPLMessageState state;
+  gxPLAllocator * alloc; /**< provides the memory of the message */
+  int refs;              /**< references added by gxPLMessageRef() */
 
-  xVector body;
+  gxPLPair * pair;  /**< pairs of the body, pair_inline or an array on the heap */
+  int pair_count;
+  int pair_max;
+  xVector body;     /**< view of the pairs for gxPLMessageBodyGetConst(), owns the pairs if isvector */
+  char * raw;       /**< receive buffer owned by the message, NULL if none */
+  gxPLTextBlock * text; /**< text blocks on the heap, the current one first */
+  int text_used;    /**< bytes used in text_inline */
+  char * str;       /**< message as text, NULL if not formatted since the last change */
+  int str_len;
+  int class_token;  /**< tokens of the header, GXPL_TOKEN_UNKNOWN if not computed */
+  int type_token;
+  int source_token;
+  int target_token;
+  gxPLPairSlot * index; /**< index of the body by name, NULL if not built */
+  int index_mask;       /**< number of slots - 1 */
   union {
     unsigned int flag;
     struct {
@@ -36,8 +88,14 @@ struct _gxPLMessage {
       unsigned int isvalid: 1;
       unsigned int iserror: 1;
       unsigned int isgrouped: 1;
+      unsigned int isbodyinit: 1; /**< body vector initialized */
+      unsigned int isview: 1;     /**< body vector up to date with the pairs */
+      unsigned int isvector: 1;   /**< the pairs are in the body vector (gxPLMessageBodyGet) */
+      unsigned int israwalloc: 1; /**< raw allocated by alloc, by malloc() otherwise */
     };
   };
+  gxPLPair pair_inline[DEFAULT_MESSAGE_INLINE_PAIRS];
+  char text_inline[DEFAULT_MESSAGE_INLINE_TEXT];
 };
 
 /* ========================================================================== */
@@ -0,0 +1,244 @@
+/**
+ * @file
+ * Event loop shared by several applications (linux source code)
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifdef  __linux__
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <gxPL.h>
+#include "gxpl_p.h"
+
+/* constants ================================================================ */
+#ifndef DEFAULT_POLL_BUDGET
+#define DEFAULT_POLL_BUDGET 32
+#endif
+
+#define REACTOR_MAX_EVENTS 16
+
+/* structures =============================================================== */
+typedef struct _reactor_elmt {
+  gxPLApplication * app;
+  int fd;
+  int wfd; /* send queue of the application, -1 if none */
+  union {
+    uint8_t flag;
+    struct {
+      uint8_t isready: 1; /* an event was reported by epoll */
+      uint8_t isbusy: 1;  /* the budget was exhausted, datagrams can remain */
+    };
+  };
+} reactor_elmt;
+
+struct _gxPLReactor {
+  int epfd;
+  xVector app;  /* reactor_elmt */
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static const void *
+prvAppKey (const void * elmt) {
+
+  return ( (const reactor_elmt *) elmt)->app;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvAppMatch (const void *key1, const void *key2) {
+
+  return key1 != key2;
+}
+
+/* api functions ============================================================ */
+
+// -----------------------------------------------------------------------------
+gxPLReactor *
+gxPLReactorNew (void) {
+  gxPLReactor * reactor = calloc (1, sizeof (gxPLReactor));
+  assert (reactor);
+
+  reactor->epfd = epoll_create1 (EPOLL_CLOEXEC);
+  if (reactor->epfd >= 0) {
+
+    iVectorInit (&reactor->app, 2, NULL, free);
+    iVectorInitSearch (&reactor->app, prvAppKey, prvAppMatch);
+    return reactor;
+  }
+
+  PERROR ("Unable to create epoll instance - %s (%d)", strerror (errno), errno);
+  free (reactor);
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLReactorDelete (gxPLReactor * reactor) {
+
+  if (reactor) {
+    int ret;
+
+    ret = close (reactor->epfd);
+    vVectorDestroy (&reactor->app);
+    free (reactor);
+    return ret;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLReactorAdd (gxPLReactor * reactor, gxPLApplication * app) {
+  int fd;
+
+  if (pvVectorFindFirst (&reactor->app, app) != NULL) {
+
+    // already registered
+    return 0;
+  }
+
+  if (gxPLIoCtl (app, gxPLIoFuncGetFd, &fd) == 0) {
+    struct epoll_event ev;
+    reactor_elmt * e = calloc (1, sizeof (reactor_elmt));
+    assert (e);
+
+    e->app = app;
+    e->fd = fd;
+    // datagrams can be queued before registration
+    e->isbusy = 1;
+    memset (&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = e;
+
+    if (epoll_ctl (reactor->epfd, EPOLL_CTL_ADD, fd, &ev) == 0) {
+
+      // the messages queued by gxPLAppSendAsync() wake the reactor up too
+      e->wfd = gxPLSendQueueFd (app);
+      if ( (e->wfd < 0) ||
+           (epoll_ctl (reactor->epfd, EPOLL_CTL_ADD, e->wfd, &ev) == 0)) {
+
+        if (iVectorAppend (&reactor->app, e) == 0) {
+
+          return 0;
+        }
+        if (e->wfd >= 0) {
+
+          (void) epoll_ctl (reactor->epfd, EPOLL_CTL_DEL, e->wfd, NULL);
+        }
+      }
+      (void) epoll_ctl (reactor->epfd, EPOLL_CTL_DEL, fd, NULL);
+    }
+    else {
+
+      PERROR ("Unable to add fd %d to epoll - %s (%d)", fd, strerror (errno), errno);
+    }
+    free (e);
+    return -1;
+  }
+
+  PDEBUG ("the io layer %s does not provide a file descriptor",
+          gxPLAppSetting (app)->iolayer);
+  errno = EINVAL;
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLReactorRemove (gxPLReactor * reactor, gxPLApplication * app) {
+  int i = iVectorFindFirstIndex (&reactor->app, app);
+
+  if (i >= 0) {
+    reactor_elmt * e = pvVectorGet (&reactor->app, i);
+
+    (void) epoll_ctl (reactor->epfd, EPOLL_CTL_DEL, e->fd, NULL);
+    if (e->wfd >= 0) {
+
+      (void) epoll_ctl (reactor->epfd, EPOLL_CTL_DEL, e->wfd, NULL);
+    }
+    return iVectorRemove (&reactor->app, i);
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLReactorSize (const gxPLReactor * reactor) {
+
+  return iVectorSize (&reactor->app);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLReactorPoll (gxPLReactor * reactor, int timeout_ms) {
+  struct epoll_event ev[REACTOR_MAX_EVENTS];
+  int ret, count = 0, error = 0;
+
+  for (int i = 0; i < iVectorSize (&reactor->app); i++) {
+    reactor_elmt * e = pvVectorGet (&reactor->app, i);
+    long next = gxPLAppTimerNext (e->app);
+
+    if (e->isbusy) {
+
+      // the datagrams not processed by the last call are processed without waiting
+      timeout_ms = 0;
+      break;
+    }
+
+    if ( (next >= 0) && ( (timeout_ms < 0) || (next < timeout_ms))) {
+
+      // wakes up for the next timer
+      timeout_ms = next;
+    }
+  }
+
+  ret = epoll_wait (reactor->epfd, ev, REACTOR_MAX_EVENTS, timeout_ms);
+  if (ret < 0) {
+
+    if (errno != EINTR) {
+
+      PERROR ("failed to wait for events: %s", strerror (errno));
+      return -1;
+    }
+    ret = 0;
+  }
+
+  for (int i = 0; i < ret; i++) {
+
+    ( (reactor_elmt *) ev[i].data.ptr)->isready = 1;
+  }
+
+  for (int i = 0; i < iVectorSize (&reactor->app); i++) {
+    reactor_elmt * e = pvVectorGet (&reactor->app, i);
+
+    if (e->isready || e->isbusy) {
+
+      ret = gxPLAppPollBudget (e->app, 0, DEFAULT_POLL_BUDGET);
+      if (ret >= 0) {
+
+        e->isbusy = (ret >= DEFAULT_POLL_BUDGET);
+        count += ret;
+      }
+      else {
+
+        error = -1;
+      }
+      e->isready = 0;
+    }
+    else {
+
+      (void) gxPLAppTimerPoll (e->app);
+    }
+  }
+
+  return (error == 0) ? count : error;
+}
+
+#endif /* __linux__ defined */
+/* ========================================================================== */
@@ -0,0 +1,471 @@
+/**
+ * @file
+ * Requests waiting for a reply (source code)
+ *
+ * The requests are grouped by source and schema class of the expected reply,
+ * the groups are indexed in a hash table of the strings and keep their
+ * requests in the order they were made. A received message is compared with the requests of its own
+ * group and of the group of the requests accepting all the sources. The
+ * requests are also indexed by identifier, to be cancelled, and each one has
+ * a timer on the wheel of the application.
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL.h>
+#include "gxpl_p.h"
+
+/* constants ================================================================ */
+#ifndef DEFAULT_REQUEST_HASH_SIZE
+#define DEFAULT_REQUEST_HASH_SIZE 16
+#endif
+
+/* structures =============================================================== */
+
+/*
+ * Requests expecting a reply from the same source with the same schema class
+ */
+typedef struct _request_group {
+  gxPLHashNode node;            /* indexed by source and class */
+  gxPLId source;
+  int anysource;                /* true for all the sources */
+  char class[GXPL_CLASS_MAX + 1];
+  struct _request_elmt * head;  /* oldest request */
+  struct _request_elmt ** tail; /* next field of the newest request */
+} request_group;
+
+/*
+ * Key of a group, source is NULL for all the sources
+ */
+typedef struct _group_key {
+  const gxPLId * source;
+  const char * class;
+} group_key;
+
+typedef struct _request_elmt {
+  gxPLHashNode node;            /* indexed by id */
+  struct _request_elmt * next;
+  struct _request_elmt ** pprev;
+  request_group * group;
+  struct _gxPLRequestTable * table;
+  int id;
+  gxPLId requester;             /* source of the request */
+  gxPLMessageType type;
+  gxPLSchema schema;            /* empty type for all the schema types */
+  int multiple;
+  unsigned long serial;         /* last reply delivered */
+  gxPLTimer timeout;
+  gxPLRequestCallback func;
+  void * udata;
+} request_elmt;
+
+struct _gxPLRequestTable {
+  gxPLApplication * app;
+  gxPLHash group_index;
+  gxPLHash id_index;
+  int last_id;
+  unsigned long serial;         /* incremented for each message received */
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static unsigned long
+prvGroupHash (const group_key * key) {
+  unsigned long hash = (key->source) ? gxPLHashId (key->source) : GXPL_HASH_INIT;
+
+  return gxPLHashStr (hash, key->class);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvGroupMatch (const gxPLHashNode * node, const void * key) {
+  const request_group * g = gxPLHashEntry (node, request_group, node);
+  const group_key * k = (const group_key *) key;
+
+  if (k->source) {
+
+    if (g->anysource || (gxPLIdCmp (&g->source, k->source) != 0)) {
+
+      return 1;
+    }
+  }
+  else if (!g->anysource) {
+
+    return 1;
+  }
+  return strcmp (g->class, k->class);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvIdMatch (const gxPLHashNode * node, const void * key) {
+  const request_elmt * r = gxPLHashEntry (node, request_elmt, node);
+
+  return r->id != * (const int *) key;
+}
+
+// -----------------------------------------------------------------------------
+static request_group *
+prvGroupFind (gxPLRequestTable * t, const group_key * key) {
+  gxPLHashNode * node = gxPLHashFind (&t->group_index, prvGroupHash (key),
+                                      key, prvGroupMatch);
+
+  return (node) ? gxPLHashEntry (node, request_group, node) : NULL;
+}
+
+// -----------------------------------------------------------------------------
+static request_elmt *
+prvIdFind (gxPLRequestTable * t, int id) {
+  gxPLHashNode * node = gxPLHashFind (&t->id_index, (unsigned long) id,
+                                      &id, prvIdMatch);
+
+  return (node) ? gxPLHashEntry (node, request_elmt, node) : NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * Removes a request from the indexes and stops its timer, the group is
+ * released if it has no other request */
+static void
+prvRemove (gxPLRequestTable * t, request_elmt * r) {
+  request_group * g = r->group;
+
+  gxPLTimerStop (gxPLAppTimerWheel (t->app), &r->timeout);
+  (void) gxPLHashRemove (&t->id_index, &r->node);
+
+  *r->pprev = r->next;
+  if (r->next) {
+
+    r->next->pprev = r->pprev;
+  }
+  else {
+
+    g->tail = r->pprev;
+  }
+
+  if (g->head == NULL) {
+
+    (void) gxPLHashRemove (&t->group_index, &g->node);
+    gxPLAllocatorFree (gxPLAppAllocator (t->app), g);
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvTimeout (gxPLTimer * timer, void * udata) {
+  request_elmt * r = (request_elmt *) udata;
+  gxPLApplication * app = r->table->app;
+
+  prvRemove (r->table, r);
+  r->func (app, NULL, r->udata);
+  gxPLAllocatorFree (gxPLAppAllocator (app), r);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvIsReply (const request_elmt * r, const gxPLMessage * msg) {
+
+  if ( (r->type != gxPLMessageAny) && (r->type != gxPLMessageTypeGet (msg))) {
+
+    return 0;
+  }
+  if ( (r->schema.type[0] != '\0') &&
+       (strcmp (r->schema.type, gxPLMessageSchemaTypeGet (msg)) != 0)) {
+
+    return 0;
+  }
+  // the request received back
+  return gxPLIdCmp (&r->requester, gxPLMessageSourceIdGet (msg)) != 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Delivers a message to the requests of a group: to the oldest request waiting
+ * for a single reply and to all the requests waiting for multiple replies.
+ * The group is searched again after each call, the function can make or
+ * cancel requests */
+static void
+prvDeliver (gxPLRequestTable * t, gxPLMessage * msg, const group_key * key,
+            unsigned long serial) {
+  gxPLApplication * app = t->app;
+  int isdone = 0;
+
+  for (;;) {
+    request_group * g = prvGroupFind (t, key);
+    request_elmt * r;
+
+    if (g == NULL) {
+
+      return;
+    }
+
+    for (r = g->head; r; r = r->next) {
+
+      if ( (r->serial != serial) && (r->multiple || !isdone) &&
+           prvIsReply (r, msg)) {
+
+        break;
+      }
+    }
+
+    if (r == NULL) {
+
+      return;
+    }
+
+    r->serial = serial;
+    if (r->multiple) {
+
+      r->func (app, msg, r->udata);
+    }
+    else {
+
+      prvRemove (t, r);
+      r->func (app, msg, r->udata);
+      gxPLAllocatorFree (gxPLAppAllocator (app), r);
+      isdone = 1;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvReplyListener (gxPLApplication * app, gxPLMessage * msg, void * udata) {
+  gxPLRequestTable * t = (gxPLRequestTable *) udata;
+  group_key key;
+  unsigned long serial;
+
+  if (gxPLHashSize (&t->id_index) == 0) {
+
+    return;
+  }
+
+  key.source = gxPLMessageSourceIdGet (msg);
+  key.class = gxPLMessageSchemaClassGet (msg);
+  serial = ++t->serial;
+  prvDeliver (t, msg, &key, serial);
+  key.source = NULL;
+  prvDeliver (t, msg, &key, serial);
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the table of the application, creates it for the first request */
+static gxPLRequestTable *
+prvTableGet (gxPLApplication * app) {
+  gxPLRequestTable * t = app->requests;
+
+  if (t == NULL) {
+
+    t = calloc (1, sizeof (gxPLRequestTable));
+    if (t == NULL) {
+
+      return NULL;
+    }
+    t->app = app;
+
+    if ( (gxPLHashInit (&t->group_index, DEFAULT_REQUEST_HASH_SIZE) != 0) ||
+         (gxPLHashInit (&t->id_index, DEFAULT_REQUEST_HASH_SIZE) != 0) ||
+         (gxPLMessageListenerAddSync (app, prvReplyListener, t) != 0)) {
+
+      gxPLHashDestroy (&t->id_index);
+      gxPLHashDestroy (&t->group_index);
+      free (t);
+      return NULL;
+    }
+    app->requests = t;
+  }
+  return t;
+}
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+void
+gxPLRequestTableDelete (gxPLApplication * app) {
+  gxPLRequestTable * t = app->requests;
+
+  if (t) {
+
+    // the functions are called to release their data
+    while (gxPLHashSize (&t->id_index) > 0) {
+      request_elmt * r = NULL;
+
+      for (unsigned long i = 0; (r == NULL) && (i <= t->id_index.mask); i++) {
+
+        if (t->id_index.bucket[i]) {
+
+          r = gxPLHashEntry (t->id_index.bucket[i], request_elmt, node);
+        }
+      }
+      prvRemove (t, r);
+      r->func (app, NULL, r->udata);
+      gxPLAllocatorFree (gxPLAppAllocator (app), r);
+    }
+
+    (void) gxPLMessageListenerRemove (app, prvReplyListener);
+    gxPLHashDestroy (&t->id_index);
+    gxPLHashDestroy (&t->group_index);
+    free (t);
+    app->requests = NULL;
+  }
+}
+
+/* api functions ============================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppRequest (gxPLApplication * app, const gxPLMessage * message,
+                const gxPLRequestMatch * match, int timeout_ms,
+                gxPLRequestCallback callback, void * udata) {
+  gxPLRequestTable * t;
+  gxPLAllocator * alloc = gxPLAppAllocator (app);
+  request_group * g;
+  request_elmt * r;
+  group_key key;
+
+  if ( (message == NULL) || (callback == NULL) || (timeout_ms <= 0)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  t = prvTableGet (app);
+  if (t == NULL) {
+
+    return -1;
+  }
+
+  r = gxPLAllocatorAlloc (alloc, sizeof (request_elmt));
+  if (r == NULL) {
+
+    return -1;
+  }
+  memset (r, 0, sizeof (request_elmt));
+  r->table = t;
+  r->func = callback;
+  r->udata = udata;
+  // the replies are compared to the strings of the request, converted as the
+  // strings of the messages received
+  (void) gxPLIdCopy (&r->requester, gxPLMessageSourceIdGet (message));
+  // a reply being delivered is not delivered to the requests it makes
+  r->serial = t->serial;
+  r->type = gxPLMessageAny;
+  gxPLTimerInit (&r->timeout, prvTimeout, r);
+
+  // the key of the group of the replies
+  if ( (match) && (match->source)) {
+
+    key.source = match->source;
+  }
+  else if (gxPLMessageIsBroadcast (message) || gxPLMessageIsGrouped (message)) {
+
+    key.source = NULL;
+  }
+  else {
+
+    key.source = gxPLMessageTargetIdGet (message);
+  }
+
+  if ( (match) && (match->schema_class)) {
+
+    if (gxPLSchemaClassSet (&r->schema, match->schema_class) != 0) {
+
+      gxPLAllocatorFree (alloc, r);
+      errno = EINVAL;
+      return -1;
+    }
+  }
+  else {
+
+    strcpy (r->schema.class, gxPLMessageSchemaClassGet (message));
+  }
+  key.class = r->schema.class;
+
+  if (match) {
+
+    r->type = match->type;
+    r->multiple = match->multiple;
+    if ( (match->schema_type) &&
+         (gxPLSchemaTypeSet (&r->schema, match->schema_type) != 0)) {
+
+      gxPLAllocatorFree (alloc, r);
+      errno = EINVAL;
+      return -1;
+    }
+  }
+
+  if (gxPLAppBroadcastMessage (app, message) < 0) {
+
+    gxPLAllocatorFree (alloc, r);
+    return -1;
+  }
+
+  g = prvGroupFind (t, &key);
+  if (g == NULL) {
+
+    g = gxPLAllocatorAlloc (alloc, sizeof (request_group));
+    if (g == NULL) {
+
+      gxPLAllocatorFree (alloc, r);
+      return -1;
+    }
+    g->anysource = (key.source == NULL);
+    if (key.source) {
+
+      (void) gxPLIdCopy (&g->source, key.source);
+    }
+    strcpy (g->class, key.class);
+    g->head = NULL;
+    g->tail = &g->head;
+    gxPLHashAdd (&t->group_index, &g->node, prvGroupHash (&key));
+  }
+  r->group = g;
+  r->pprev = g->tail;
+  *g->tail = r;
+  g->tail = &r->next;
+
+  // an identifier still used after a wrap is skipped
+  do {
+
+    if (++t->last_id <= 0) {
+
+      t->last_id = 1;
+    }
+  }
+  while (prvIdFind (t, t->last_id));
+  r->id = t->last_id;
+  gxPLHashAdd (&t->id_index, &r->node, (unsigned long) r->id);
+
+  (void) gxPLTimerWheelUpdate (gxPLAppTimerWheel (app));
+  gxPLTimerStart (gxPLAppTimerWheel (app), &r->timeout, timeout_ms);
+  return r->id;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppRequestCancel (gxPLApplication * app, int id) {
+  gxPLRequestTable * t = app->requests;
+  request_elmt * r = (t) ? prvIdFind (t, id) : NULL;
+
+  if (r == NULL) {
+
+    errno = ENOENT;
+    return -1;
+  }
+  prvRemove (t, r);
+  gxPLAllocatorFree (gxPLAppAllocator (app), r);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppRequestCount (const gxPLApplication * app) {
+
+  return (app->requests) ? gxPLHashSize (&app->requests->id_index) : 0;
+}
+
+/* ========================================================================== */
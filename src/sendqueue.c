@@ -0,0 +1,438 @@
+/**
+ * @file
+ * Queue of the messages sent by the threads of the user (source code)
+ *
+ * The queue is a bounded ring where each cell carries a sequence number
+ * telling whether it can be written or read, the positions are reserved by
+ * compare-and-swap: several threads add messages without lock, the thread
+ * that polls the application removes them. A thread that adds a message to a
+ * full queue may also remove the oldest one (gxPLSendQueueDropOldest).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#if CONFIG_THREAD_SAFE
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#include <gxPL.h>
+#include "gxpl_p.h"
+#include "lock_p.h"
+
+/* constants ================================================================ */
+#ifndef DEFAULT_SEND_QUEUE_SIZE
+#define DEFAULT_SEND_QUEUE_SIZE 256
+#endif
+
+#define SEND_QUEUE_SIZE_MAX (1 << 20)
+
+/* structures =============================================================== */
+typedef struct _sendq_cell {
+  size_t seq;   /* position + 1 when the message can be read */
+  gxPLMessage * message;
+} sendq_cell;
+
+struct _gxPLSendQueue {
+  // written by the threads of the user
+  size_t head __attribute__ ( (aligned (64)));
+  // written by the poll, and by the user with gxPLSendQueueDropOldest
+  size_t tail __attribute__ ( (aligned (64)));
+  sendq_cell * cell;
+  size_t mask;
+  gxPLSendQueuePolicy policy;
+  int wfd;          /* eventfd that wakes the poll up, -1 if none */
+  int iswakeup;     /* the descriptor was written and not yet read */
+  int waiters;      /* threads waiting for room (gxPLSendQueueBlock) */
+  pthread_mutex_t lock;
+  pthread_cond_t room;
+  pthread_t poller; /* thread that empties the queue */
+  int haspoller;
+  unsigned long enqueued;
+  unsigned long sent;
+  unsigned long dropped;
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static int
+prvPush (gxPLSendQueue * q, gxPLMessage * message) {
+  size_t pos = __atomic_load_n (&q->head, __ATOMIC_RELAXED);
+  sendq_cell * c;
+
+  for (;;) {
+    intptr_t diff;
+
+    c = &q->cell[pos & q->mask];
+    diff = (intptr_t) __atomic_load_n (&c->seq, __ATOMIC_ACQUIRE) - (intptr_t) pos;
+    if (diff == 0) {
+
+      if (__atomic_compare_exchange_n (&q->head, &pos, pos + 1, 1,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    }
+    else if (diff < 0) {
+
+      // full
+      return -1;
+    }
+    else {
+
+      pos = __atomic_load_n (&q->head, __ATOMIC_RELAXED);
+    }
+  }
+  c->message = message;
+  __atomic_store_n (&c->seq, pos + 1, __ATOMIC_RELEASE);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static gxPLMessage *
+prvPop (gxPLSendQueue * q) {
+  size_t pos = __atomic_load_n (&q->tail, __ATOMIC_RELAXED);
+  gxPLMessage * message;
+  sendq_cell * c;
+
+  for (;;) {
+    intptr_t diff;
+
+    c = &q->cell[pos & q->mask];
+    diff = (intptr_t) __atomic_load_n (&c->seq, __ATOMIC_ACQUIRE) - (intptr_t) (pos + 1);
+    if (diff == 0) {
+
+      if (__atomic_compare_exchange_n (&q->tail, &pos, pos + 1, 1,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    }
+    else if (diff < 0) {
+
+      // empty
+      return NULL;
+    }
+    else {
+
+      pos = __atomic_load_n (&q->tail, __ATOMIC_RELAXED);
+    }
+  }
+  message = c->message;
+  // the cell can be written again at the next turn of the ring
+  __atomic_store_n (&c->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+  return message;
+}
+
+/* -----------------------------------------------------------------------------
+ * Wakes the poll up, a single write until the poll reads the descriptor */
+static void
+prvWakeup (gxPLSendQueue * q) {
+
+  if ( (q->wfd >= 0) &&
+       (__atomic_exchange_n (&q->iswakeup, 1, __ATOMIC_SEQ_CST) == 0)) {
+    uint64_t one = 1;
+
+    (void) write (q->wfd, &one, sizeof (one));
+  }
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvIsPoller (gxPLSendQueue * q) {
+  pthread_t poller;
+
+  if (__atomic_load_n (&q->haspoller, __ATOMIC_ACQUIRE)) {
+
+    __atomic_load (&q->poller, &poller, __ATOMIC_RELAXED);
+    return pthread_equal (poller, pthread_self());
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvDrain (gxPLApplication * app, gxPLSendQueue * q) {
+  gxPLMessage * message;
+  int count = 0;
+
+  if (!prvIsPoller (q)) {
+    pthread_t self = pthread_self();
+
+    // read by gxPLAppSendAsync() with gxPLSendQueueBlock
+    __atomic_store (&q->poller, &self, __ATOMIC_RELAXED);
+    __atomic_store_n (&q->haspoller, 1, __ATOMIC_RELEASE);
+  }
+
+  if ( (q->wfd >= 0) &&
+       (__atomic_exchange_n (&q->iswakeup, 0, __ATOMIC_SEQ_CST) != 0)) {
+    uint64_t value;
+
+    // the messages queued from now will write it again
+    (void) read (q->wfd, &value, sizeof (value));
+  }
+
+  // no more than a turn of the ring, the queue can be filled while it is sent
+  while ( (count <= (int) q->mask) && ( (message = prvPop (q)) != NULL)) {
+
+    if (gxPLAppBroadcastMessage (app, message) >= 0) {
+
+      gxPLAtomicAdd (&q->sent, 1);
+    }
+    else {
+
+      gxPLAtomicAdd (&q->dropped, 1);
+    }
+    gxPLMessageDelete (message);
+    count++;
+  }
+  if (count > (int) q->mask) {
+
+    // the remaining messages are sent by the next poll, without waiting
+    prvWakeup (q);
+  }
+
+  // the cells freed are seen by a thread that starts waiting after this test
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if ( (count > 0) && (__atomic_load_n (&q->waiters, __ATOMIC_SEQ_CST) > 0)) {
+
+    pthread_mutex_lock (&q->lock);
+    pthread_cond_broadcast (&q->room);
+    pthread_mutex_unlock (&q->lock);
+  }
+  return count;
+}
+
+/* -----------------------------------------------------------------------------
+ * Waits for the poll to make room, returns 0 if the message was queued */
+static int
+prvPushWait (gxPLApplication * app, gxPLSendQueue * q, gxPLMessage * message) {
+  int ret;
+
+  if (prvIsPoller (q)) {
+
+    // nobody else would empty the queue
+    (void) prvDrain (app, q);
+    return prvPush (q, message);
+  }
+
+  pthread_mutex_lock (&q->lock);
+  __atomic_add_fetch (&q->waiters, 1, __ATOMIC_SEQ_CST);
+  while ( (ret = prvPush (q, message)) != 0) {
+
+    // the poll may be waiting for the network
+    prvWakeup (q);
+    pthread_cond_wait (&q->room, &q->lock);
+  }
+  __atomic_sub_fetch (&q->waiters, 1, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock (&q->lock);
+  return ret;
+}
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLSendQueueDrain (gxPLApplication * app) {
+
+  return (app->sendq) ? prvDrain (app, app->sendq) : 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLSendQueueFd (const gxPLApplication * app) {
+
+  return (app->sendq) ? app->sendq->wfd : -1;
+}
+
+/* api functions ============================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppSendQueueOpen (gxPLApplication * app, int size,
+                      gxPLSendQueuePolicy policy) {
+  gxPLSendQueue * q;
+  size_t n = 1;
+
+  if (app->sendq) {
+
+    errno = EBUSY;
+    return -1;
+  }
+
+  if (size == 0) {
+
+    size = DEFAULT_SEND_QUEUE_SIZE;
+  }
+  if ( (size < 0) || (size > SEND_QUEUE_SIZE_MAX) ||
+       (policy < gxPLSendQueueDropNewest) || (policy > gxPLSendQueueBlock)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+  while (n < (size_t) size) {
+
+    n <<= 1;
+  }
+
+  q = calloc (1, sizeof (gxPLSendQueue));
+  if (q == NULL) {
+
+    return -1;
+  }
+  q->cell = malloc (n * sizeof (sendq_cell));
+  if (q->cell == NULL) {
+
+    free (q);
+    return -1;
+  }
+  for (size_t i = 0; i < n; i++) {
+
+    q->cell[i].seq = i;
+  }
+  q->mask = n - 1;
+  q->policy = policy;
+  pthread_mutex_init (&q->lock, NULL);
+  pthread_cond_init (&q->room, NULL);
+
+#ifdef __linux__
+  q->wfd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (q->wfd < 0) {
+
+    PWARNING ("Unable to create eventfd - %s (%d)", strerror (errno), errno);
+  }
+  else if (gxPLIoCtl (app, gxPLIoFuncSetWakeFd, q->wfd) != 0) {
+
+    PDEBUG ("the io layer %s can not be woken up, the queue is sent "
+            "by the next poll", gxPLAppSetting (app)->iolayer);
+  }
+#else
+  q->wfd = -1;
+#endif
+
+  app->sendq = q;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppSendQueueClose (gxPLApplication * app) {
+  gxPLSendQueue * q = app->sendq;
+
+  if (q) {
+    gxPLMessage * message;
+
+    // the remaining messages are sent
+    while (prvDrain (app, q) > 0)
+      ;
+    while ( (message = prvPop (q)) != NULL) {
+
+      gxPLMessageDelete (message);
+    }
+
+    if (q->wfd >= 0) {
+
+      (void) gxPLIoCtl (app, gxPLIoFuncSetWakeFd, -1);
+      (void) close (q->wfd);
+    }
+    pthread_cond_destroy (&q->room);
+    pthread_mutex_destroy (&q->lock);
+    free (q->cell);
+    free (q);
+    app->sendq = NULL;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppSendAsync (gxPLApplication * app, gxPLMessage * message) {
+  gxPLSendQueue * q = app->sendq;
+  int ret;
+
+  if (q == NULL) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  // the poll reads the message without modifying it
+  if (gxPLMessageShare (message) != 0) {
+
+    return -1;
+  }
+  (void) gxPLMessageRef (message);
+
+  ret = prvPush (q, message);
+  if (ret != 0) {
+
+    switch (q->policy) {
+
+      case gxPLSendQueueDropOldest:
+        do {
+          gxPLMessage * oldest = prvPop (q);
+
+          if (oldest) {
+
+            gxPLMessageDelete (oldest);
+            gxPLAtomicAdd (&q->dropped, 1);
+          }
+        }
+        while ( (ret = prvPush (q, message)) != 0);
+        break;
+
+      case gxPLSendQueueBlock:
+        ret = prvPushWait (app, q, message);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (ret != 0) {
+
+    gxPLAtomicAdd (&q->dropped, 1);
+    gxPLMessageDelete (message);
+    errno = ENOBUFS;
+    return -1;
+  }
+
+  gxPLAtomicAdd (&q->enqueued, 1);
+  prvWakeup (q);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppSendQueueStats (const gxPLApplication * app,
+                       gxPLSendQueueStats * stats) {
+  gxPLSendQueue * q = app->sendq;
+
+  if (q == NULL) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  stats->enqueued = gxPLAtomicGet (&q->enqueued);
+  stats->sent = gxPLAtomicGet (&q->sent);
+  stats->dropped = gxPLAtomicGet (&q->dropped);
+  stats->depth = (int) (__atomic_load_n (&q->head, __ATOMIC_RELAXED) -
+                        __atomic_load_n (&q->tail, __ATOMIC_RELAXED));
+  if (stats->depth < 0) {
+
+    stats->depth = 0;
+  }
+  stats->size = (int) q->mask + 1;
+  return 0;
+}
+
+#endif /* CONFIG_THREAD_SAFE true */
+/* ========================================================================== */
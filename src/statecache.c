@@ -0,0 +1,362 @@
+/**
+ * @file
+ * Cache of the last status of the devices (source code)
+ *
+ * The messages are indexed by the hash of their source, schema and "device"
+ * pair, the strings received are not interned. They are also linked in the order of
+ * their last use, the least recently used one is removed when the cache is
+ * full.
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL.h>
+#include "gxpl_p.h"
+
+/* constants ================================================================ */
+#ifndef DEFAULT_STATE_CACHE_SIZE
+#define DEFAULT_STATE_CACHE_SIZE 256
+#endif
+
+#define STATE_CACHE_SIZE_MAX 65536
+
+/* structures =============================================================== */
+typedef struct _cache_key {
+  const gxPLId * source;
+  const char * class;
+  const char * type;
+  const char * device;          /* "" if the status has no device pair */
+} cache_key;
+
+typedef struct _cache_elmt {
+  gxPLHashNode node;            /* indexed by the key */
+  struct _cache_elmt * prev;    /* more recently used */
+  struct _cache_elmt * next;    /* less recently used */
+  gxPLMessage * message;        /* copy of the last message received */
+  unsigned long time;           /* reception, see gxPLAppTimeMs() */
+} cache_elmt;
+
+struct _gxPLStateCache {
+  gxPLApplication * app;
+  gxPLHash index;
+  cache_elmt * head;            /* most recently used */
+  cache_elmt * tail;            /* least recently used */
+  gxPLStateCacheStats stats;
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static const char *
+prvDevice (const gxPLMessage * message) {
+  const char * device = gxPLMessagePairGet (message, "device");
+
+  return (device) ? device : "";
+}
+
+// -----------------------------------------------------------------------------
+static unsigned long
+prvHash (const cache_key * key) {
+  unsigned long hash = gxPLHashId (key->source);
+
+  hash = gxPLHashStr (gxPLHashStr (hash, key->class), key->type);
+  return gxPLHashStr (hash, key->device);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvMatch (const gxPLHashNode * node, const void * key) {
+  const cache_elmt * e = gxPLHashEntry (node, cache_elmt, node);
+  const cache_key * k = (const cache_key *) key;
+
+  if ( (gxPLIdCmp (gxPLMessageSourceIdGet (e->message), k->source) != 0) ||
+       (strcmp (gxPLMessageSchemaClassGet (e->message), k->class) != 0) ||
+       (strcmp (gxPLMessageSchemaTypeGet (e->message), k->type) != 0)) {
+
+    return 1;
+  }
+  return strcmp (prvDevice (e->message), k->device);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvUnlink (gxPLStateCache * cache, cache_elmt * e) {
+
+  if (e->prev) {
+
+    e->prev->next = e->next;
+  }
+  else {
+
+    cache->head = e->next;
+  }
+
+  if (e->next) {
+
+    e->next->prev = e->prev;
+  }
+  else {
+
+    cache->tail = e->prev;
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Moves an element at the head of the list, the most recently used */
+static void
+prvTouch (gxPLStateCache * cache, cache_elmt * e) {
+
+  if (cache->head != e) {
+
+    prvUnlink (cache, e);
+    e->prev = NULL;
+    e->next = cache->head;
+    cache->head->prev = e;
+    cache->head = e;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvRemove (gxPLStateCache * cache, cache_elmt * e) {
+
+  prvUnlink (cache, e);
+  (void) gxPLHashRemove (&cache->index, &e->node);
+  gxPLMessageDelete (e->message);
+  free (e);
+  cache->stats.count--;
+}
+
+/* -----------------------------------------------------------------------------
+ * Copies a message in a single buffer decoded in place, like a message
+ * received, the copy is prepared to be read by several threads */
+static gxPLMessage *
+prvCopy (gxPLApplication * app, const gxPLMessage * message) {
+  gxPLAllocator * alloc = gxPLAppAllocator (app);
+  int size = gxPLMessageSerializedSize (message);
+  gxPLMessage * copy;
+  char * buffer;
+
+  if (size < 0) {
+
+    return NULL;
+  }
+
+  // the message may be read by the workers, it is not modified
+  buffer = gxPLAllocatorAlloc (alloc, size + 1);
+  if (buffer == NULL) {
+
+    return NULL;
+  }
+  if (gxPLMessageToBuffer (message, buffer, size + 1) < 0) {
+
+    gxPLAllocatorFree (alloc, buffer);
+    return NULL;
+  }
+
+  // the message owns the buffer, even if an error occurs
+  copy = gxPLMessageAllocFromBuffer (alloc, buffer);
+  if ( (copy) && (gxPLMessageShare (copy) != 0)) {
+
+    gxPLMessageDelete (copy);
+    return NULL;
+  }
+  return copy;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvStateListener (gxPLApplication * app, gxPLMessage * message, void * udata) {
+  gxPLStateCache * cache = (gxPLStateCache *) udata;
+  gxPLMessageType type = gxPLMessageTypeGet (message);
+  cache_key key;
+  unsigned long hash;
+  gxPLHashNode * node;
+  gxPLMessage * copy;
+  cache_elmt * e;
+
+  if ( (type != gxPLMessageStatus) && (type != gxPLMessageTrigger)) {
+
+    return;
+  }
+
+  if ( (gxPLMessageSchemaClassToken (message) == gxPLTokenHbeat) ||
+       (gxPLMessageSchemaClassToken (message) == gxPLTokenConfig)) {
+
+    // tracked by the directory
+    return;
+  }
+  key.source = gxPLMessageSourceIdGet (message);
+  key.class = gxPLMessageSchemaClassGet (message);
+  key.type = gxPLMessageSchemaTypeGet (message);
+  key.device = prvDevice (message);
+
+  copy = prvCopy (app, message);
+  if (copy == NULL) {
+
+    return;
+  }
+
+  hash = prvHash (&key);
+  node = gxPLHashFind (&cache->index, hash, &key, prvMatch);
+  if (node) {
+
+    // the previous message is released when no longer used
+    e = gxPLHashEntry (node, cache_elmt, node);
+    gxPLMessageDelete (e->message);
+    prvTouch (cache, e);
+  }
+  else {
+
+    if (cache->stats.count >= cache->stats.size) {
+
+      prvRemove (cache, cache->tail);
+      cache->stats.evicted++;
+    }
+
+    e = malloc (sizeof (cache_elmt));
+    if (e == NULL) {
+
+      gxPLMessageDelete (copy);
+      return;
+    }
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) {
+
+      cache->head->prev = e;
+    }
+    else {
+
+      cache->tail = e;
+    }
+    cache->head = e;
+    gxPLHashAdd (&cache->index, &e->node, hash);
+    cache->stats.count++;
+  }
+  e->message = copy;
+  e->time = gxPLAppTimeMs (app);
+}
+
+/* api functions ============================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppStateCacheOpen (gxPLApplication * app, int size) {
+  gxPLStateCache * cache;
+
+  if (app->statecache) {
+
+    errno = EBUSY;
+    return -1;
+  }
+
+  if (size == 0) {
+
+    size = DEFAULT_STATE_CACHE_SIZE;
+  }
+  if ( (size < 1) || (size > STATE_CACHE_SIZE_MAX)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  cache = calloc (1, sizeof (gxPLStateCache));
+  if (cache == NULL) {
+
+    return -1;
+  }
+  cache->app = app;
+  cache->stats.size = size;
+
+  if (gxPLHashInit (&cache->index, MIN (size, DEFAULT_STATE_CACHE_SIZE)) == 0) {
+
+    if (gxPLMessageListenerAddSync (app, prvStateListener, cache) == 0) {
+
+      app->statecache = cache;
+      return 0;
+    }
+    gxPLHashDestroy (&cache->index);
+  }
+  free (cache);
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppStateCacheClose (gxPLApplication * app) {
+  gxPLStateCache * cache = app->statecache;
+
+  if (cache) {
+
+    (void) gxPLMessageListenerRemove (app, prvStateListener);
+    while (cache->head) {
+
+      prvRemove (cache, cache->head);
+    }
+    gxPLHashDestroy (&cache->index);
+    free (cache);
+    app->statecache = NULL;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+gxPLMessage *
+gxPLAppStateCacheGet (gxPLApplication * app, const gxPLId * source,
+                      const char * schema_class, const char * schema_type,
+                      const char * device, unsigned long * age_ms) {
+  gxPLStateCache * cache = app->statecache;
+  gxPLHashNode * node;
+  cache_key key;
+
+  if ( (cache == NULL) || (source == NULL) || (schema_class == NULL) ||
+       (schema_type == NULL)) {
+
+    errno = EINVAL;
+    return NULL;
+  }
+
+  key.source = source;
+  key.class = schema_class;
+  key.type = schema_type;
+  key.device = (device) ? device : "";
+  node = gxPLHashFind (&cache->index, prvHash (&key), &key, prvMatch);
+
+  if (node) {
+    cache_elmt * e = gxPLHashEntry (node, cache_elmt, node);
+
+    cache->stats.hits++;
+    prvTouch (cache, e);
+    if (age_ms) {
+
+      *age_ms = gxPLAppTimeMs (app) - e->time;
+    }
+    return gxPLMessageRef (e->message);
+  }
+
+  cache->stats.misses++;
+  errno = ENOENT;
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppStateCacheStats (const gxPLApplication * app,
+                        gxPLStateCacheStats * stats) {
+
+  if (app->statecache == NULL) {
+
+    errno = EINVAL;
+    return -1;
+  }
+  *stats = app->statecache->stats;
+  return 0;
+}
+
+/* ========================================================================== */
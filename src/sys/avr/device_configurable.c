@@ -206,7 +206,10 @@ gxPLDeviceConfigSave (const gxPLDevice * device) {
     for (int i = 0; i < iVectorSize (&device->filter); i++) {
 
       gxPLFilter * filter = (gxPLFilter *) pvVectorGet (&device->filter, i);
-      fprintf (file, "filter=%s\n", gxPLDeviceFilterToString (filter));
+      char str[GXPL_FILTER_STR_MAX];
+
+      gxPLDeviceFilterToBuffer (filter, str, sizeof (str));
+      fprintf (file, "filter=%s\n", str);
     }
   }
   else {
@@ -39,6 +39,7 @@ typedef struct xbeezb_data {
   int modem_status;
 
   xTaskHandle task;
+  char addr_str[8 * 3]; /* result of gxPLIoFuncNetAddrToString */
 } xbeezb_data;
 
 /* macros =================================================================== */
@@ -50,8 +51,7 @@ typedef struct xbeezb_data {
 // gxPLNetFamilyZigbee16: xx:xx
 // gxPLNetFamilyZigbee64: xx:xx:xx:xx:xx:xx:xx:xx
 static const char *
-prvZbAddrToString (uint8_t * zbaddr, uint8_t zbaddr_size) {
-  static char buffer[8 * 3];
+prvZbAddrToString (uint8_t * zbaddr, uint8_t zbaddr_size, char * buffer) {
 
   buffer[0] = '\0';
 
@@ -203,8 +203,10 @@ prvZbTxStatusCB (xXBee *xbee, xXBeePkt *pkt, uint8_t len) {
 static int
 prvZbNodeIdCB (xXBee * xbee, xXBeePkt * pkt, uint8_t len) {
 
+  char str[8 * 3];
+
   PINFO ("%s joined zigbee network",
-         prvZbAddrToString (pucXBeePktAddrRemote64 (pkt), 8));
+         prvZbAddrToString (pucXBeePktAddrRemote64 (pkt), 8, str));
   vXBeeFreePkt (xbee, pkt);
   return 0;
 }
@@ -771,7 +773,7 @@ gxPLXBeeZbCtl (gxPLIo * io, int c, va_list ap) {
            (addr->family == gxPLNetFamilyZigbee64)) {
         const char ** str_addr = (const char **) va_arg (ap, char**);
 
-        *str_addr = prvZbAddrToString (addr->addr, addr->addrlen);
+        *str_addr = prvZbAddrToString (addr->addr, addr->addrlen, dp->addr_str);
       }
       else {
 
@@ -34,20 +34,31 @@ struct tm {
  * TODO: RTC with asynchronous 8 bits timer
  */
 // -----------------------------------------------------------------------------
-struct tm *
-prvTime (unsigned long t) {
-  static struct tm clk;
+static struct tm *
+prvTime (unsigned long t, struct tm * clk) {
   unsigned long mod;
 
-  clk.d = t / DAY_SEC;
-  mod = (clk.d * DAY_SEC);
-  clk.h = (t % mod) / HOUR_SEC;
-  mod += (clk.h * HOUR_SEC);
-  clk.m = (t % mod) / MIN_SEC;
-  mod += (clk.m * MIN_SEC);
-  clk.s = t % mod;
+  clk->d = t / DAY_SEC;
+  mod = (clk->d * DAY_SEC);
+  clk->h = (t % mod) / HOUR_SEC;
+  mod += (clk->h * HOUR_SEC);
+  clk->m = (t % mod) / MIN_SEC;
+  mod += (clk->m * MIN_SEC);
+  clk->s = t % mod;
 
-  return &clk;
+  return clk;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvCheckLen (int count, int len) {
+
+  if (count >= len) {
+
+    errno = ENOBUFS;
+    return -1;
+  }
+  return count;
 }
 
 /* api functions ============================================================ */
@@ -78,6 +89,18 @@ gxPLTimeMs (unsigned long * ms) {
   return 0;
 }
 
+/* ----------------------------------------------------------------------------
+ * @brief Monotonic time in milliseconds
+ * The system time is counted from the startup, it is already monotonic
+ * @param ms pointer on the result
+ * @return 0, < 0 if error occurs
+ */
+int
+gxPLTimeMonotonicMs (unsigned long * ms) {
+
+  return gxPLTimeMs (ms);
+}
+
 /* ----------------------------------------------------------------------------
  * @brief converts the system time t into a null-terminated string
  * @param t time return by gxPLTime
@@ -87,11 +110,7 @@ char *
 gxPLDateTimeStr (unsigned long t, const char * format) {
   static char buf[16];
 
-  struct tm * clk = prvTime (t);
-
-  snprintf_P (buf, sizeof (buf), PSTR ("------%02d%02d%02d%02d"),
-              clk->d, clk->h, clk->m, clk->s);
-
+  (void) gxPLDateTimeToBuffer (t, format, buf, sizeof (buf));
   return buf;
 }
 
@@ -100,11 +119,7 @@ char *
 gxPLTimeStr (unsigned long t, const char * format) {
   static char buf[8];
 
-  struct tm * clk = prvTime (t);
-
-  snprintf_P (buf, sizeof (buf), PSTR ("%02d%02d%02d"),
-              clk->h, clk->m, clk->s);
-
+  (void) gxPLTimeToBuffer (t, format, buf, sizeof (buf));
   return buf;
 }
 
@@ -113,12 +128,39 @@ char *
 gxPLDateStr (unsigned long t, const char * format) {
   static char buf[10];
 
-  struct tm * clk = prvTime (t);
-
-  snprintf_P (buf, sizeof (buf), PSTR ("------%02d"), clk->d);
+  (void) gxPLDateToBuffer (t, format, buf, sizeof (buf));
   return buf;
 }
 
+// -----------------------------------------------------------------------------
+int
+gxPLDateTimeToBuffer (unsigned long t, const char * format, char * buf, int len) {
+  struct tm clk;
+
+  prvTime (t, &clk);
+  return prvCheckLen (snprintf_P (buf, len, PSTR ("------%02d%02d%02d%02d"),
+                                  clk.d, clk.h, clk.m, clk.s), len);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLTimeToBuffer (unsigned long t, const char * format, char * buf, int len) {
+  struct tm clk;
+
+  prvTime (t, &clk);
+  return prvCheckLen (snprintf_P (buf, len, PSTR ("%02d%02d%02d"),
+                                  clk.h, clk.m, clk.s), len);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLDateToBuffer (unsigned long t, const char * format, char * buf, int len) {
+  struct tm clk;
+
+  prvTime (t, &clk);
+  return prvCheckLen (snprintf_P (buf, len, PSTR ("------%02d"), clk.d), len);
+}
+
 /* ----------------------------------------------------------------------------
  * @brief suspends execution for (at least) ms milliseconds
  * @param ms delay in milliseconds
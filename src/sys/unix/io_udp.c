@@ -8,6 +8,7 @@
  * Licensed under the Apache License, Version 2.0 (the "License")
  */
 #ifdef  __unix__
+#define _GNU_SOURCE
 #include "config.h"
 #include <errno.h>
 #include <stdio.h>
@@ -17,6 +18,7 @@
 
 #define GXPL_IO_INTERNALS
 #include "io_p.h"
+#include <gxPL/alloc.h>
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -34,14 +36,40 @@
 /* constants ================================================================ */
 #define IO_NAME "udp"
 
+#ifndef DEFAULT_UDP_RING_SIZE
+#define DEFAULT_UDP_RING_SIZE 16
+#endif
+
+#ifndef DEFAULT_UDP_BUFSIZE
+#define DEFAULT_UDP_BUFSIZE 1500
+#endif
+
+#ifndef DEFAULT_UDP_SEND_BATCH
+#define DEFAULT_UDP_SEND_BATCH 32
+#endif
+
+#ifndef DEFAULT_UDP_IOV_MAX
+#define DEFAULT_UDP_IOV_MAX 256
+#endif
+
 /* structures =============================================================== */
 typedef struct udp_data {
   int ofd;
   struct sockaddr_in bcast_addr;
   int ifd;
   int iport;
+  int wfd; /* also wakes up prvIoPoll(), -1 if none */
   struct in_addr local_addr;
   xVector addr_list;
+  char addr_str[GXPL_NETADDR_STR_MAX]; /* result of gxPLIoFuncNetAddrToString */
+  // receive ring filled by recvmmsg()
+  int rx_count; /* number of datagrams in the ring */
+  int rx_next;  /* index of the next datagram to deliver */
+  struct mmsghdr rx_msg[DEFAULT_UDP_RING_SIZE];
+  struct iovec rx_iov[DEFAULT_UDP_RING_SIZE];
+  struct sockaddr_in rx_addr[DEFAULT_UDP_RING_SIZE];
+  char * rx_buf[DEFAULT_UDP_RING_SIZE]; /* one more byte for the null character */
+  gxPLAllocator * rx_alloc[DEFAULT_UDP_RING_SIZE]; /* allocator of each buffer */
 } udp_data;
 
 /* macros =================================================================== */
@@ -286,7 +314,8 @@ prvMakeBroadcastConnection (gxPLIo * io) {
   }
 
   dp->local_addr.s_addr = ( (struct sockaddr_in *) &ifinfo.ifr_addr)->sin_addr.s_addr;
-  PDEBUG ("Assigned IP address to %s", inet_ntoa (dp->local_addr));
+  PDEBUG ("Assigned IP address to %s",
+          inet_ntop (AF_INET, &dp->local_addr, dp->addr_str, sizeof (dp->addr_str)));
 
   // Get interface netmask
   memset (&ifinfo, 0, sizeof (struct ifreq));
@@ -312,7 +341,8 @@ prvMakeBroadcastConnection (gxPLIo * io) {
 
   // And we are done
   PDEBUG ("Assigned broadcast address to %s:%d",
-          inet_ntoa (dp->bcast_addr.sin_addr),
+          inet_ntop (AF_INET, &dp->bcast_addr.sin_addr, dp->addr_str,
+                     sizeof (dp->addr_str)),
           XPL_PORT);
   return 0;
 }
@@ -488,8 +518,12 @@ prvBuildLocalIpList (gxPLIo * io) {
     iface = & (iface_list.ifc_req[i]);
     if (iface->ifr_addr.sa_family == AF_INET) {
 
-      char * src = inet_ntoa ( ( (struct sockaddr_in *) & (iface->ifr_addr))->sin_addr);
-      char * dst = malloc (strlen (src) + 1);
+      char src[INET_ADDRSTRLEN];
+      char * dst;
+
+      inet_ntop (AF_INET, & ( (struct sockaddr_in *) & (iface->ifr_addr))->sin_addr,
+                 src, sizeof (src));
+      dst = malloc (strlen (src) + 1);
       assert (dst);
       strcpy (dst, src);
       if (iVectorAppend (&dp->addr_list, dst) != 0) {
@@ -504,6 +538,112 @@ prvBuildLocalIpList (gxPLIo * io) {
   return 0;
 }
 
+// -----------------------------------------------------------------------------
+static void
+prvSourceAddrSet (gxPLIoAddr * source, const struct sockaddr_in * client) {
+
+  source->family = gxPLNetFamilyInet4;
+  source->addrlen = MIN (sizeof (source->addr), sizeof (client->sin_addr.s_addr));
+  source->port = ntohs (client->sin_port);
+  source->flag = 0;
+  memcpy (source->addr, &client->sin_addr.s_addr, source->addrlen);
+}
+
+/* -----------------------------------------------------------------------------
+ * Converts a target to a socket address, the broadcast address is used if
+ * target is NULL, is broadcast or is not an ipv4 address */
+static void
+prvTargetAddr (gxPLIo * io, const gxPLIoAddr * target, struct sockaddr_in * a) {
+
+  if ( (target) && (target->isbroadcast == 0) &&
+       (target->family == gxPLNetFamilyInet4)) {
+
+    memset (a, 0, sizeof (struct sockaddr_in));
+    a->sin_family = AF_INET;
+    memcpy (&a->sin_addr.s_addr, target->addr,  sizeof (a->sin_addr.s_addr));
+    a->sin_port = htons (target->port);
+  }
+  else {
+
+    memcpy (a, &dp->bcast_addr, sizeof (struct sockaddr_in));
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Reads all the datagrams waiting on the bind socket, up to the size of
+ * the ring, with a single system call.
+ * Return the number of datagrams in the ring, -1 on error */
+static int
+prvRingFill (gxPLIo * io) {
+  int ret;
+
+  for (int i = 0; i < DEFAULT_UDP_RING_SIZE; i++) {
+    struct msghdr * h = &dp->rx_msg[i].msg_hdr;
+
+    if (dp->rx_buf[i] == NULL) {
+
+      // first fill, the buffers handed over are replaced by gxPLUdpRecvBuffer()
+      dp->rx_alloc[i] = gxPLAllocatorHeap();
+      dp->rx_buf[i] = gxPLAllocatorAlloc (dp->rx_alloc[i], DEFAULT_UDP_BUFSIZE + 1);
+      if (dp->rx_buf[i] == NULL) {
+
+        PERROR ("Unable to allocate the receive ring");
+        return -1;
+      }
+    }
+    dp->rx_iov[i].iov_base = dp->rx_buf[i];
+    dp->rx_iov[i].iov_len = DEFAULT_UDP_BUFSIZE;
+    memset (h, 0, sizeof (struct msghdr));
+    h->msg_iov = &dp->rx_iov[i];
+    h->msg_iovlen = 1;
+    h->msg_name = &dp->rx_addr[i];
+    h->msg_namelen = sizeof (struct sockaddr_in);
+  }
+
+  dp->rx_next = 0;
+  dp->rx_count = 0;
+  ret = recvmmsg (dp->ifd, dp->rx_msg, DEFAULT_UDP_RING_SIZE, MSG_DONTWAIT, NULL);
+
+  if (ret < 0) {
+
+    // Expected response when queue is empty
+    if ( (errno == EAGAIN) || (errno == EINTR)) {
+
+      return 0;
+    }
+
+    PERROR ("Error reading xPL messages from network - %s (%d)",
+            strerror (errno), errno);
+    return -1;
+  }
+
+  PDEBUG ("Received %d datagrams", ret);
+  dp->rx_count = ret;
+  return ret;
+}
+
+/* -----------------------------------------------------------------------------
+ * Return the size of the next datagram of the ring, 0 if the ring is empty.
+ * The truncated datagrams (larger than an xPL message) are ignored */
+static int
+prvRingNext (gxPLIo * io) {
+
+  while (dp->rx_next < dp->rx_count) {
+    struct mmsghdr * m = &dp->rx_msg[dp->rx_next];
+
+    if (m->msg_hdr.msg_flags & MSG_TRUNC) {
+
+      PWARNING ("Datagram larger than %d bytes - ignored", DEFAULT_UDP_BUFSIZE);
+    }
+    else if (m->msg_len > 0) {
+
+      return m->msg_len;
+    }
+    dp->rx_next++;
+  }
+  return 0;
+}
+
 // -----------------------------------------------------------------------------
 static int
 prvIoPoll (gxPLIo * io, int * available_data, int timeout_ms) {
@@ -512,16 +652,29 @@ prvIoPoll (gxPLIo * io, int * available_data, int timeout_ms) {
   struct timeval timeout;
   long timeout_us = timeout_ms * 1000L;
 
+  /* The datagrams already received are delivered without waiting */
+  ret = prvRingNext (io);
+  if (ret > 0) {
+
+    *available_data = ret;
+    return 0;
+  }
+
   /* Initialize the file descriptor set. */
   FD_ZERO (&set);
   FD_SET (dp->ifd, &set);
+  if (dp->wfd >= 0) {
+
+    // the owner of the descriptor reads it, the poll only returns
+    FD_SET (dp->wfd, &set);
+  }
 
   /* Initialize the timeout data structure. */
   timeout.tv_sec  = timeout_us / 1000000L;
   timeout.tv_usec = timeout_us % 1000000L;
 
   /* select returns 0 if timeout, 1 if input available, -1 if error. */
-  ret = select (FD_SETSIZE, &set, NULL, NULL, &timeout);
+  ret = select (FD_SETSIZE, &set, NULL, NULL, (timeout_ms < 0) ? NULL : &timeout);
   if (ret == -1) {
     if (errno != EINTR) {
       PERROR ("failed to poll listen socket: %s", strerror (errno));
@@ -532,7 +685,17 @@ prvIoPoll (gxPLIo * io, int * available_data, int timeout_ms) {
   }
   else if ( (ret > 0) && (FD_ISSET (dp->ifd, &set))) {
 
-    ret = ioctl (dp->ifd, FIONREAD, available_data);
+    ret = prvRingFill (io);
+    if (ret >= 0) {
+
+      *available_data = prvRingNext (io);
+      ret = 0;
+    }
+  }
+  else if (ret > 0) {
+
+    // woken up, no datagram
+    ret = 0;
   }
 
   return ret;
@@ -550,6 +713,7 @@ gxPLUdpOpen (gxPLIo * io) {
     assert (io->pdata);
     dp->ifd = -1;
     dp->ofd = -1;
+    dp->wfd = -1;
 
     // Setup the broadcasting interface
     if (prvMakeBroadcastConnection (io) < 0) {
@@ -586,17 +750,26 @@ gxPLUdpRecv (gxPLIo * io, void * buffer, int count, gxPLIoAddr * source) {
   struct sockaddr_in client;
   socklen_t addrlen = sizeof (client);
 
+  if (prvRingNext (io) > 0) {
+    struct mmsghdr * m = &dp->rx_msg[dp->rx_next++];
+
+    // Delivers the next datagram of the ring
+    ret = MIN (count, m->msg_len);
+    memcpy (buffer, dp->rx_buf[m - dp->rx_msg], ret);
+    if (source) {
+
+      prvSourceAddrSet (source, m->msg_hdr.msg_name);
+    }
+    return ret;
+  }
+
   ret = recvfrom (dp->ifd, buffer, count, 0, (struct sockaddr *) &client, &addrlen);
 
   if (ret >= 0) {
 
     if (source)  {
       // Send, get and copy the source address
-      source->family = gxPLNetFamilyInet4;
-      source->addrlen = MIN (sizeof (source->addr), sizeof (client.sin_addr.s_addr));
-      source->port = ntohs (client.sin_port);
-      source->flag = 0;
-      memcpy (source->addr, &client.sin_addr.s_addr, source->addrlen);
+      prvSourceAddrSet (source, &client);
     }
   }
   else {
@@ -616,35 +789,142 @@ gxPLUdpRecv (gxPLIo * io, void * buffer, int count, gxPLIoAddr * source) {
   return ret;
 }
 
+/* -----------------------------------------------------------------------------
+ * Hands the buffer of the next datagram of the ring over to the caller, the
+ * slot is refilled with a buffer allocated by *allocator */
+static int
+gxPLUdpRecvBuffer (gxPLIo * io, char ** buffer, gxPLAllocator ** allocator) {
+  int size = prvRingNext (io);
+
+  if (size > 0) {
+    int i = dp->rx_next;
+    gxPLAllocator * a = dp->rx_alloc[i];
+    char * refill = gxPLAllocatorAlloc (*allocator, DEFAULT_UDP_BUFSIZE + 1);
+
+    if (refill == NULL) {
+
+      // the datagram stays in the ring
+      errno = ENOMEM;
+      return -1;
+    }
+    *buffer = dp->rx_buf[i];
+    (*buffer)[size] = '\0';
+    dp->rx_buf[i] = refill;
+    dp->rx_alloc[i] = *allocator;
+    *allocator = a;
+    dp->rx_next++;
+  }
+  return size;
+}
+
 // -----------------------------------------------------------------------------
 static int
 gxPLUdpSend (gxPLIo * io, const void * buffer, int count, const gxPLIoAddr * target) {
   int bytes_sent, addrlen = sizeof (struct sockaddr_in);
   struct sockaddr_in a;
-  struct sockaddr * addrdst = (struct sockaddr *) &dp->bcast_addr;
 
-  if (target) {
+  prvTargetAddr (io, target, &a);
+
+  // Try to send the message
+  if ( (bytes_sent = sendto (dp->ofd, buffer, count, 0,
+                             (struct sockaddr *) &a, addrlen)) != count) {
+    PERROR ("Unable to deliver the message, %s (%d)",
+            strerror (errno), errno);
+    return -1;
+  }
+  PDEBUG ("Send %d bytes (of %d attempted)", bytes_sent, count);
+
+  return bytes_sent;
+}
+
+/* -----------------------------------------------------------------------------
+ * Sends the fragments of a message with sendmsg(), the kernel gathers them */
+static int
+gxPLUdpSendv (gxPLIo * io, const gxPLIoVec * iov, int iovcnt,
+              const gxPLIoAddr * target) {
+  struct iovec v[DEFAULT_UDP_IOV_MAX];
+  struct sockaddr_in a;
+  struct msghdr msg;
+  int bytes_sent, count = 0;
 
-    if ( (target->isbroadcast == 0) && (target->family == gxPLNetFamilyInet4)) {
+  if (iovcnt > DEFAULT_UDP_IOV_MAX) {
 
-      a.sin_family = AF_INET;
-      memcpy (&a.sin_addr.s_addr, target->addr,  sizeof (a.sin_addr.s_addr));
-      a.sin_port = htons (target->port);
-      addrdst = (struct sockaddr *) &a;
-    }
+    errno = EMSGSIZE;
+    return -1;
   }
 
-  // Try to send the message
-  if ( (bytes_sent = sendto (dp->ofd, buffer, count, 0, addrdst, addrlen)) != count) {
+  for (int i = 0; i < iovcnt; i++) {
+
+    v[i].iov_base = (void *) iov[i].base;
+    v[i].iov_len = iov[i].len;
+    count += iov[i].len;
+  }
+
+  prvTargetAddr (io, target, &a);
+  memset (&msg, 0, sizeof (msg));
+  msg.msg_name = &a;
+  msg.msg_namelen = sizeof (struct sockaddr_in);
+  msg.msg_iov = v;
+  msg.msg_iovlen = iovcnt;
+
+  if ( (bytes_sent = sendmsg (dp->ofd, &msg, 0)) != count) {
     PERROR ("Unable to deliver the message, %s (%d)",
             strerror (errno), errno);
     return -1;
   }
-  PDEBUG ("Send %d bytes (of %d attempted)", bytes_sent, count);
+  PDEBUG ("Send %d bytes in %d fragments", bytes_sent, iovcnt);
 
   return bytes_sent;
 }
 
+/* -----------------------------------------------------------------------------
+ * Sends a message to all targets with a sendmmsg() call for each batch of
+ * DEFAULT_UDP_SEND_BATCH targets */
+static int
+gxPLUdpSendMulti (gxPLIo * io, const void * buffer, int count,
+                  const gxPLIoAddr * const * targets, int ntargets) {
+  struct mmsghdr msg[DEFAULT_UDP_SEND_BATCH];
+  struct sockaddr_in addr[DEFAULT_UDP_SEND_BATCH];
+  struct iovec iov = { .iov_base = (void *) buffer, .iov_len = count };
+  int sent = 0;
+
+  for (int i = 0; i < ntargets;) {
+    int n = MIN (ntargets - i, DEFAULT_UDP_SEND_BATCH);
+    int ret;
+
+    memset (msg, 0, n * sizeof (struct mmsghdr));
+    for (int j = 0; j < n; j++) {
+
+      prvTargetAddr (io, targets[i + j], &addr[j]);
+      msg[j].msg_hdr.msg_name = &addr[j];
+      msg[j].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+      msg[j].msg_hdr.msg_iov = &iov;
+      msg[j].msg_hdr.msg_iovlen = 1;
+    }
+
+    ret = sendmmsg (dp->ofd, msg, n, 0);
+    if (ret <= 0) {
+
+      if ( (ret < 0) && (errno == EINTR)) {
+
+        continue;
+      }
+      // the first target of the batch is skipped, the next are retried
+      PERROR ("Unable to deliver the message, %s (%d)",
+              strerror (errno), errno);
+      ret = 1;
+    }
+    else {
+
+      sent += ret;
+    }
+    i += ret;
+  }
+  PDEBUG ("Send %d bytes to %d targets (of %d attempted)", count, sent, ntargets);
+
+  return ( (sent == 0) && (ntargets > 0)) ? -1 : sent;
+}
+
 // -----------------------------------------------------------------------------
 static int
 gxPLUdpClose (gxPLIo * io) {
@@ -666,6 +946,10 @@ gxPLUdpClose (gxPLIo * io) {
     PERROR ("failed to close bind socket: %s", strerror (errno));
   }
   vVectorDestroy (&dp->addr_list);
+  for (int i = 0; i < DEFAULT_UDP_RING_SIZE; i++) {
+
+    gxPLAllocatorFree (dp->rx_alloc[i], dp->rx_buf[i]);
+  }
   free (io->pdata);
   io->pdata = NULL;
   return ret;
@@ -719,7 +1003,8 @@ gxPLUdpCtl (gxPLIo * io, int c, va_list ap) {
         struct in_addr net_addr;
 
         memcpy (&net_addr.s_addr, addr->addr, sizeof (net_addr.s_addr));
-        *str_addr = inet_ntoa (net_addr);
+        *str_addr = (char *) inet_ntop (AF_INET, &net_addr, dp->addr_str,
+                                        sizeof (dp->addr_str));
       }
       else {
 
@@ -737,6 +1022,7 @@ gxPLUdpCtl (gxPLIo * io, int c, va_list ap) {
 
       addr->family = gxPLNetFamilyInet4;
       addr->addrlen = sizeof (net_addr.s_addr);
+      addr->isbroadcast = 0;
       ret = inet_aton (str_addr, &net_addr);
 
       if (ret != 0) {
@@ -759,6 +1045,18 @@ gxPLUdpCtl (gxPLIo * io, int c, va_list ap) {
     }
     break;
 
+    // int gxPLIoCtl (gxPLIo * io, gxPLIoFuncGetFd, int * fd)
+    case gxPLIoFuncGetFd: {
+      int * fd = va_arg (ap, int*);
+      *fd = dp->ifd;
+    }
+    break;
+
+    // int gxPLIoCtl (gxPLIo * io, gxPLIoFuncSetWakeFd, int fd)
+    case gxPLIoFuncSetWakeFd:
+      dp->wfd = va_arg (ap, int);
+      break;
+
     default:
       errno = EINVAL;
       ret = -1;
@@ -773,7 +1071,10 @@ static gxPLIoOps
 ops = {
   .open  = gxPLUdpOpen,
   .recv  = gxPLUdpRecv,
+  .recvbuf = gxPLUdpRecvBuffer,
   .send  = gxPLUdpSend,
+  .sendmulti = gxPLUdpSendMulti,
+  .sendv = gxPLUdpSendv,
   .close = gxPLUdpClose,
   .ctl   = gxPLUdpCtl
 };
@@ -36,6 +36,7 @@ typedef struct xbeezb_data {
 
   volatile int fid; // frame id
   int modem_status;
+  char addr_str[8 * 3]; /* result of gxPLIoFuncNetAddrToString */
 } xbeezb_data;
 
 /* macros =================================================================== */
@@ -47,8 +48,7 @@ typedef struct xbeezb_data {
 // gxPLNetFamilyZigbee16: xx:xx
 // gxPLNetFamilyZigbee64: xx:xx:xx:xx:xx:xx:xx:xx
 static const char *
-prvZbAddrToString (uint8_t * zbaddr, uint8_t zbaddr_size) {
-  static char buffer[8 * 3];
+prvZbAddrToString (uint8_t * zbaddr, uint8_t zbaddr_size, char * buffer) {
 
   buffer[0] = '\0';
 
@@ -200,8 +200,10 @@ prvZbTxStatusCB (xXBee *xbee, xXBeePkt *pkt, uint8_t len) {
 static int
 prvZbNodeIdCB (xXBee * xbee, xXBeePkt * pkt, uint8_t len) {
 
+  char str[8 * 3];
+
   PINFO ("%s joined zigbee network",
-         prvZbAddrToString (pucXBeePktAddrRemote64 (pkt), 8));
+         prvZbAddrToString (pucXBeePktAddrRemote64 (pkt), 8, str));
   vXBeeFreePkt (xbee, pkt);
   return 0;
 }
@@ -236,12 +238,18 @@ static int
 prvIoPoll (gxPLIo * io, int * available_data, int timeout_ms) {
   int ret = 0;
 
-  while ( (timeout_ms > 0) && (dp->rxpkt == NULL) && (ret == 0)) {
+  // polls at least once, a negative timeout waits for a packet
+  do {
+    int slice = ( (timeout_ms >= 0) && (timeout_ms < 10)) ? timeout_ms : 10;
 
-    // loop until AT response was received (or timeout or error)
-    ret = iXBeePoll (dp->xbee, 10);
-    timeout_ms -= 10;
+    // loop until a packet was received (or timeout or error)
+    ret = iXBeePoll (dp->xbee, slice);
+    if (timeout_ms > 0) {
+
+      timeout_ms -= slice;
+    }
   }
+  while ( (timeout_ms != 0) && (dp->rxpkt == NULL) && (ret == 0));
 
   if (ret == 0) {
 
@@ -746,7 +754,7 @@ gxPLXBeeZbCtl (gxPLIo * io, int c, va_list ap) {
            (addr->family == gxPLNetFamilyZigbee64)) {
         const char ** str_addr = va_arg (ap, char**);
 
-        *str_addr = prvZbAddrToString (addr->addr, addr->addrlen);
+        *str_addr = prvZbAddrToString (addr->addr, addr->addrlen, dp->addr_str);
       }
       else {
 
@@ -765,6 +773,18 @@ gxPLXBeeZbCtl (gxPLIo * io, int c, va_list ap) {
     }
     break;
 
+#if CONFIG_XBEEZB_FILENO
+    // int gxPLIoCtl (gxPLIo * io, gxPLIoFuncGetFd, int * fd)
+    case gxPLIoFuncGetFd: {
+      int * fd = va_arg (ap, int*);
+
+      // descriptor of the serial port, the packets are read by iXBeePoll()
+      *fd = iXBeeFileNo (dp->xbee);
+      ret = (*fd < 0) ? -1 : 0;
+    }
+    break;
+#endif
+
     default:
       errno = EINVAL;
       ret = -1;
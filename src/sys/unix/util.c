@@ -24,6 +24,26 @@
 
 /* private functions ======================================================== */
 
+// -----------------------------------------------------------------------------
+static int
+prvTimeFormat (unsigned long time, const char * format, char * buf, int len) {
+  time_t t = time;
+  struct tm tm;
+  size_t count;
+
+  if (localtime_r (&t, &tm) == NULL) {
+
+    return -1;
+  }
+
+  count = strftime (buf, len, format, &tm);
+  if ( (count == 0) && (*format != '\0')) {
+
+    errno = ENOBUFS;
+    return -1;
+  }
+  return count;
+}
 
 /* api functions ============================================================ */
 
@@ -48,17 +68,29 @@ gxPLTimeMs (unsigned long * ms) {
   return ret;
 }
 
+// -----------------------------------------------------------------------------
+int
+gxPLTimeMonotonicMs (unsigned long * ms) {
+  int ret;
+  struct timespec ts;
+
+  if ( (ret = clock_gettime (CLOCK_MONOTONIC, &ts)) == 0) {
+
+    *ms = (ts.tv_sec * 1000UL) + (ts.tv_nsec / 1000000UL);
+    return 0;
+  }
+  return ret;
+}
+
 // -----------------------------------------------------------------------------
 char *
 gxPLDateTimeStr (unsigned long time, const char * format) {
   static char buf[41];
 
-  if (format == NULL) {
-    //yyyymmddhhmmss
-    format = "%Y%m%d%H%M%S";
-  }
-  strftime (buf, sizeof (buf) - 1, format, localtime ( (time_t *) &time));
+  if (gxPLDateTimeToBuffer (time, format, buf, sizeof (buf)) < 0) {
 
+    buf[0] = '\0';
+  }
   return buf;
 }
 
@@ -67,12 +99,10 @@ char *
 gxPLDateStr (unsigned long time, const char * format) {
   static char buf[16];
 
-  if (format == NULL) {
-    //yyyymmdd
-    format = "%Y%m%d";
-  }
-  strftime (buf, sizeof (buf) - 1, format, localtime ( (time_t *) &time));
+  if (gxPLDateToBuffer (time, format, buf, sizeof (buf)) < 0) {
 
+    buf[0] = '\0';
+  }
   return buf;
 }
 
@@ -81,13 +111,44 @@ char *
 gxPLTimeStr (unsigned long time, const char * format) {
   static char buf[16];
 
+  if (gxPLTimeToBuffer (time, format, buf, sizeof (buf)) < 0) {
+
+    buf[0] = '\0';
+  }
+  return buf;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLDateTimeToBuffer (unsigned long time, const char * format, char * buf, int len) {
+
+  if (format == NULL) {
+    //yyyymmddhhmmss
+    format = "%Y%m%d%H%M%S";
+  }
+  return prvTimeFormat (time, format, buf, len);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLDateToBuffer (unsigned long time, const char * format, char * buf, int len) {
+
+  if (format == NULL) {
+    //yyyymmdd
+    format = "%Y%m%d";
+  }
+  return prvTimeFormat (time, format, buf, len);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLTimeToBuffer (unsigned long time, const char * format, char * buf, int len) {
+
   if (format == NULL) {
     //hhmmss
     format = "%H%M%S";
   }
-  strftime (buf, sizeof (buf) - 1, format, localtime ( (time_t *) &time));
-
-  return buf;
+  return prvTimeFormat (time, format, buf, len);
 }
 
 // -----------------------------------------------------------------------------
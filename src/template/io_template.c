@@ -153,6 +153,17 @@ gxPLTemplateCtl (gxPLIo * io, int c, va_list ap) {
     }
     break;
 
+    // int gxPLIoCtl (gxPLIo * io, gxPLIoFuncGetFd, int * fd)
+    // optional, allows gxPLAppFd() to wait for the layer in an event loop
+    case gxPLIoFuncGetFd: {
+      int * fd = va_arg (ap, int*);
+      // TODO
+      // *fd = ? ;
+      errno = EINVAL;
+      ret = -1;
+    }
+    break;
+
     default:
       errno = EINVAL;
       ret = -1;
@@ -0,0 +1,279 @@
+/**
+ * @file
+ * Hierarchical timer wheel
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL/util.h>
+#include "timer_p.h"
+
+/* constants ================================================================ */
+#define WHEEL_MASK  (GXPL_TIMER_WHEEL_SIZE - 1)
+#define WHEEL_RANGE (1UL << (DEFAULT_TIMER_WHEEL_BITS * DEFAULT_TIMER_WHEEL_LEVELS))
+
+/* macros =================================================================== */
+#define SHIFT(level) ((level) * DEFAULT_TIMER_WHEEL_BITS)
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+prvLink (gxPLTimer ** head, gxPLTimer * timer) {
+
+  timer->next = *head;
+  if (timer->next) {
+
+    timer->next->pprev = &timer->next;
+  }
+  timer->pprev = head;
+  *head = timer;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvUnlink (gxPLTimer * timer) {
+
+  *timer->pprev = timer->next;
+  if (timer->next) {
+
+    timer->next->pprev = timer->pprev;
+  }
+  timer->next = NULL;
+  timer->pprev = NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * Moves the list of a slot to head, the slot becomes empty */
+static void
+prvSplice (gxPLTimer ** head, gxPLTimer ** slot) {
+
+  *head = *slot;
+  *slot = NULL;
+  if (*head) {
+
+    (*head)->pprev = head;
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Adds a timer in the slot matching its expiry */
+static void
+prvInsert (gxPLTimerWheel * wheel, gxPLTimer * timer) {
+  unsigned long expires = timer->expires;
+  long delta = (long) (expires - wheel->tick);
+  int level = 0;
+
+  if (delta < 0) {
+
+    // already expired, processed on the next tick
+    expires = wheel->tick;
+  }
+  else {
+
+    if ( (unsigned long) delta >= WHEEL_RANGE) {
+
+      // beyond the last level, it will be moved back when reached
+      expires = wheel->tick + WHEEL_RANGE - 1;
+      delta = WHEEL_RANGE - 1;
+    }
+
+    while ( (level < (DEFAULT_TIMER_WHEEL_LEVELS - 1)) &&
+            ( (unsigned long) delta >= (1UL << SHIFT (level + 1)))) {
+
+      level++;
+    }
+  }
+
+  prvLink (&wheel->slot[level][ (expires >> SHIFT (level)) & WHEEL_MASK], timer);
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the first tick that has to be processed (expiry or cascade),
+ * the wheel must contain at least one timer */
+static unsigned long
+prvNextTick (const gxPLTimerWheel * wheel) {
+  unsigned long next = wheel->tick + WHEEL_RANGE;
+
+  for (int level = 0; level < DEFAULT_TIMER_WHEEL_LEVELS; level++) {
+    unsigned long base = wheel->tick >> SHIFT (level);
+    int first = 0;
+
+    if ( (wheel->tick & ( (1UL << SHIFT (level)) - 1)) != 0) {
+
+      // the current slot of this level has already been moved down
+      first = 1;
+    }
+
+    for (int i = first; i <= GXPL_TIMER_WHEEL_SIZE; i++) {
+
+      if (wheel->slot[level][ (base + i) & WHEEL_MASK]) {
+        unsigned long tick = (base + i) << SHIFT (level);
+
+        if ( (long) (tick - next) < 0) {
+
+          next = tick;
+        }
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+/* -----------------------------------------------------------------------------
+ * Processes the current tick of the wheel */
+static int
+prvTickRun (gxPLTimerWheel * wheel) {
+  gxPLTimer * head;
+  int count = 0;
+  unsigned long index = wheel->tick & WHEEL_MASK;
+
+  if (index == 0) {
+
+    // moves the timers of the higher levels reached
+    for (int level = 1; level < DEFAULT_TIMER_WHEEL_LEVELS; level++) {
+
+      index = (wheel->tick >> SHIFT (level)) & WHEEL_MASK;
+      prvSplice (&head, &wheel->slot[level][index]);
+      while (head) {
+        gxPLTimer * timer = head;
+
+        prvUnlink (timer);
+        prvInsert (wheel, timer);
+      }
+
+      if (index != 0) {
+
+        break;
+      }
+    }
+  }
+
+  prvSplice (&head, &wheel->slot[0][wheel->tick & WHEEL_MASK]);
+  // a timer restarted by its function is never run on the same tick
+  wheel->tick++;
+
+  while (head) {
+    gxPLTimer * timer = head;
+
+    prvUnlink (timer);
+    wheel->count--;
+    count++;
+    timer->func (timer, timer->data);
+  }
+  return count;
+}
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+void
+gxPLTimerWheelInit (gxPLTimerWheel * wheel) {
+
+  memset (wheel, 0, sizeof (gxPLTimerWheel));
+  wheel->clock = gxPLTimeMonotonicMs;
+  wheel->tick = gxPLTimerWheelUpdate (wheel) / DEFAULT_TIMER_TICK_MS;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLTimerWheelClockSet (gxPLTimerWheel * wheel, gxPLTimerClock clock) {
+
+  if (wheel->count > 0) {
+
+    return -1;
+  }
+  wheel->clock = clock;
+  wheel->tick = gxPLTimerWheelUpdate (wheel) / DEFAULT_TIMER_TICK_MS;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+unsigned long
+gxPLTimerWheelUpdate (gxPLTimerWheel * wheel) {
+
+  (void) wheel->clock (&wheel->now);
+  return wheel->now;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLTimerInit (gxPLTimer * timer, gxPLTimerCallback func, void * udata) {
+
+  memset (timer, 0, sizeof (gxPLTimer));
+  timer->func = func;
+  timer->data = udata;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLTimerStart (gxPLTimerWheel * wheel, gxPLTimer * timer,
+                unsigned long delay_ms) {
+  unsigned long now = wheel->now;
+
+  gxPLTimerStop (wheel, timer);
+  // rounded up to the next tick, never expires on a tick already processed
+  timer->expires = (now + delay_ms + DEFAULT_TIMER_TICK_MS - 1) / DEFAULT_TIMER_TICK_MS;
+  if (timer->expires == now / DEFAULT_TIMER_TICK_MS) {
+
+    timer->expires++;
+  }
+  prvInsert (wheel, timer);
+  wheel->count++;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLTimerStop (gxPLTimerWheel * wheel, gxPLTimer * timer) {
+
+  if (gxPLTimerIsPending (timer)) {
+
+    prvUnlink (timer);
+    wheel->count--;
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLTimerWheelRun (gxPLTimerWheel * wheel) {
+  int count = 0;
+  unsigned long now = wheel->now / DEFAULT_TIMER_TICK_MS;
+
+  // the ticks without expiry or cascade are skipped
+  while (wheel->count > 0) {
+    unsigned long next = prvNextTick (wheel);
+
+    if ( (long) (next - now) > 0) {
+
+      break;
+    }
+    wheel->tick = next;
+    count += prvTickRun (wheel);
+  }
+
+  if ( (long) (now - wheel->tick) >= 0) {
+
+    // all the ticks up to now have been processed
+    wheel->tick = now + 1;
+  }
+  return count;
+}
+
+// -----------------------------------------------------------------------------
+long
+gxPLTimerWheelNext (const gxPLTimerWheel * wheel) {
+
+  if (wheel->count > 0) {
+    long delta = (long) (prvNextTick (wheel) * DEFAULT_TIMER_TICK_MS - wheel->now);
+
+    return (delta > 0) ? delta : 0;
+  }
+  return -1;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,155 @@
+/**
+ * @file
+ * Hierarchical timer wheel internal include
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_TIMER_PRIVATE_HEADER_
+#define _GXPL_TIMER_PRIVATE_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/* constants ================================================================ */
+#ifndef DEFAULT_TIMER_TICK_MS
+#define DEFAULT_TIMER_TICK_MS 1
+#endif
+
+#ifndef DEFAULT_TIMER_WHEEL_BITS
+#define DEFAULT_TIMER_WHEEL_BITS 6
+#endif
+
+#ifndef DEFAULT_TIMER_WHEEL_LEVELS
+#define DEFAULT_TIMER_WHEEL_LEVELS 4
+#endif
+
+#define GXPL_TIMER_WHEEL_SIZE (1 << DEFAULT_TIMER_WHEEL_BITS)
+
+/* structures =============================================================== */
+typedef struct _gxPLTimer gxPLTimer;
+
+/*
+ * @brief Clock of a wheel, see gxPLTimeMonotonicMs()
+ */
+typedef int (*gxPLTimerClock) (unsigned long * ms);
+
+/*
+ * @brief Function called when a timer expires
+ *
+ * The timer is no longer scheduled when the function is called, it can be
+ * restarted or released by the function.
+ */
+typedef void (*gxPLTimerCallback) (gxPLTimer * timer, void * udata);
+
+/*
+ * @brief Timer, usually embedded in the object it belongs to
+ */
+struct _gxPLTimer {
+  gxPLTimer * next;
+  gxPLTimer ** pprev; /* NULL if the timer is not scheduled */
+  unsigned long expires; /* in ticks */
+  gxPLTimerCallback func;
+  void * data;
+};
+
+/*
+ * @brief Hierarchical timer wheel
+ *
+ * Each level has GXPL_TIMER_WHEEL_SIZE slots, a slot of the level n covers
+ * GXPL_TIMER_WHEEL_SIZE^n ticks. The timers of a slot are moved to the lower
+ * level when the wheel reaches it, so scheduling and cancelling are O(1).
+ */
+typedef struct _gxPLTimerWheel {
+  unsigned long now; /* monotonic time in ms, updated by gxPLTimerWheelUpdate */
+  gxPLTimerClock clock; /* read by gxPLTimerWheelUpdate */
+  unsigned long tick; /* next tick to process */
+  int count; /* number of scheduled timers */
+  gxPLTimer * slot[DEFAULT_TIMER_WHEEL_LEVELS][GXPL_TIMER_WHEEL_SIZE];
+} gxPLTimerWheel;
+
+/* internal private functions =============================================== */
+
+/*
+ * @brief Initializes an empty wheel
+ */
+void gxPLTimerWheelInit (gxPLTimerWheel * wheel);
+
+/*
+ * @brief Replaces the monotonic clock of an empty wheel
+ *
+ * Used by the tests to control the time, the wheel starts at the time of
+ * the new clock.
+ * @return 0, -1 if timers are scheduled
+ */
+int gxPLTimerWheelClockSet (gxPLTimerWheel * wheel, gxPLTimerClock clock);
+
+/*
+ * @brief Updates the time of the wheel from the monotonic clock
+ *
+ * The clock is read once per poll, the timers started and the delays measured
+ * until the next update use this time.
+ * @return the new time in milliseconds
+ */
+unsigned long gxPLTimerWheelUpdate (gxPLTimerWheel * wheel);
+
+/*
+ * @brief Time of the last update in milliseconds
+ */
+static inline unsigned long
+gxPLTimerWheelNow (const gxPLTimerWheel * wheel) {
+
+  return wheel->now;
+}
+
+/*
+ * @brief Initializes a timer that is not scheduled
+ * @param timer
+ * @param func function called on expiry
+ * @param udata user data passed to func
+ */
+void gxPLTimerInit (gxPLTimer * timer, gxPLTimerCallback func, void * udata);
+
+/*
+ * @brief Schedules a timer, if it is already scheduled it is restarted
+ * @param wheel
+ * @param timer
+ * @param delay_ms delay from the time of the wheel in milliseconds
+ */
+void gxPLTimerStart (gxPLTimerWheel * wheel, gxPLTimer * timer,
+                     unsigned long delay_ms);
+
+/*
+ * @brief Cancels a timer, nothing is done if it is not scheduled
+ */
+void gxPLTimerStop (gxPLTimerWheel * wheel, gxPLTimer * timer);
+
+/*
+ * @brief Checks if a timer is scheduled
+ */
+static inline int
+gxPLTimerIsPending (const gxPLTimer * timer) {
+
+  return timer->pprev != NULL;
+}
+
+/*
+ * @brief Calls the functions of all the timers expired at the time of the wheel
+ * @return number of expired timers
+ */
+int gxPLTimerWheelRun (gxPLTimerWheel * wheel);
+
+/*
+ * @brief Time before the wheel must be run again, from the time of the wheel
+ *
+ * The value returned is never later than the next expiry, it can be earlier
+ * if timers have to be moved between levels.
+ * @return delay in milliseconds, -1 if no timer is scheduled
+ */
+long gxPLTimerWheelNext (const gxPLTimerWheel * wheel);
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_TIMER_PRIVATE_HEADER_ defined */
@@ -0,0 +1,311 @@
+/**
+ * @file
+ * Interned strings
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL/util.h>
+#include "hash_p.h"
+#include "lock_p.h"
+#include "token_p.h"
+
+/* constants ================================================================ */
+#ifndef DEFAULT_TOKEN_HASH_SIZE
+#define DEFAULT_TOKEN_HASH_SIZE 64
+#endif
+
+#ifndef DEFAULT_TOKEN_MAX
+#define DEFAULT_TOKEN_MAX 1024
+#endif
+
+/* structures =============================================================== */
+typedef struct _token_elmt {
+  gxPLHashNode node;
+  int token;
+  char str[];
+} token_elmt;
+
+/* private variables ======================================================== */
+static gxPLHash table;
+static int token_count;
+static unsigned long token_hit;
+static unsigned long token_miss;
+static gxPLMutex lock = GXPL_MUTEX_INITIALIZER;
+
+// in the order of gxPLToken
+static const char * well_known[] = {
+  "hbeat", "config", "app", "basic", "end", "request", "list", "current",
+  "response"
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static int
+prvTokenMatch (const gxPLHashNode * node, const void * key) {
+
+  return strcmp (gxPLHashEntry (node, token_elmt, node)->str, (const char *) key);
+}
+
+// -----------------------------------------------------------------------------
+static token_elmt *
+prvTokenFind (const char * str, unsigned long hash) {
+
+  if (table.bucket) {
+    gxPLHashNode * node = gxPLHashFind (&table, hash, str, prvTokenMatch);
+
+    if (node) {
+
+      token_hit++;
+      return gxPLHashEntry (node, token_elmt, node);
+    }
+  }
+  token_miss++;
+  return NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * Hash of the string vendor-device.instance of an identifier, without
+ * formatting it */
+static unsigned long
+prvIdHash (const gxPLId * id) {
+  unsigned long hash = gxPLHashStr (GXPL_HASH_INIT, id->vendor);
+
+  hash = gxPLHashStr (gxPLHashStr (hash, "-"), id->device);
+  return gxPLHashStr (gxPLHashStr (hash, "."), id->instance);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvIdMatch (const gxPLHashNode * node, const void * key) {
+  const char * str = gxPLHashEntry (node, token_elmt, node)->str;
+  const gxPLId * id = (const gxPLId *) key;
+  int len = strlen (id->vendor);
+
+  if ( (strncmp (str, id->vendor, len) != 0) || (str[len] != '-')) {
+
+    return 1;
+  }
+  str += len + 1;
+  len = strlen (id->device);
+  if ( (strncmp (str, id->device, len) != 0) || (str[len] != '.')) {
+
+    return 1;
+  }
+  return strcmp (str + len + 1, id->instance);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvIdLookup (const gxPLId * id) {
+
+  if (table.bucket) {
+    gxPLHashNode * node = gxPLHashFind (&table, prvIdHash (id), id, prvIdMatch);
+
+    if (node) {
+
+      token_hit++;
+      return gxPLHashEntry (node, token_elmt, node)->token;
+    }
+  }
+  token_miss++;
+  return GXPL_TOKEN_NONE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Adds a string to the table, fails if the table is full */
+static token_elmt *
+prvTokenAdd (const char * str, unsigned long hash) {
+  token_elmt * e;
+
+  if (token_count >= DEFAULT_TOKEN_MAX) {
+
+    PDEBUG ("token table full, %s not interned", str);
+    return NULL;
+  }
+
+  e = malloc (sizeof (token_elmt) + strlen (str) + 1);
+  if (e) {
+
+    strcpy (e->str, str);
+    e->token = ++token_count;
+    gxPLHashAdd (&table, &e->node, hash);
+  }
+  return e;
+}
+
+/* -----------------------------------------------------------------------------
+ * Creates the table with the well-known tokens */
+static int
+prvTableInit (void) {
+
+  if (gxPLHashInit (&table, DEFAULT_TOKEN_HASH_SIZE) == 0) {
+
+    for (int i = 0; i < sizeof (well_known) / sizeof (well_known[0]); i++) {
+      const char * str = well_known[i];
+
+      if (prvTokenAdd (str, gxPLHashStr (GXPL_HASH_INIT, str)) == NULL) {
+
+        return -1;
+      }
+    }
+    return 0;
+  }
+  return -1;
+}
+
+/* -----------------------------------------------------------------------------
+ * Looks up a string, the lock must be held. The table is created by the first
+ * string interned, until then only the well-known strings have a token and a
+ * lookup allocates nothing */
+static int
+prvLookup (const char * str) {
+
+  if (table.bucket) {
+    token_elmt * e = prvTokenFind (str, gxPLHashStr (GXPL_HASH_INIT, str));
+
+    return (e) ? e->token : GXPL_TOKEN_NONE;
+  }
+  for (int i = 0; i < sizeof (well_known) / sizeof (well_known[0]); i++) {
+
+    if (strcmp (str, well_known[i]) == 0) {
+
+      token_hit++;
+      return i + 1;
+    }
+  }
+  token_miss++;
+  return GXPL_TOKEN_NONE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Looks up several strings, the lock must be held */
+static void
+prvLookupArray (const char * const * str, int * token, int count) {
+
+  for (int i = 0; i < count; i++) {
+
+    token[i] = prvLookup (str[i]);
+  }
+}
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLTokenIntern (const char * str) {
+  unsigned long hash = gxPLHashStr (GXPL_HASH_INIT, str);
+  token_elmt * e;
+  int token = GXPL_TOKEN_NONE;
+
+  gxPLMutexLock (&lock);
+  if ( (table.bucket != NULL) || (prvTableInit () == 0)) {
+
+    e = prvTokenFind (str, hash);
+    if (e == NULL) {
+
+      e = prvTokenAdd (str, hash);
+    }
+    if (e) {
+
+      token = e->token;
+    }
+  }
+  gxPLMutexUnlock (&lock);
+  return token;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLTokenLookup (const char * str) {
+  int token;
+
+  gxPLMutexLock (&lock);
+  token = prvLookup (str);
+  gxPLMutexUnlock (&lock);
+  return token;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLTokenInternId (const gxPLId * id) {
+  char str[GXPL_VENDORID_MAX + GXPL_DEVICEID_MAX + GXPL_INSTANCEID_MAX + 3];
+
+  snprintf (str, sizeof (str), "%s-%s.%s", id->vendor, id->device, id->instance);
+  return gxPLTokenIntern (str);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLTokenLookupId (const gxPLId * id) {
+  int token;
+
+  gxPLMutexLock (&lock);
+  token = prvIdLookup (id);
+  gxPLMutexUnlock (&lock);
+  return token;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLTokenLookupArray (const char * const * str, int * token, int count) {
+
+  gxPLMutexLock (&lock);
+  prvLookupArray (str, token, count);
+  gxPLMutexUnlock (&lock);
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLTokenLookupHeader (const gxPLSchema * schema, const gxPLId * source,
+                       const gxPLId * target, int * token) {
+  const char * str[2] = { schema->class, schema->type };
+
+  gxPLMutexLock (&lock);
+  prvLookupArray (str, token, 2);
+  token[2] = prvIdLookup (source);
+  token[3] = prvIdLookup (target);
+  gxPLMutexUnlock (&lock);
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLTokenIs (int token, int known, const char * str) {
+
+  if (token == known) {
+
+    return 1;
+  }
+  // the tokens are case sensitive
+  return strcasecmp (str, well_known[known - 1]) == 0;
+}
+
+/* public api functions ===================================================== */
+
+// -----------------------------------------------------------------------------
+int
+gxPLTokenStats (unsigned long * hit, unsigned long * miss) {
+  int count;
+
+  gxPLMutexLock (&lock);
+  // the well-known strings have their token before the table is created
+  count = (table.bucket) ? token_count : sizeof (well_known) / sizeof (well_known[0]);
+  if (hit) {
+
+    *hit = token_hit;
+  }
+  if (miss) {
+
+    *miss = token_miss;
+  }
+  gxPLMutexUnlock (&lock);
+  return count;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,101 @@
+/**
+ * @file
+ * Interned strings internal include
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#ifndef _GXPL_TOKEN_PRIVATE_HEADER_
+#define _GXPL_TOKEN_PRIVATE_HEADER_
+
+#include <gxPL/defs.h>
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/* constants ================================================================ */
+#define GXPL_TOKEN_NONE     0  /* string never interned */
+#define GXPL_TOKEN_UNKNOWN  -1 /* token not yet computed */
+
+/*
+ * @brief Well-known tokens, interned before any other string
+ */
+typedef enum {
+  gxPLTokenHbeat = 1, /* "hbeat" */
+  gxPLTokenConfig,    /* "config" */
+  gxPLTokenApp,       /* "app" */
+  gxPLTokenBasic,     /* "basic" */
+  gxPLTokenEnd,       /* "end" */
+  gxPLTokenRequest,   /* "request" */
+  gxPLTokenList,      /* "list" */
+  gxPLTokenCurrent,   /* "current" */
+  gxPLTokenResponse,  /* "response" */
+  gxPLTokenWellKnown  /* first token of the other strings */
+} gxPLToken;
+
+/* internal private functions =============================================== */
+
+/*
+ * @brief Returns the token of a string, interns the string if it is new
+ *
+ * The tokens are small integers, starting at 1, shared by the whole process.
+ * An interned string is never released, the table holds DEFAULT_TOKEN_MAX
+ * strings at most: the callers compare the strings when they have no token.
+ * @return the token, GXPL_TOKEN_NONE if an error occurs or the table is full
+ */
+int gxPLTokenIntern (const char * str);
+
+/*
+ * @brief Returns the token of a string without interning it
+ * @return the token, GXPL_TOKEN_NONE if the string was never interned
+ */
+int gxPLTokenLookup (const char * str);
+
+/*
+ * @brief Returns the token of a xPL identifier, interns it if it is new
+ *
+ * The identifier is interned as a string vendor-device.instance
+ * @return the token, GXPL_TOKEN_NONE if an error occurs or the table is full
+ */
+int gxPLTokenInternId (const gxPLId * id);
+
+/*
+ * @brief Returns the token of a xPL identifier without interning it
+ * @return the token, GXPL_TOKEN_NONE if the identifier was never interned
+ */
+int gxPLTokenLookupId (const gxPLId * id);
+
+/*
+ * @brief Returns the tokens of several strings with a single lock
+ * @param token receives the tokens, GXPL_TOKEN_NONE for the strings never
+ * interned
+ */
+void gxPLTokenLookupArray (const char * const * str, int * token, int count);
+
+/*
+ * @brief Returns the tokens of a header without interning its strings
+ *
+ * The strings received are not interned, so that the table is not filled
+ * by the network: only the strings of the devices and filters of the
+ * process have a token.
+ * @param token receives the tokens of the schema class, schema type, source
+ * and target, GXPL_TOKEN_NONE for the strings never interned
+ */
+void gxPLTokenLookupHeader (const gxPLSchema * schema, const gxPLId * source,
+                            const gxPLId * target, int * token);
+
+/*
+ * @brief Compares a string to a well-known string, ignoring case
+ *
+ * The tokens are compared first, the strings are only compared when the
+ * tokens differ, as the tokens are case sensitive.
+ * @param token token of str
+ * @param known token of the well-known string, a gxPLToken
+ * @param str string compared
+ * @return true if str is the well-known string
+ */
+int gxPLTokenIs (int token, int known, const char * str);
+
+/* ========================================================================== */
+__END_C_DECLS
+#endif /* _GXPL_TOKEN_PRIVATE_HEADER_ defined */
@@ -138,7 +138,7 @@ const char *
 gxPLLongToStr (long value) {
   static char longBuffer[MAX_CHAR_LEN_DECIMAL_INTEGER (long) + 1];
 
-  sprintf (longBuffer, "%ld", value);
+  (void) gxPLLongToBuffer (value, longBuffer, sizeof (longBuffer));
   return longBuffer;
 }
 
@@ -147,14 +147,40 @@ const char *
 gxPLDoubleToStr (double value, int precision) {
   static char doubleBuffer[MAX_CHAR_LEN_DECIMAL_INTEGER (int) + 8 + 2];
 
+  (void) gxPLDoubleToBuffer (value, precision, doubleBuffer, sizeof (doubleBuffer));
+  return doubleBuffer;
+}
+
+// --------------------------------------------------------------------------
+int
+gxPLLongToBuffer (long value, char * buf, int len) {
+  int count = snprintf (buf, len, "%ld", value);
+
+  if (count >= len) {
+
+    errno = ENOBUFS;
+    return -1;
+  }
+  return count;
+}
+
+// --------------------------------------------------------------------------
+int
+gxPLDoubleToBuffer (double value, int precision, char * buf, int len) {
+  char str[MAX_CHAR_LEN_DECIMAL_INTEGER (int) + 8 + 2];
+  int count;
+
   precision = MIN (precision, 8);
-  sprintf (doubleBuffer, "%.8f", value);
-  if (precision < 8) {
-    int len = strlen (doubleBuffer);
-    
-    doubleBuffer[len -8 + precision] = '\0';
+  snprintf (str, sizeof (str), "%.8f", value);
+  count = strlen (str) - 8 + precision;
+  if (count >= len) {
+
+    errno = ENOBUFS;
+    return -1;
   }
-  return doubleBuffer;
+  memcpy (buf, str, count);
+  buf[count] = '\0';
+  return count;
 }
 
 // -----------------------------------------------------------------------------
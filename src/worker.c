@@ -0,0 +1,428 @@
+/**
+ * @file
+ * Dispatch of the messages by a pool of worker threads (source code)
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#if CONFIG_THREAD_SAFE
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <gxPL.h>
+#include "gxpl_p.h"
+
+/* constants ================================================================ */
+#ifndef DEFAULT_WORKER_MAX
+#define DEFAULT_WORKER_MAX 64
+#endif
+
+/* structures =============================================================== */
+
+/*
+ * Message handed over to a worker, for the listeners of a device or for a
+ * listener of the application
+ */
+typedef struct _worker_job {
+  struct _worker_job * next;
+  gxPLDevice * device;          /* NULL for a listener of the application */
+  gxPLMessageListener func;
+  void * udata;
+  gxPLMessage * message;        /* a reference is held by the job */
+  unsigned long long posted;    /* monotonic time in us */
+  int key;
+} worker_job;
+
+typedef struct _worker_elmt {
+  pthread_t thread;
+  struct _gxPLWorkerPool * pool;
+  pthread_mutex_t lock;
+  pthread_cond_t ready;         /* a job was posted or the pool stops */
+  pthread_cond_t idle;          /* the queue is empty and no job is running */
+  worker_job * head;
+  worker_job * tail;
+  int isbusy;
+  int isstopping;
+  gxPLWorkerStats stats;
+  unsigned long long latency_sum;
+} worker_elmt;
+
+struct _gxPLWorkerPool {
+  gxPLApplication * app;
+  int isholding;                /* the jobs are kept until released */
+  worker_job * held_head;       /* jobs posted while holding */
+  worker_job * held_tail;
+  int count;
+  worker_elmt worker[];
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static unsigned long long
+prvTimeUs (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000UL);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvJobRun (gxPLApplication * app, worker_job * job) {
+
+  if (job->device) {
+
+    gxPLDeviceDispatchDeferred (job->device, job->message);
+  }
+  else {
+
+    job->func (app, job->message, job->udata);
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void *
+prvWorkerThread (void * arg) {
+  worker_elmt * w = (worker_elmt *) arg;
+  gxPLApplication * app = w->pool->app;
+  gxPLAllocator * alloc = gxPLAppAllocator (app);
+
+  pthread_mutex_lock (&w->lock);
+  for (;;) {
+    worker_job * job;
+    unsigned long long latency;
+
+    while ( (w->head == NULL) && (w->isstopping == 0)) {
+
+      pthread_cond_wait (&w->ready, &w->lock);
+    }
+    if (w->head == NULL) {
+
+      // stopped, all the jobs have been processed
+      break;
+    }
+
+    job = w->head;
+    w->head = job->next;
+    if (w->head == NULL) {
+
+      w->tail = NULL;
+    }
+    w->stats.depth--;
+    w->isbusy = 1;
+    pthread_mutex_unlock (&w->lock);
+
+    prvJobRun (app, job);
+    latency = prvTimeUs() - job->posted;
+    gxPLMessageDelete (job->message);
+    gxPLAllocatorFree (alloc, job);
+
+    pthread_mutex_lock (&w->lock);
+    w->isbusy = 0;
+    w->stats.count++;
+    w->latency_sum += latency;
+    if (latency > w->stats.latency_max) {
+
+      w->stats.latency_max = latency;
+    }
+    if (w->head == NULL) {
+
+      pthread_cond_broadcast (&w->idle);
+    }
+  }
+  pthread_mutex_unlock (&w->lock);
+  return NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * Hands a job over to its worker, the message must be shared */
+static void
+prvJobPush (gxPLWorkerPool * pool, worker_job * job) {
+  // the tokens are close integers, they are mixed to spread the devices
+  worker_elmt * w =
+    &pool->worker[ ( (unsigned int) job->key * 2654435761U >> 16) % pool->count];
+
+  job->posted = prvTimeUs();
+  pthread_mutex_lock (&w->lock);
+  if (w->tail) {
+
+    w->tail->next = job;
+  }
+  else {
+
+    w->head = job;
+  }
+  w->tail = job;
+  if (++w->stats.depth > w->stats.depth_max) {
+
+    w->stats.depth_max = w->stats.depth;
+  }
+  pthread_cond_signal (&w->ready);
+  pthread_mutex_unlock (&w->lock);
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns true if the calling thread is a worker of the pool */
+static int
+prvIsWorker (const gxPLWorkerPool * pool) {
+
+  for (int i = 0; i < pool->count; i++) {
+
+    if (pthread_equal (pool->worker[i].thread, pthread_self())) {
+
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Stops the workers started, after they processed their jobs */
+static void
+prvPoolStop (gxPLWorkerPool * pool, int started) {
+
+  for (int i = 0; i < started; i++) {
+    worker_elmt * w = &pool->worker[i];
+
+    pthread_mutex_lock (&w->lock);
+    w->isstopping = 1;
+    pthread_cond_signal (&w->ready);
+    pthread_mutex_unlock (&w->lock);
+  }
+
+  for (int i = 0; i < pool->count; i++) {
+    worker_elmt * w = &pool->worker[i];
+
+    if (i < started) {
+
+      pthread_join (w->thread, NULL);
+    }
+    pthread_cond_destroy (&w->idle);
+    pthread_cond_destroy (&w->ready);
+    pthread_mutex_destroy (&w->lock);
+  }
+  free (pool);
+}
+
+/* internal public functions ================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLWorkersPost (gxPLApplication * app, int key, gxPLDevice * device,
+                 gxPLMessageListener func, void * udata, gxPLMessage * message) {
+  gxPLWorkerPool * pool = app->workers;
+  worker_job * job;
+
+  if (pool == NULL) {
+
+    errno = ENOSYS;
+    return -1;
+  }
+
+  job = gxPLAllocatorAlloc (app->alloc, sizeof (worker_job));
+  if (job == NULL) {
+
+    return -1;
+  }
+  job->next = NULL;
+  job->device = device;
+  job->func = func;
+  job->udata = udata;
+  job->key = key;
+
+  if (pool->isholding) {
+
+    // the message may still be modified by the listeners of the library
+    job->message = gxPLMessageRef (message);
+    if (pool->held_tail) {
+
+      pool->held_tail->next = job;
+    }
+    else {
+
+      pool->held_head = job;
+    }
+    pool->held_tail = job;
+    return 0;
+  }
+
+  // the workers read the message without modifying it
+  if (gxPLMessageShare (message) != 0) {
+
+    gxPLAllocatorFree (app->alloc, job);
+    return -1;
+  }
+  job->message = gxPLMessageRef (message);
+  prvJobPush (pool, job);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLWorkersHold (gxPLApplication * app) {
+
+  if (app->workers) {
+
+    app->workers->isholding = 1;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLWorkersRelease (gxPLApplication * app) {
+  gxPLWorkerPool * pool = app->workers;
+
+  if (pool) {
+
+    pool->isholding = 0;
+    while (pool->held_head) {
+      worker_job * job = pool->held_head;
+
+      pool->held_head = job->next;
+      job->next = NULL;
+      if (gxPLMessageShare (job->message) == 0) {
+
+        prvJobPush (pool, job);
+      }
+      else {
+
+        // processed by the calling thread, like a message not posted
+        prvJobRun (app, job);
+        gxPLMessageDelete (job->message);
+        gxPLAllocatorFree (app->alloc, job);
+      }
+    }
+    pool->held_tail = NULL;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void
+gxPLWorkersDrain (gxPLApplication * app) {
+  gxPLWorkerPool * pool = app->workers;
+
+  // a worker can not wait for itself
+  if ( (pool == NULL) || prvIsWorker (pool)) {
+
+    return;
+  }
+
+  for (int i = 0; i < pool->count; i++) {
+    worker_elmt * w = &pool->worker[i];
+
+    pthread_mutex_lock (&w->lock);
+    while ( (w->head != NULL) || w->isbusy) {
+
+      pthread_cond_wait (&w->idle, &w->lock);
+    }
+    pthread_mutex_unlock (&w->lock);
+  }
+}
+
+/* api functions ============================================================ */
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppWorkersStart (gxPLApplication * app, int count) {
+  gxPLWorkerPool * pool;
+  int i;
+
+  if (app->workers) {
+
+    errno = EBUSY;
+    return -1;
+  }
+
+  if ( (count < 1) || (count > DEFAULT_WORKER_MAX)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  pool = calloc (1, sizeof (gxPLWorkerPool) + count * sizeof (worker_elmt));
+  if (pool == NULL) {
+
+    return -1;
+  }
+  pool->app = app;
+  pool->count = count;
+
+  for (i = 0; i < count; i++) {
+    worker_elmt * w = &pool->worker[i];
+
+    w->pool = pool;
+    pthread_mutex_init (&w->lock, NULL);
+    pthread_cond_init (&w->ready, NULL);
+    pthread_cond_init (&w->idle, NULL);
+  }
+
+  for (i = 0; i < count; i++) {
+    int ret = pthread_create (&pool->worker[i].thread, NULL,
+                              prvWorkerThread, &pool->worker[i]);
+
+    if (ret != 0) {
+
+      PERROR ("Unable to start worker %d: %s", i, strerror (ret));
+      prvPoolStop (pool, i);
+      errno = ret;
+      return -1;
+    }
+  }
+
+  app->workers = pool;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppWorkersStop (gxPLApplication * app) {
+  gxPLWorkerPool * pool = app->workers;
+
+  if (pool) {
+
+    if (prvIsWorker (pool)) {
+
+      errno = EDEADLK;
+      return -1;
+    }
+    prvPoolStop (pool, pool->count);
+    app->workers = NULL;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppWorkersCount (const gxPLApplication * app) {
+
+  return (app->workers) ? app->workers->count : 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+gxPLAppWorkerStats (const gxPLApplication * app, int worker,
+                    gxPLWorkerStats * stats) {
+  gxPLWorkerPool * pool = app->workers;
+  worker_elmt * w;
+
+  if ( (pool == NULL) || (worker < 0) || (worker >= pool->count)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  w = &pool->worker[worker];
+  pthread_mutex_lock (&w->lock);
+  *stats = w->stats;
+  stats->latency_avg = (w->stats.count) ? w->latency_sum / w->stats.count : 0;
+  pthread_mutex_unlock (&w->lock);
+  return 0;
+}
+
+#endif /* CONFIG_THREAD_SAFE true */
+/* ========================================================================== */
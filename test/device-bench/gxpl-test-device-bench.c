@@ -0,0 +1,144 @@
+/**
+ * @file
+ * Device registry benchmark, adds, finds and removes a large number of devices
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL.h>
+#include "version-git.h"
+
+/* constants ================================================================ */
+#define VENDOR_ID       "epsirt"
+#define DEVICE_ID       "bench"
+#define DEVICE_COUNT    10000
+#define LOOKUP_ROUNDS   10
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+prvIdSet (gxPLId * id, int i) {
+
+  memset (id, 0, sizeof (gxPLId));
+  strcpy (id->vendor, VENDOR_ID);
+  strcpy (id->device, DEVICE_ID);
+  sprintf (id->instance, "i%d", i);
+}
+
+// -----------------------------------------------------------------------------
+static unsigned long
+prvElapsed (unsigned long start) {
+  unsigned long now;
+
+  (void) gxPLTimeMonotonicMs (&now);
+  return now - start;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  int ret;
+  unsigned long t;
+  gxPLId id;
+  gxPLDevice * device;
+  gxPLSetting * setting;
+  gxPLApplication * app;
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectViaHub);
+  test (setting);
+
+  // opens the xPL network
+  test_count++;
+  app = gxPLAppOpen (setting);
+  test (app);
+
+  printf ("Device registry benchmark with %d devices\n", DEVICE_COUNT);
+
+  // adds the devices
+  test_count++;
+  (void) gxPLTimeMonotonicMs (&t);
+  for (int i = 0; i < DEVICE_COUNT; i++) {
+
+    prvIdSet (&id, i);
+    device = gxPLAppAddDevice (app, id.vendor, id.device, id.instance);
+    test (device);
+  }
+  test (gxPLAppDeviceCount (app) == DEVICE_COUNT);
+  printf ("  add:    %lu ms\n", prvElapsed (t));
+
+  // a device already registered is rejected
+  test_count++;
+  prvIdSet (&id, 0);
+  test (gxPLAppAddDevice (app, id.vendor, id.device, id.instance) == NULL);
+
+  // finds each device by its identifier and its index
+  test_count++;
+  (void) gxPLTimeMonotonicMs (&t);
+  for (int r = 0; r < LOOKUP_ROUNDS; r++) {
+
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+
+      prvIdSet (&id, i);
+      device = gxPLAppDeviceFind (app, &id);
+      test (device);
+      test (gxPLIdCmp (gxPLDeviceId (device), &id) == 0);
+      test (gxPLAppDeviceAt (app, gxPLAppDeviceIndex (app, device)) == device);
+    }
+  }
+  printf ("  lookup: %lu ms (%d rounds)\n", prvElapsed (t), LOOKUP_ROUNDS);
+
+  // an unknown device is not found
+  test_count++;
+  prvIdSet (&id, DEVICE_COUNT);
+  test (gxPLAppDeviceFind (app, &id) == NULL);
+
+  // a device renamed is found with its new identifier only
+  test_count++;
+  prvIdSet (&id, 1);
+  device = gxPLAppDeviceFind (app, &id);
+  test (device);
+  prvIdSet (&id, DEVICE_COUNT);
+  ret = gxPLDeviceIdSet (device, &id);
+  test (ret == 0);
+  test (gxPLAppDeviceFind (app, &id) == device);
+  prvIdSet (&id, 1);
+  test (gxPLAppDeviceFind (app, &id) == NULL);
+
+  // removes the devices
+  test_count++;
+  (void) gxPLTimeMonotonicMs (&t);
+  while (gxPLAppDeviceCount (app) > 0) {
+
+    ret = gxPLAppRemoveDevice (app, gxPLAppDeviceAt (app, 0));
+    test (ret == 0);
+  }
+  printf ("  remove: %lu ms\n", prvElapsed (t));
+
+  test_count++;
+  ret = gxPLAppClose (app);
+  test (ret == 0);
+
+  printf ("\neverything was closed.\nHave a nice day !\n");
+  return 0;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,142 @@
+/**
+ * @file
+ * Test of the heartbeat replies of a device, a device disabled or deleted
+ * must not keep a reply pending
+ *
+ * The requests are sent to the application by an UDP socket on the loopback
+ * interface, the application must be opened on it (-i lo).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define VENDOR_ID       "epsirt"
+#define DEVICE_ID       "test"
+#define REPLY_DELAY_MAX 2500 /* ms, delay of a heartbeat reply */
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static int sock;
+static struct sockaddr_in addr;
+
+/* private functions ======================================================== */
+
+/* -----------------------------------------------------------------------------
+ * Sends a broadcast heartbeat request to the application, the case of the
+ * schema is not significant */
+static void
+prvRequest (const char * schema) {
+  char buf[256];
+  int len = sprintf (buf, "xpl-cmnd\n{\nhop=1\nsource=epsirt-test.sender\n"
+                     "target=*\n}\n%s\n{\ncommand=request\n}\n", schema);
+
+  test (sendto (sock, buf, len, 0, (const struct sockaddr *) &addr,
+                sizeof (addr)) == len);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvPoll (gxPLApplication * app, unsigned long ms) {
+  unsigned long start, t;
+
+  (void) gxPLTimeMonotonicMs (&start);
+  do {
+
+    test (gxPLAppPoll (app, 10) == 0);
+    (void) gxPLTimeMonotonicMs (&t);
+  }
+  while (t - start < ms);
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  gxPLIoAddr net;
+  gxPLSetting * setting;
+  gxPLApplication * app;
+  gxPLDevice * device;
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectViaHub);
+  test (setting);
+
+  // opens the xPL network, the requests are sent to the port of the
+  // application
+  test_count++;
+  app = gxPLAppOpen (setting);
+  test (app);
+  test (gxPLIoCtl (app, gxPLIoFuncGetNetInfo, &net) == 0);
+  sock = socket (AF_INET, SOCK_DGRAM, 0);
+  test (sock >= 0);
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (net.port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  // a disabled device does not answer a request, it can be deleted once the
+  // request received
+  test_count++;
+  device = gxPLAppAddDevice (app, VENDOR_ID, DEVICE_ID, "disabled");
+  test (device);
+  test (gxPLDeviceIsEnabled (device) == false);
+  test (gxPLAppNextDeadlineMs (app) == -1);
+  prvRequest ("hbeat.request");
+  prvPoll (app, 50);
+  test (gxPLAppNextDeadlineMs (app) == -1);
+  test (gxPLAppRemoveDevice (app, device) == 0);
+  prvPoll (app, REPLY_DELAY_MAX + 100);
+
+  // an enabled device answers after a delay shorter than the period of its
+  // heartbeats, the reply is cancelled when the device is disabled
+  test_count++;
+  device = gxPLAppAddDevice (app, VENDOR_ID, DEVICE_ID, "enabled");
+  test (device);
+  test (gxPLDeviceEnable (device, true) == 0);
+  test (gxPLAppNextDeadlineMs (app) > REPLY_DELAY_MAX + 100);
+  prvRequest ("HBeat.Request");
+  prvPoll (app, 50);
+  test (gxPLAppNextDeadlineMs (app) <= REPLY_DELAY_MAX);
+  test (gxPLDeviceEnable (device, false) == 0);
+  test (gxPLAppNextDeadlineMs (app) == -1);
+  prvRequest ("hbeat.request");
+  prvPoll (app, 50);
+  test (gxPLAppNextDeadlineMs (app) == -1);
+
+  // a device deleted with a reply pending
+  test_count++;
+  test (gxPLDeviceEnable (device, true) == 0);
+  prvRequest ("hbeat.request");
+  prvPoll (app, 50);
+  test (gxPLAppRemoveDevice (app, device) == 0);
+  test (gxPLAppNextDeadlineMs (app) == -1);
+  prvPoll (app, REPLY_DELAY_MAX + 100);
+
+  test_count++;
+  close (sock);
+  test (gxPLAppClose (app) == 0);
+
+  printf ("All tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
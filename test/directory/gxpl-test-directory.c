@@ -0,0 +1,192 @@
+/**
+ * @file
+ * Test of the directory of the devices alive on the network
+ *
+ * The heartbeats are sent to the application by an UDP socket on the
+ * loopback interface, the application must be opened on it (-i lo).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define DEVICE_COUNT    100
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static int sock;
+static struct sockaddr_in addr;
+static int events[4];
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+prvListener (gxPLApplication * app, const gxPLDirectoryEntry * entry,
+             gxPLDirectoryEvent event, void * udata) {
+
+  events[event]++;
+}
+
+/* -----------------------------------------------------------------------------
+ * Sends a heartbeat to the application as if it was sent by a device */
+static void
+prvHeartbeat (const char * type, const char * source, const char * schema,
+              const char * body) {
+  char buf[256];
+  int len = sprintf (buf, "%s\n{\nhop=1\nsource=%s\ntarget=*\n}\n%s\n"
+                     "{\n%s}\n", type, source, schema, body);
+
+  test (sendto (sock, buf, len, 0, (const struct sockaddr *) &addr,
+                sizeof (addr)) == len);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvPoll (gxPLApplication * app) {
+
+  for (int i = 0; i < 4; i++) {
+
+    test (gxPLAppPoll (app, 5) == 0);
+  }
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  char source[64];
+  gxPLId id;
+  gxPLIoAddr net;
+  gxPLSetting * setting;
+  gxPLApplication * app;
+  const gxPLDirectoryEntry * entry;
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectViaHub);
+  test (setting);
+
+  // opens the xPL network
+  test_count++;
+  app = gxPLAppOpen (setting);
+  test (app);
+  test (gxPLAppDirectoryCount (app) == 0);
+  test (gxPLAppDirectoryOpen (app, prvListener, NULL) == 0);
+  test (gxPLAppDirectoryOpen (app, prvListener, NULL) < 0);
+
+  // the heartbeats are sent to the port of the application
+  test_count++;
+  test (gxPLIoCtl (app, gxPLIoFuncGetNetInfo, &net) == 0);
+  sock = socket (AF_INET, SOCK_DGRAM, 0);
+  test (sock >= 0);
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (net.port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  // first heartbeat of a device
+  test_count++;
+  prvHeartbeat ("xpl-stat", "epsirt-dev.a", "hbeat.app",
+                "interval=5\nport=50000\nremote-ip=10.0.0.1\nversion=1.0\n");
+  prvPoll (app);
+  test (events[gxPLDirectoryAdded] == 1);
+  test (gxPLAppDirectoryCount (app) == 1);
+  test (gxPLIdSet (&id, "epsirt", "dev", "a") == 0);
+  entry = gxPLAppDirectoryFind (app, &id);
+  test (entry);
+  test (entry == gxPLAppDirectoryAt (app, 0));
+  test (gxPLAppDirectoryAt (app, 1) == NULL);
+  test ( (entry->interval == 5) && (entry->isconfig == 0));
+  test ( (entry->port == 50000) && (strcmp (entry->addr, "10.0.0.1") == 0));
+  test (strcmp (entry->version, "1.0") == 0);
+
+  // the same heartbeat does not change the directory
+  test_count++;
+  prvHeartbeat ("xpl-stat", "epsirt-dev.a", "hbeat.app",
+                "interval=5\nport=50000\nremote-ip=10.0.0.1\nversion=1.0\n");
+  prvPoll (app);
+  test (events[gxPLDirectoryChanged] == 0);
+
+  // a new version
+  test_count++;
+  prvHeartbeat ("xpl-stat", "epsirt-dev.a", "hbeat.app",
+                "interval=5\nport=50000\nremote-ip=10.0.0.1\nversion=1.1\n");
+  prvPoll (app);
+  test (events[gxPLDirectoryChanged] == 1);
+  test (strcmp (entry->version, "1.1") == 0);
+
+  // devices waiting for their configuration, requests and invalid heartbeats
+  test_count++;
+  prvHeartbeat ("xpl-stat", "epsirt-dev.b", "config.app",
+                "interval=1\nport=50001\nremote-ip=10.0.0.2\n");
+  prvHeartbeat ("xpl-stat", "epsirt-dev.c", "hbeat.basic", "interval=5\n");
+  prvHeartbeat ("xpl-cmnd", "epsirt-dev.d", "hbeat.app", "interval=5\n");
+  prvHeartbeat ("xpl-stat", "epsirt-dev.e", "hbeat.app", "port=50002\n");
+  prvPoll (app);
+  test (gxPLAppDirectoryCount (app) == 3);
+  test (gxPLIdSet (&id, "epsirt", "dev", "b") == 0);
+  entry = gxPLAppDirectoryFind (app, &id);
+  test (entry && (entry->isconfig == 1) && (entry->interval == 1));
+  test (gxPLIdSet (&id, "epsirt", "dev", "c") == 0);
+  entry = gxPLAppDirectoryFind (app, &id);
+  test (entry && (entry->port == 0) && (entry->addr[0] == '\0'));
+
+  // the end heartbeats remove the devices
+  test_count++;
+  prvHeartbeat ("xpl-stat", "epsirt-dev.a", "hbeat.end", "interval=5\n");
+  prvHeartbeat ("xpl-stat", "epsirt-dev.b", "config.end", "interval=1\n");
+  prvPoll (app);
+  test (events[gxPLDirectoryRemoved] == 2);
+  test (gxPLAppDirectoryCount (app) == 1);
+  test (gxPLAppDirectoryFind (app, &id) == gxPLAppDirectoryAt (app, 0));
+
+  // many devices
+  test_count++;
+  for (int i = 0; i < DEVICE_COUNT; i++) {
+
+    sprintf (source, "epsirt-dev.n%d", i);
+    prvHeartbeat ("xpl-stat", source, "hbeat.app", "interval=5\n");
+    if ( (i % 16) == 0) {
+
+      (void) gxPLAppPoll (app, 0);
+    }
+  }
+  prvPoll (app);
+  test (gxPLAppDirectoryCount (app) == DEVICE_COUNT + 1);
+  for (int i = 0; i < gxPLAppDirectoryCount (app); i++) {
+
+    entry = gxPLAppDirectoryAt (app, i);
+    test (entry == gxPLAppDirectoryFind (app, &entry->id));
+  }
+
+  // the directory is closed by gxPLAppClose()
+  test_count++;
+  test (gxPLAppDirectoryClose (app) == 0);
+  test (gxPLAppDirectoryCount (app) == 0);
+  test (gxPLAppDirectoryOpen (app, NULL, NULL) == 0);
+  close (sock);
+  test (gxPLAppClose (app) == 0);
+
+  printf ("All tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
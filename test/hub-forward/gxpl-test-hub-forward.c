@@ -0,0 +1,206 @@
+/**
+ * @file
+ * Test of the forward only mode of the hub, the datagrams are relayed to the
+ * local applications without being decoded
+ *
+ * The local applications are UDP sockets on the loopback interface, the hub
+ * must be opened on it (-i lo).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define CLIENT_COUNT    2
+#define POLL_TIME       50 /* ms */
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static gxPLHub * hub;
+static struct sockaddr_in hub_addr;
+static int client[CLIENT_COUNT];
+static int client_port[CLIENT_COUNT];
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+prvPoll (void) {
+  unsigned long start, t;
+
+  (void) gxPLTimeMonotonicMs (&start);
+  do {
+
+    test (gxPLHubPoll (hub, 5) == 0);
+    (void) gxPLTimeMonotonicMs (&t);
+  }
+  while (t - start < POLL_TIME);
+}
+
+/* -----------------------------------------------------------------------------
+ * Sends a datagram to the hub from a client and lets the hub relay it */
+static void
+prvSend (int c, const char * buf) {
+  int len = strlen (buf);
+
+  test (sendto (client[c], buf, len, 0, (const struct sockaddr *) &hub_addr,
+                sizeof (hub_addr)) == len);
+  prvPoll();
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the number of copies of buf received by a client, checks that
+ * nothing else was received */
+static int
+prvReceived (int c, const char * buf) {
+  char rx[1024];
+  int len, count = 0;
+
+  while ( (len = recv (client[c], rx, sizeof (rx) - 1, MSG_DONTWAIT)) > 0) {
+
+    rx[len] = '\0';
+    test (strcmp (rx, buf) == 0);
+    count++;
+  }
+  return count;
+}
+
+/* -----------------------------------------------------------------------------
+ * Heartbeat of a client, schema is hbeat.app, hbeat.end or config.app */
+static char *
+prvHeartbeat (int c, const char * schema, const char * ip) {
+  static char buf[256];
+
+  sprintf (buf, "xpl-stat\n{\nhop=1\nsource=epsirt-test.client%d\ntarget=*\n}\n"
+           "%s\n{\ninterval=5\nport=%d\nremote-ip=%s\n}\n", c, schema,
+           client_port[c], ip);
+  return buf;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  gxPLSetting * setting;
+  gxPLIoAddr net;
+  const char * hbeat;
+  // not in the canonical form of the encoder: a decoding hub would change it
+  const char * cmnd = "xpl-cmnd\n{\nhop=1\nsource=epsirt-test.sender\n"
+                      "target=*\n}\ncontrol.basic\n{\ndevice=1\ncurrent=ON\n"
+                      "current=OFF\nunknown-pair=\n}\n";
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectStandAlone);
+  test (setting);
+  setting->forward = 1;
+
+  // opens the hub
+  test_count++;
+  hub = gxPLHubOpen (setting);
+  test (hub);
+  // the messages are not decoded, the state cache can not be used
+  test (gxPLHubStateCacheEnable (hub, 0, 1000, NULL) == -1);
+  test (errno == ENOSYS);
+
+  test (gxPLIoCtl (gxPLHubApplication (hub), gxPLIoFuncGetNetInfo, &net) == 0);
+  memset (&hub_addr, 0, sizeof (hub_addr));
+  hub_addr.sin_family = AF_INET;
+  hub_addr.sin_port = htons (net.port);
+  hub_addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  // the local applications
+  test_count++;
+  for (int c = 0; c < CLIENT_COUNT; c++) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof (addr);
+
+    client[c] = socket (AF_INET, SOCK_DGRAM, 0);
+    test (client[c] >= 0);
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    test (bind (client[c], (struct sockaddr *) &addr, sizeof (addr)) == 0);
+    test (getsockname (client[c], (struct sockaddr *) &addr, &len) == 0);
+    client_port[c] = ntohs (addr.sin_port);
+  }
+
+  // a datagram is not relayed while no application is known
+  test_count++;
+  prvSend (0, cmnd);
+  test (prvReceived (0, cmnd) == 0);
+
+  // an application is discovered from its heartbeat, that it receives back
+  test_count++;
+  hbeat = prvHeartbeat (0, "hbeat.app", "127.0.0.1");
+  prvSend (0, hbeat);
+  test (prvReceived (0, hbeat) == 1);
+  prvSend (1, cmnd);
+  test (prvReceived (0, cmnd) == 1);
+  test (prvReceived (1, cmnd) == 0);
+
+  // an application on another computer is not a client of the hub
+  test_count++;
+  hbeat = prvHeartbeat (1, "hbeat.app", "192.0.2.1");
+  prvSend (1, hbeat);
+  test (prvReceived (0, hbeat) == 1);
+  test (prvReceived (1, hbeat) == 0);
+
+  // an application is also discovered from its config.app message, the
+  // datagrams are relayed as is
+  test_count++;
+  hbeat = prvHeartbeat (1, "config.app", "127.0.0.1");
+  prvSend (1, hbeat);
+  test (prvReceived (0, hbeat) == 1);
+  test (prvReceived (1, hbeat) == 1);
+  prvSend (0, cmnd);
+  test (prvReceived (0, cmnd) == 1);
+  test (prvReceived (1, cmnd) == 1);
+
+  // a datagram that is not a xPL message is not relayed
+  test_count++;
+  prvSend (0, "xpl-cmnd\n{\nhop=1\n");
+  prvSend (0, "hello world\n");
+  test (prvReceived (0, "") == 0);
+  test (prvReceived (1, "") == 0);
+
+  // an application leaves with its hbeat.end
+  test_count++;
+  hbeat = prvHeartbeat (0, "hbeat.end", "127.0.0.1");
+  prvSend (0, hbeat);
+  test (prvReceived (1, hbeat) == 1);
+  test (prvReceived (0, hbeat) == 0);
+  prvSend (1, cmnd);
+  test (prvReceived (0, cmnd) == 0);
+  test (prvReceived (1, cmnd) == 1);
+
+  test_count++;
+  for (int c = 0; c < CLIENT_COUNT; c++) {
+
+    close (client[c]);
+  }
+  test (gxPLHubClose (hub) == 0);
+
+  printf ("All tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,276 @@
+/**
+ * @file
+ * Counts the memory allocations made by the life cycle of a message
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL/alloc.h>
+#include <gxPL/message.h>
+#include <gxPL/util.h>
+
+/* constants ================================================================ */
+#define LARGE_BODY_PAIRS  40
+#define POOL_BLOCKS       64
+
+static const char sensor[] =
+  "xpl-stat\n"
+  "{\n"
+  "hop=1\n"
+  "source=epsirt-test.alloc\n"
+  "target=*\n"
+  "}\n"
+  "sensor.basic\n"
+  "{\n"
+  "device=temp1\n"
+  "type=temp\n"
+  "current=21.5\n"
+  "units=C\n"
+  "}\n";
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static int alloc_count;
+static int free_count;
+
+/* glibc allocator, the functions below replace the ones of the C library */
+extern void * __libc_malloc (size_t size);
+extern void * __libc_calloc (size_t n, size_t size);
+extern void * __libc_realloc (void * ptr, size_t size);
+extern void __libc_free (void * ptr);
+
+/* public functions ========================================================= */
+
+// -----------------------------------------------------------------------------
+void *
+malloc (size_t size) {
+
+  alloc_count++;
+  return __libc_malloc (size);
+}
+
+// -----------------------------------------------------------------------------
+void *
+calloc (size_t n, size_t size) {
+
+  alloc_count++;
+  return __libc_calloc (n, size);
+}
+
+// -----------------------------------------------------------------------------
+void *
+realloc (void * ptr, size_t size) {
+
+  if (ptr == NULL) {
+
+    alloc_count++;
+  }
+  return __libc_realloc (ptr, size);
+}
+
+// -----------------------------------------------------------------------------
+void
+free (void * ptr) {
+
+  if (ptr) {
+
+    free_count++;
+  }
+  __libc_free (ptr);
+}
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+prvCountReset (void) {
+
+  alloc_count = 0;
+  free_count = 0;
+}
+
+// -----------------------------------------------------------------------------
+static gxPLMessage *
+prvSensorNew (void) {
+  gxPLMessage * m = gxPLMessageNew (gxPLMessageStatus);
+
+  test (m);
+  test (gxPLMessageSourceSet (m, "epsirt", "test", "alloc") == 0);
+  gxPLMessageBroadcastSet (m, true);
+  test (gxPLMessageSchemaSet (m, "sensor", "basic") == 0);
+  test (gxPLMessagePairAdd (m, "device", "temp1") == 0);
+  test (gxPLMessagePairAdd (m, "type", "temp") == 0);
+  test (gxPLMessagePairAdd (m, "current", "21.5") == 0);
+  test (gxPLMessagePairAdd (m, "units", "C") == 0);
+  return m;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  gxPLMessage * m;
+  const char * str;
+  char * buffer;
+  int len;
+  long live;
+  gxPLAllocator * pool;
+  void * block[POOL_BLOCKS];
+
+  printf ("gxPLMessage allocation count\n");
+
+  // builds a small message: a single block
+  test_count++;
+  live = gxPLAllocatorLiveCount (NULL);
+  prvCountReset();
+  m = prvSensorNew();
+  printf ("  build:  %d\n", alloc_count);
+  test (alloc_count == 1);
+  test (gxPLAllocatorLiveCount (NULL) == live + 1);
+  test (gxPLAllocatorLiveBytes (NULL) > 0);
+
+  // modifies a value, longer then shorter, without allocation
+  test_count++;
+  prvCountReset();
+  test (gxPLMessagePairSet (m, "current", "21.75") == 0);
+  test (gxPLMessagePairSet (m, "current", "21.5") == 0);
+  test (strcmp (gxPLMessagePairGet (m, "current"), "21.5") == 0);
+  printf ("  set:    %d\n", alloc_count);
+  test (alloc_count == 0);
+
+  // formats the message: only the text
+  test_count++;
+  prvCountReset();
+  str = gxPLMessageStringGet (m, &len);
+  test (str);
+  test (strcmp (str, sensor) == 0);
+  printf ("  format: %d\n", alloc_count);
+  test (alloc_count == 1);
+
+  test_count++;
+  prvCountReset();
+  gxPLMessageDelete (m);
+  printf ("  delete: %d\n", free_count);
+  test (free_count == 2);
+  test (gxPLAllocatorLiveCount (NULL) == live);
+
+  // the first decoding interns the schema and the identifiers once for all
+  test_count++;
+  buffer = strdup (sensor);
+  test (buffer);
+  m = gxPLMessageFromBuffer (buffer);
+  test (m);
+  gxPLMessageDelete (m);
+
+  // decodes a received message in place: a single block, the buffer is kept
+  test_count++;
+  buffer = strdup (sensor);
+  test (buffer);
+  prvCountReset();
+  m = gxPLMessageFromBuffer (buffer);
+  test (m);
+  test (gxPLMessageIsValid (m));
+  test (gxPLMessageBodySize (m) == 4);
+  test (strcmp (gxPLMessagePairGet (m, "units"), "C") == 0);
+  printf ("  decode: %d\n", alloc_count);
+  test (alloc_count == 1);
+
+  // the const body is a view of the pairs of the message
+  test_count++;
+  prvCountReset();
+  test (iVectorSize (gxPLMessageBodyGetConst (m)) == 4);
+  test (gxPLMessagePairAdd (m, "extra", "1") == 0);
+  test (iVectorSize (gxPLMessageBodyGetConst (m)) == 5);
+
+  // the message and the buffer are released
+  test_count++;
+  gxPLMessageDelete (m);
+  test (free_count == alloc_count + 2);
+
+  // a large body spills on the heap, everything is released with the message
+  test_count++;
+  prvCountReset();
+  m = prvSensorNew();
+  for (int i = 0; i < LARGE_BODY_PAIRS; i++) {
+    char name[16];
+
+    sprintf (name, "channel%d", i);
+    test (gxPLMessagePairAdd (m, name, "a rather long value to fill the text area") == 0);
+  }
+  test (gxPLMessageBodySize (m) == LARGE_BODY_PAIRS + 4);
+  test (strcmp (gxPLMessagePairGet (m, "units"), "C") == 0);
+  test (strcmp (gxPLMessagePairGet (m, "channel39"),
+                "a rather long value to fill the text area") == 0);
+  printf ("  large:  %d (%d pairs)\n", alloc_count, LARGE_BODY_PAIRS + 4);
+  test (alloc_count < LARGE_BODY_PAIRS);
+  gxPLMessageDelete (m);
+  test (free_count == alloc_count);
+
+  // the body vector can still be modified by the caller
+  test_count++;
+  prvCountReset();
+  m = prvSensorNew();
+  xVector * body = gxPLMessageBodyGet (m);
+  test (body);
+  test (iVectorSize (body) == 4);
+  gxPLPair * p = pvVectorGet (body, 2);
+  test (strcmp (p->name, "current") == 0);
+  test (gxPLMessagePairAdd (m, "extra", "1") == 0);
+  test (gxPLMessageBodySize (m) == 5);
+  test (gxPLMessagePairSet (m, "current", "22.25") == 0);
+  test (strcmp (gxPLMessagePairGet (m, "current"), "22.25") == 0);
+  gxPLMessageDelete (m);
+  test (free_count == alloc_count);
+
+  // a pool allocator recycles its blocks, no more allocation once warmed
+  test_count++;
+  pool = gxPLAllocatorPoolNew();
+  test (pool);
+  for (int round = 0; round < 2; round++) {
+
+    prvCountReset();
+    for (int i = 0; i < POOL_BLOCKS; i++) {
+
+      // messages, body arrays and receive buffers of various sizes
+      block[i] = gxPLAllocatorAlloc (pool, 24 + (i * 23) % 1500);
+      test (block[i]);
+      memset (block[i], i, 24 + (i * 23) % 1500);
+    }
+    test (gxPLAllocatorLiveCount (pool) == POOL_BLOCKS);
+    printf ("  pool:   %d (round %d)\n", alloc_count, round);
+    if (round > 0) {
+
+      test (alloc_count == 0);
+    }
+
+    for (int i = 0; i < POOL_BLOCKS; i++) {
+
+      gxPLAllocatorFree (pool, block[i]);
+    }
+    test (gxPLAllocatorLiveCount (pool) == 0);
+    test (gxPLAllocatorLiveBytes (pool) == 0);
+  }
+
+  test_count++;
+  block[0] = gxPLAllocatorAlloc (pool, 16);
+  test (gxPLAllocatorPoolDelete (pool) < 0);
+  gxPLAllocatorFree (pool, block[0]);
+  test (gxPLAllocatorPoolDelete (pool) == 0);
+
+  printf ("\nAll tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,191 @@
+/**
+ * @file
+ * Message serializer benchmark, compares gxPLMessageToBuffer() with a
+ * formatting based on printf and a growing heap buffer
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define ROUNDS          200000
+#define STR_GROW        256
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static int
+prvStrPrintf (char ** buf, int * buf_size, int index, const char * format, ...) {
+  va_list ap;
+  int buf_free = *buf_size - index - 1;
+  int size;
+
+  va_start (ap, format);
+  size = vsnprintf (& (*buf) [index], buf_free, format, ap);
+  va_end (ap);
+
+  while (size >= buf_free) {
+
+    *buf_size += STR_GROW;
+    buf_free  += STR_GROW;
+    *buf = realloc (*buf, *buf_size);
+    test (*buf);
+
+    va_start (ap, format);
+    size = vsnprintf (& (*buf) [index], buf_free, format, ap);
+    va_end (ap);
+  }
+  return size;
+}
+
+/* -----------------------------------------------------------------------------
+ * Formatting of the previous versions, used as reference */
+static char *
+prvFormatPrintf (const gxPLMessage * m, int * len) {
+  int index = 0;
+  int buf_size = STR_GROW;
+  char * buf = malloc (buf_size);
+  const gxPLId * n = gxPLMessageSourceIdGet (m);
+  const gxPLSchema * s = gxPLMessageSchemaGet (m);
+  const xVector * body = gxPLMessageBodyGetConst (m);
+
+  test (buf);
+  index += prvStrPrintf (&buf, &buf_size, index, "%s\n{\nhop=%d\n",
+                         gxPLMessageTypeToString (gxPLMessageTypeGet (m)),
+                         gxPLMessageHopGet (m));
+  index += prvStrPrintf (&buf, &buf_size, index, "source=%s-%s.%s\n",
+                         n->vendor, n->device, n->instance);
+  if (gxPLMessageIsBroadcast (m)) {
+
+    index += prvStrPrintf (&buf, &buf_size, index, "target=*\n}\n");
+  }
+  else {
+
+    n = gxPLMessageTargetIdGet (m);
+    index += prvStrPrintf (&buf, &buf_size, index, "target=%s-%s.%s\n}\n",
+                           n->vendor, n->device, n->instance);
+  }
+  index += prvStrPrintf (&buf, &buf_size, index, "%s.%s\n{\n", s->class, s->type);
+  for (int i = 0; i < iVectorSize (body); i++) {
+    const gxPLPair * p = pvVectorGet (body, i);
+
+    index += prvStrPrintf (&buf, &buf_size, index, "%s=%s\n", p->name, p->value);
+  }
+  index += prvStrPrintf (&buf, &buf_size, index, "}\n");
+  buf = realloc (buf, index + 1);
+  *len = index;
+  return buf;
+}
+
+// -----------------------------------------------------------------------------
+static unsigned long
+prvElapsed (unsigned long start) {
+  unsigned long now;
+
+  (void) gxPLTimeMonotonicMs (&now);
+  return now - start;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvPrintCost (const char * name, unsigned long ms) {
+
+  printf ("  %-10s %6lu ms, %6.3f us/message\n", name, ms,
+          (ms * 1000.0) / ROUNDS);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvBench (const char * title, const gxPLMessage * m) {
+  unsigned long t;
+  char buf[1500];
+  char * str;
+  int len, ref_len;
+
+  printf ("%s\n", title);
+
+  // the two serializers give the same text
+  test_count++;
+  str = prvFormatPrintf (m, &ref_len);
+  len = gxPLMessageToBuffer (m, buf, sizeof (buf));
+  test (len == ref_len);
+  test (len == gxPLMessageSerializedSize (m));
+  test (strcmp (str, buf) == 0);
+  free (str);
+
+  (void) gxPLTimeMonotonicMs (&t);
+  for (int i = 0; i < ROUNDS; i++) {
+
+    str = prvFormatPrintf (m, &len);
+    free (str);
+  }
+  prvPrintCost ("printf", prvElapsed (t));
+
+  (void) gxPLTimeMonotonicMs (&t);
+  for (int i = 0; i < ROUNDS; i++) {
+
+    len = gxPLMessageToBuffer (m, buf, sizeof (buf));
+  }
+  prvPrintCost ("ToBuffer", prvElapsed (t));
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  gxPLMessage * m;
+
+  printf ("Message serializer benchmark, %d messages\n\n", ROUNDS);
+
+  // a sensor status, as sent by most devices
+  test_count++;
+  m = gxPLMessageNew (gxPLMessageStatus);
+  test (m);
+  test (gxPLMessageSourceSet (m, "epsirt", "sensor", "kitchen") == 0);
+  gxPLMessageBroadcastSet (m, true);
+  test (gxPLMessageSchemaSet (m, "sensor", "basic") == 0);
+  test (gxPLMessagePairAdd (m, "device", "temp1") == 0);
+  test (gxPLMessagePairAdd (m, "type", "temp") == 0);
+  test (gxPLMessagePairAdd (m, "current", "21.5") == 0);
+  test (gxPLMessagePairAdd (m, "units", "C") == 0);
+  prvBench ("sensor.basic (4 pairs)", m);
+  gxPLMessageDelete (m);
+
+  // a targeted command with a body larger than the growth of the buffer
+  test_count++;
+  m = gxPLMessageNew (gxPLMessageCommand);
+  test (m);
+  test (gxPLMessageSourceSet (m, "epsirt", "control", "panel") == 0);
+  test (gxPLMessageTargetSet (m, "epsirt", "dimmer", "living") == 0);
+  test (gxPLMessageSchemaSet (m, "config", "response") == 0);
+  for (int i = 0; i < 24; i++) {
+    char name[16];
+
+    sprintf (name, "option%d", i);
+    test (gxPLMessagePairAdd (m, name, "some value") == 0);
+  }
+  prvBench ("\nconfig.response (24 pairs)", m);
+  gxPLMessageDelete (m);
+
+  printf ("\nAll tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
@@ -29,6 +29,24 @@ static const gxPLId source = {
   .instance = "message"
 };
 
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+// counts the pairs, checks that they are passed in the order of the body
+static int
+prvPairCount (const gxPLPair * pair, void * udata) {
+  int * count = (int *) udata;
+
+  if (strcmp (pair->name, "filter") == 0) {
+    char value[8];
+
+    sprintf (value, "v%d", *count * 2 + 1);
+    assert (strcmp (pair->value, value) == 0);
+  }
+  (*count)++;
+  return 0;
+}
+
 /* main ===================================================================== */
 int
 main (int argc, char **argv) {
@@ -40,9 +58,10 @@ main (int argc, char **argv) {
   vLogSetMask (LOG_UPTO (LOG_DEBUG));
   gxPLStdIoOpen();
   gxPLPrintf ("\ngxPLMessage test (%s)\n", GXPL_TARGET_STR);
-  UTEST_PMEM_BEFORE();
   gxPLPrintf ("Press any key to proceed...\n");
   gxPLWait();
+  // after the buffer of stdin allocated by gxPLWait()
+  UTEST_PMEM_BEFORE();
 
   UTEST_NEW ("gxPLMessageNew() > ");
   m = gxPLMessageNew (gxPLMessageTrigger);
@@ -304,6 +323,9 @@ main (int argc, char **argv) {
   char * str1 = malloc (strlen (str) + 1);
   assert (str1);
   strcpy (str1, str);
+  char * str3 = malloc (strlen (str) + 1);
+  assert (str3);
+  strcpy (str3, str);
 
   UTEST_NEW ("gxPLMessageFromString() > ");
   gxPLMessage * rm = gxPLMessageFromString (NULL, str);
@@ -315,10 +337,51 @@ main (int argc, char **argv) {
   UTEST_SUCCESS();
 
   gxPLMessageDelete (rm);
-  free (str);
   free (str1);
   free (str2);
 
+  // Decode the message in place, str3 is released with the message
+  UTEST_NEW ("gxPLMessageFromBuffer() > ");
+  rm = gxPLMessageFromBuffer (str3);
+  assert (rm);
+  ret = gxPLMessageIsValid (rm);
+  assert (ret == true);
+  ret = gxPLMessageBodySize (rm);
+  assert (ret == 3);
+  cstr = gxPLMessagePairGet (rm, "level");
+  assert (cstr);
+  ret = strcmp (cstr, "75");
+  assert (ret == 0);
+  str1 = gxPLMessageToString (m);
+  assert (str1);
+  str2 = gxPLMessageToString (rm);
+  assert (str2);
+  ret = strcmp (str1, str2);
+  assert (ret == 0);
+  UTEST_SUCCESS();
+  free (str1);
+  free (str2);
+
+  UTEST_NEW ("gxPLMessagePairSet() on in place message > ");
+  ret = gxPLMessagePairSet (rm, "level", "50");
+  assert (ret == 0);
+  cstr = gxPLMessagePairGet (rm, "level");
+  assert (cstr);
+  ret = strcmp (cstr, "50");
+  assert (ret == 0);
+  cstr = gxPLMessagePairGet (rm, "device");
+  assert (cstr);
+  ret = strcmp (cstr, "a1");
+  assert (ret == 0);
+  ret = gxPLMessagePairAdd (rm, "state", "on");
+  assert (ret == 0);
+  ret = gxPLMessageBodySize (rm);
+  assert (ret == 4);
+  UTEST_SUCCESS();
+
+  gxPLMessageDelete (rm);
+  free (str);
+
   UTEST_NEW ("gxPLMessageIsBroadcast() > ");
   ret = gxPLMessageIsBroadcast (m);
   assert (ret == false);
@@ -353,6 +416,102 @@ main (int argc, char **argv) {
   free (str1);
   free (str2);
 
+  UTEST_NEW ("gxPLMessageStringGet() > ");
+  const char * cstr1 = gxPLMessageStringGet (m, &ret);
+  assert (cstr1);
+  assert (ret == strlen (cstr1));
+  str = gxPLMessageToString (m);
+  assert (str);
+  assert (strcmp (cstr1, str) == 0);
+  free (str);
+  // formatted once
+  const char * cstr2 = gxPLMessageStringGet (m, NULL);
+  assert (cstr2 == cstr1);
+  // the text follows the modifications of the message
+  ret = gxPLMessageHopInc (m);
+  assert (ret == 0);
+  cstr2 = gxPLMessageStringGet (m, NULL);
+  assert (cstr2);
+  assert (strstr (cstr2, "hop=2\n") != NULL);
+  ret = gxPLMessagePairSet (m, "command", "goodbye");
+  cstr2 = gxPLMessageStringGet (m, NULL);
+  assert (cstr2);
+  assert (strstr (cstr2, "command=goodbye\n") != NULL);
+  UTEST_SUCCESS();
+
+  UTEST_NEW ("gxPLMessagePairForEach() > ");
+  gxPLMessage * m3 = gxPLMessageNew (gxPLMessageStatus);
+  assert (m3);
+  for (int i = 0; i < 32; i++) {
+
+    ret = gxPLMessagePairAddFormat (m3, (i & 1) ? "filter" : "option", "v%d", i);
+    assert (ret == 0);
+  }
+  ret = gxPLMessagePairAdd (m3, "last", "end");
+  assert (ret == 0);
+  // large body, indexed
+  assert (strcmp (gxPLMessagePairGet (m3, "option"), "v0") == 0);
+  assert (strcmp (gxPLMessagePairGet (m3, "last"), "end") == 0);
+  assert (gxPLMessagePairGet (m3, "none") == NULL);
+  int count = 0;
+  ret = gxPLMessagePairForEach (m3, "filter", prvPairCount, &count);
+  assert (ret == 16);
+  assert (count == 16);
+  ret = gxPLMessagePairSet (m3, "last", "again");
+  assert (ret == 0);
+  assert (strcmp (gxPLMessagePairGet (m3, "last"), "again") == 0);
+  ret = gxPLMessagePairForEach (m3, "last", prvPairCount, &count);
+  assert (ret == 1);
+  gxPLMessageDelete (m3);
+  UTEST_SUCCESS();
+
+  UTEST_NEW ("gxPLTokenStats() > ");
+  unsigned long hit1, hit2, miss1, miss2;
+  gxPLMessage * m2 = gxPLMessageFromBuffer (strdup (gxPLMessageStringGet (m, NULL)));
+  assert (m2);
+  assert (gxPLMessageIsValid (m2));
+  ret = gxPLTokenStats (&hit1, &miss1);
+  assert (ret > 0);
+  gxPLMessageDelete (m2);
+  // the header of a message received is looked up, never interned
+  m2 = gxPLMessageFromBuffer (strdup (gxPLMessageStringGet (m, NULL)));
+  assert (m2);
+  assert (gxPLTokenStats (&hit2, &miss2) == ret);
+  assert (hit2 + miss2 >= hit1 + miss1 + 4);
+  gxPLMessageDelete (m2);
+  UTEST_SUCCESS();
+
+  UTEST_NEW ("gxPLMessageToBuffer() > ");
+  int len;
+  char text[512];
+  cstr = gxPLMessageStringGet (m, &len);
+  assert (cstr);
+  ret = gxPLMessageSerializedSize (m);
+  assert (ret == len);
+  ret = gxPLMessageToBuffer (m, text, sizeof (text));
+  assert (ret == len);
+  assert (strcmp (text, cstr) == 0);
+  // the terminating null character does not fit
+  ret = gxPLMessageToBuffer (m, text, len);
+  assert (ret == -1);
+  UTEST_SUCCESS();
+
+  UTEST_NEW ("gxPLMessageToIoVec() > ");
+  gxPLIoVec iov[64];
+  char * dst = text;
+  ret = gxPLMessageToIoVec (m, iov, 64);
+  assert (ret > 0);
+  for (int i = 0; i < ret; i++) {
+    memcpy (dst, iov[i].base, iov[i].len);
+    dst += iov[i].len;
+  }
+  *dst = '\0';
+  assert (dst - text == len);
+  assert (strcmp (text, cstr) == 0);
+  ret = gxPLMessageToIoVec (m, iov, 4);
+  assert (ret == -1);
+  UTEST_SUCCESS();
+
   UTEST_NEW ("gxPLMessageBodyClear() > ");
   ret = gxPLMessageBodyClear (m);
   assert (ret == 0);
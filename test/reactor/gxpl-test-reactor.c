@@ -0,0 +1,240 @@
+/**
+ * @file
+ * Test of the reactor, an event loop shared by several applications
+ *
+ * The messages are sent to the applications by an UDP socket on the loopback
+ * interface, the applications must be opened on it (-i lo).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define APP_COUNT       3
+#define BACKLOG         (DEFAULT_POLL_BUDGET * 3 + 5) /* more than a budget */
+#define REQUEST_TIMEOUT 200  /* ms */
+#define TIMEOUT         5000 /* ms */
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static int sock;
+static struct sockaddr_in addr[APP_COUNT];
+static int received[APP_COUNT];
+static int timeouts;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static unsigned long
+prvElapsed (unsigned long start) {
+  unsigned long now;
+
+  (void) gxPLTimeMonotonicMs (&now);
+  return now - start;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvListener (gxPLApplication * app, gxPLMessage * msg, void * udata) {
+  int i = (int) (long) udata;
+
+  if (strcmp (gxPLMessageSchemaClassGet (msg), "control") == 0) {
+
+    received[i]++;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvRequestCallback (gxPLApplication * app, gxPLMessage * reply, void * udata) {
+
+  if (reply == NULL) {
+
+    timeouts++;
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Sends count commands to the application i */
+static void
+prvSend (int i, int count) {
+  char buf[256];
+
+  for (int n = 1; n <= count; n++) {
+    int len = sprintf (buf, "xpl-cmnd\n{\nhop=1\nsource=epsirt-test.sender\n"
+                       "target=*\n}\ncontrol.basic\n{\nseq=%d\n}\n", n);
+
+    test (sendto (sock, buf, len, 0, (const struct sockaddr *) &addr[i],
+                  sizeof (addr[i])) == len);
+  }
+  // the datagrams are in the socket buffers before the poll
+  usleep (20000);
+}
+
+/* -----------------------------------------------------------------------------
+ * Polls the reactor until the applications received the expected messages */
+static void
+prvPollUntil (gxPLReactor * reactor, const int * expected) {
+  unsigned long t;
+  int done;
+
+  (void) gxPLTimeMonotonicMs (&t);
+  do {
+
+    test (prvElapsed (t) < TIMEOUT);
+    test (gxPLReactorPoll (reactor, 10) >= 0);
+    done = 1;
+    for (int i = 0; i < APP_COUNT; i++) {
+
+      test (received[i] <= expected[i]);
+      done = done && (received[i] == expected[i]);
+    }
+  }
+  while (!done);
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  int ret, total;
+  unsigned long t;
+  gxPLIoAddr net;
+  gxPLSetting * setting;
+  gxPLReactor * reactor;
+  gxPLApplication * app[APP_COUNT];
+  gxPLMessage * msg;
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectViaHub);
+  test (setting);
+
+  test_count++;
+  reactor = gxPLReactorNew();
+  test (reactor);
+  test (gxPLReactorSize (reactor) == 0);
+  // nothing to wait for but the timeout
+  test (gxPLReactorPoll (reactor, 10) == 0);
+
+  // opens the applications on the same interface and registers them
+  test_count++;
+  sock = socket (AF_INET, SOCK_DGRAM, 0);
+  test (sock >= 0);
+  for (int i = 0; i < APP_COUNT; i++) {
+    gxPLSetting * s = gxPLSettingNew (setting->iface, setting->iolayer,
+                                      gxPLConnectViaHub);
+
+    test (s);
+    app[i] = gxPLAppOpen (s);
+    test (app[i]);
+    test (gxPLMessageListenerAdd (app[i], prvListener, (void *) (long) i) == 0);
+    test (gxPLReactorAdd (reactor, app[i]) == 0);
+
+    test (gxPLIoCtl (app[i], gxPLIoFuncGetNetInfo, &net) == 0);
+    memset (&addr[i], 0, sizeof (addr[i]));
+    addr[i].sin_family = AF_INET;
+    addr[i].sin_port = htons (net.port);
+    addr[i].sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  }
+  test (gxPLReactorSize (reactor) == APP_COUNT);
+  // already registered
+  test (gxPLReactorAdd (reactor, app[0]) == 0);
+  test (gxPLReactorSize (reactor) == APP_COUNT);
+
+  // each message is dispatched by the application that received it
+  test_count++;
+  prvSend (1, 3);
+  prvSend (2, 7);
+  prvPollUntil (reactor, (int[]) { 0, 3, 7 });
+
+  // a backlog is processed by budget, without waiting between the calls,
+  // the other applications are served on each call
+  test_count++;
+  memset (received, 0, sizeof (received));
+  prvSend (0, BACKLOG);
+  prvSend (1, 2);
+  total = 0;
+  (void) gxPLTimeMonotonicMs (&t);
+  while (total < BACKLOG + 2) {
+
+    ret = gxPLReactorPoll (reactor, TIMEOUT);
+    test ( (ret > 0) && (ret <= DEFAULT_POLL_BUDGET + 2));
+    total += ret;
+    test (received[1] == 2);
+  }
+  test (prvElapsed (t) < TIMEOUT / 2);
+  test ( (received[0] == BACKLOG) && (received[2] == 0));
+
+  // the wait ends on the next timer of the applications, a request that
+  // nobody answers
+  test_count++;
+  msg = gxPLMessageNew (gxPLMessageCommand);
+  test (msg);
+  test (gxPLMessageSourceSet (msg, "epsirt", "test", "reactor") == 0);
+  test (gxPLMessageTargetSet (msg, "epsirt", "nobody", "here") == 0);
+  test (gxPLMessageSchemaSet (msg, "sensor", "request") == 0);
+  test (gxPLMessagePairAdd (msg, "request", "current") == 0);
+  test (gxPLAppRequest (app[2], msg, NULL, REQUEST_TIMEOUT,
+                        prvRequestCallback, NULL) > 0);
+  gxPLMessageDelete (msg);
+  (void) gxPLTimeMonotonicMs (&t);
+  while (timeouts == 0) {
+
+    test (gxPLReactorPoll (reactor, -1) >= 0);
+    test (prvElapsed (t) < TIMEOUT);
+  }
+  test (prvElapsed (t) >= REQUEST_TIMEOUT - 1);
+  test (prvElapsed (t) < REQUEST_TIMEOUT + 500);
+  test (timeouts == 1);
+
+  // an application removed is no longer polled by the reactor
+  test_count++;
+  memset (received, 0, sizeof (received));
+  test (gxPLReactorRemove (reactor, app[1]) == 0);
+  test (gxPLReactorRemove (reactor, app[1]) == -1);
+  test (gxPLReactorSize (reactor) == APP_COUNT - 1);
+  prvSend (1, 4);
+  prvSend (2, 1);
+  prvPollUntil (reactor, (int[]) { 0, 0, 1 });
+  test (gxPLReactorPoll (reactor, 50) >= 0);
+  test (received[1] == 0);
+  (void) gxPLTimeMonotonicMs (&t);
+  while (received[1] < 4) {
+
+    test (gxPLAppPoll (app[1], 10) == 0);
+    test (prvElapsed (t) < TIMEOUT);
+  }
+
+  // the applications are not closed with the reactor
+  test_count++;
+  test (gxPLReactorDelete (reactor) == 0);
+  close (sock);
+  for (int i = 0; i < APP_COUNT; i++) {
+
+    test (gxPLAppClose (app[i]) == 0);
+  }
+
+  printf ("All tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
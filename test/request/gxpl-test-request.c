@@ -0,0 +1,239 @@
+/**
+ * @file
+ * Test of the requests waiting for a reply
+ *
+ * The replies are sent to the application by an UDP socket on the loopback
+ * interface, the application must be opened on it (-i lo).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define VENDOR_ID       "epsirt"
+#define DEVICE_ID       "test"
+#define INSTANCE_ID     "request"
+#define REQUEST_COUNT   1000
+#define TIMEOUT         200 /* ms */
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static int sock;
+static struct sockaddr_in addr;
+static int replies[REQUEST_COUNT];
+static int timeouts[REQUEST_COUNT];
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+prvCallback (gxPLApplication * app, gxPLMessage * reply, void * udata) {
+  int i = (int) (long) udata;
+
+  if (reply) {
+
+    replies[i]++;
+  }
+  else {
+
+    timeouts[i]++;
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Sends a message to the application as if it was sent by a device */
+static void
+prvReply (const char * type, const char * source, const char * schema) {
+  char buf[256];
+  int len = sprintf (buf, "%s\n{\nhop=1\nsource=%s\ntarget=*\n}\n%s\n"
+                     "{\nstatus=ok\n}\n", type, source, schema);
+
+  test (sendto (sock, buf, len, 0, (const struct sockaddr *) &addr,
+                sizeof (addr)) == len);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvPoll (gxPLApplication * app, unsigned long ms) {
+  unsigned long start, t;
+
+  (void) gxPLTimeMonotonicMs (&start);
+  do {
+
+    test (gxPLAppPoll (app, 5) == 0);
+    (void) gxPLTimeMonotonicMs (&t);
+  }
+  while (t - start < ms);
+}
+
+// -----------------------------------------------------------------------------
+static gxPLMessage *
+prvRequestNew (const char * instance, const char * class, const char * type) {
+  gxPLMessage * msg = gxPLMessageNew (gxPLMessageCommand);
+
+  test (msg);
+  test (gxPLMessageSourceSet (msg, VENDOR_ID, DEVICE_ID, INSTANCE_ID) == 0);
+  if (instance) {
+
+    test (gxPLMessageTargetSet (msg, VENDOR_ID, "dev", instance) == 0);
+  }
+  else {
+
+    test (gxPLMessageBroadcastSet (msg, true) == 0);
+  }
+  test (gxPLMessageSchemaSet (msg, class, type) == 0);
+  test (gxPLMessagePairAdd (msg, "request", "current") == 0);
+  return msg;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  int id, id2, tokens;
+  char instance[GXPL_INSTANCEID_MAX + 1];
+  char source[64];
+  gxPLIoAddr net;
+  gxPLSetting * setting;
+  gxPLApplication * app;
+  gxPLMessage * msg;
+  gxPLRequestMatch match = {
+    .type = gxPLMessageStatus, .schema_type = "app", .multiple = 1
+  };
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectViaHub);
+  test (setting);
+
+  // opens the xPL network
+  test_count++;
+  app = gxPLAppOpen (setting);
+  test (app);
+
+  // the replies are sent to the port of the application
+  test_count++;
+  test (gxPLIoCtl (app, gxPLIoFuncGetNetInfo, &net) == 0);
+  sock = socket (AF_INET, SOCK_DGRAM, 0);
+  test (sock >= 0);
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (net.port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  // a single reply from the target of the request
+  test_count++;
+  msg = prvRequestNew ("d0", "sensor", "request");
+  test (gxPLAppRequest (app, msg, NULL, 0, prvCallback, NULL) < 0);
+  test (gxPLAppRequest (app, msg, NULL, TIMEOUT, NULL, NULL) < 0);
+  id = gxPLAppRequest (app, msg, NULL, TIMEOUT, prvCallback, (void *) 0);
+  test (id > 0);
+  test (gxPLAppRequestCount (app) == 1);
+  prvReply ("xpl-stat", VENDOR_ID "-dev.d1", "sensor.basic");
+  prvReply ("xpl-stat", VENDOR_ID "-dev.d0", "control.basic");
+  prvPoll (app, 20);
+  test (replies[0] == 0);
+  prvReply ("xpl-stat", VENDOR_ID "-dev.d0", "sensor.basic");
+  prvPoll (app, 20);
+  test ( (replies[0] == 1) && (timeouts[0] == 0));
+  test (gxPLAppRequestCount (app) == 0);
+  test (gxPLAppRequestCancel (app, id) < 0);
+
+  // the oldest request receives the reply
+  test_count++;
+  memset (replies, 0, sizeof (replies));
+  id = gxPLAppRequest (app, msg, NULL, TIMEOUT, prvCallback, (void *) 0);
+  id2 = gxPLAppRequest (app, msg, NULL, TIMEOUT, prvCallback, (void *) 1);
+  test ( (id > 0) && (id2 > 0) && (id != id2));
+  prvReply ("xpl-stat", VENDOR_ID "-dev.d0", "sensor.basic");
+  prvPoll (app, 20);
+  test ( (replies[0] == 1) && (replies[1] == 0));
+
+  // a cancelled request is not called
+  test_count++;
+  test (gxPLAppRequestCancel (app, id2) == 0);
+  test (gxPLAppRequestCount (app) == 0);
+  prvPoll (app, TIMEOUT + 50);
+  test (timeouts[1] == 0);
+  gxPLMessageDelete (msg);
+
+  // many requests, half of them receive a reply, the others time out, the
+  // identifiers of the targets are not interned
+  test_count++;
+  memset (replies, 0, sizeof (replies));
+  tokens = gxPLTokenStats (NULL, NULL);
+  for (int i = 0; i < REQUEST_COUNT; i++) {
+
+    sprintf (instance, "n%d", i);
+    msg = prvRequestNew (instance, "config", "list");
+    test (gxPLAppRequest (app, msg, NULL, TIMEOUT, prvCallback,
+                          (void *) (long) i) > 0);
+    gxPLMessageDelete (msg);
+  }
+  test (gxPLAppRequestCount (app) == REQUEST_COUNT);
+  test (gxPLTokenStats (NULL, NULL) == tokens);
+  for (int i = 0; i < REQUEST_COUNT; i += 2) {
+
+    sprintf (source, VENDOR_ID "-dev.n%d", i);
+    prvReply ("xpl-stat", source, "config.list");
+    if ( (i % 64) == 0) {
+
+      (void) gxPLAppPoll (app, 0);
+    }
+  }
+  prvPoll (app, TIMEOUT + 100);
+  test (gxPLAppRequestCount (app) == 0);
+  for (int i = 0; i < REQUEST_COUNT; i++) {
+
+    test (replies[i] == ( (i % 2) ? 0 : 1));
+    test (timeouts[i] == ( (i % 2) ? 1 : 0));
+  }
+
+  // a broadcast request receives the replies of all the devices
+  test_count++;
+  memset (replies, 0, sizeof (replies));
+  memset (timeouts, 0, sizeof (timeouts));
+  msg = prvRequestNew (NULL, "hbeat", "request");
+  test (gxPLAppRequest (app, msg, &match, TIMEOUT, prvCallback, (void *) 0) > 0);
+  gxPLMessageDelete (msg);
+  prvReply ("xpl-stat", VENDOR_ID "-dev.a", "hbeat.app");
+  prvReply ("xpl-stat", VENDOR_ID "-dev.b", "hbeat.app");
+  prvReply ("xpl-trig", VENDOR_ID "-dev.c", "hbeat.app");
+  prvReply ("xpl-stat", VENDOR_ID "-dev.d", "hbeat.end");
+  prvReply ("xpl-stat", VENDOR_ID "-" DEVICE_ID "." INSTANCE_ID, "hbeat.app");
+  prvPoll (app, 20);
+  test ( (replies[0] == 2) && (timeouts[0] == 0));
+  prvPoll (app, TIMEOUT + 50);
+  test ( (replies[0] == 2) && (timeouts[0] == 1));
+
+  // the requests waiting are released by gxPLAppClose()
+  test_count++;
+  msg = prvRequestNew ("d0", "sensor", "request");
+  test (gxPLAppRequest (app, msg, NULL, 10000, prvCallback, (void *) 1) > 0);
+  gxPLMessageDelete (msg);
+  close (sock);
+  test (gxPLAppClose (app) == 0);
+  test (timeouts[1] == 1);
+
+  printf ("All tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
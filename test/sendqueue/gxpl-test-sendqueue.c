@@ -0,0 +1,180 @@
+/**
+ * @file
+ * Test of the send queue, several threads send messages with each overflow
+ * policy while the main thread polls the application
+ *
+ * The messages are broadcast on the network, the application should be
+ * opened on the loopback interface (-i lo).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define VENDOR_ID       "epsirt"
+#define DEVICE_ID       "test"
+#define INSTANCE_ID     "sendqueue"
+#define PRODUCER_COUNT  4
+#define MESSAGE_COUNT   500   /* by producer */
+#define QUEUE_SIZE      8     /* small, the queue overflows */
+#define TIMEOUT         10000 /* ms */
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static gxPLApplication * app;
+static int running;                   /* producers not yet finished */
+static unsigned long rejected;        /* gxPLAppSendAsync() failed */
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static unsigned long
+prvElapsed (unsigned long start) {
+  unsigned long now;
+
+  (void) gxPLTimeMonotonicMs (&now);
+  return now - start;
+}
+
+/* -----------------------------------------------------------------------------
+ * Sends its messages as fast as possible, a message is no longer modified
+ * once queued, a new one is created for each send */
+static void *
+prvProducer (void * udata) {
+  int id = (int) (long) udata;
+  char value[16];
+
+  for (int i = 0; i < MESSAGE_COUNT; i++) {
+    gxPLMessage * msg = gxPLMessageNew (gxPLMessageTrigger);
+
+    test (msg);
+    test (gxPLMessageSourceSet (msg, VENDOR_ID, DEVICE_ID, INSTANCE_ID) == 0);
+    test (gxPLMessageBroadcastSet (msg, true) == 0);
+    test (gxPLMessageSchemaSet (msg, "sensor", "basic") == 0);
+    sprintf (value, "p%d", id);
+    test (gxPLMessagePairAdd (msg, "device", value) == 0);
+    sprintf (value, "%d", i);
+    test (gxPLMessagePairAdd (msg, "current", value) == 0);
+
+    if (gxPLAppSendAsync (app, msg) != 0) {
+
+      test (errno == ENOBUFS);
+      __atomic_add_fetch (&rejected, 1, __ATOMIC_RELAXED);
+    }
+    gxPLMessageDelete (msg);
+  }
+  __atomic_sub_fetch (&running, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * Runs the producers with a policy until the queue is empty, checks that
+ * each message has been either sent or dropped */
+static void
+prvRun (gxPLSendQueuePolicy policy) {
+  pthread_t producer[PRODUCER_COUNT];
+  gxPLSendQueueStats stats;
+  unsigned long t;
+
+  test_count++;
+  test (gxPLAppSendQueueOpen (app, QUEUE_SIZE, policy) == 0);
+  test (gxPLAppSendQueueStats (app, &stats) == 0);
+  test ( (stats.size == QUEUE_SIZE) && (stats.depth == 0));
+
+  running = PRODUCER_COUNT;
+  rejected = 0;
+  for (int i = 0; i < PRODUCER_COUNT; i++) {
+
+    test (pthread_create (&producer[i], NULL, prvProducer, (void *) (long) i) == 0);
+  }
+
+  // the queue is sent by the poll while the producers fill it
+  (void) gxPLTimeMonotonicMs (&t);
+  while (__atomic_load_n (&running, __ATOMIC_ACQUIRE) > 0) {
+
+    test (prvElapsed (t) < TIMEOUT);
+    test (gxPLAppPoll (app, 1) == 0);
+  }
+  for (int i = 0; i < PRODUCER_COUNT; i++) {
+
+    test (pthread_join (producer[i], NULL) == 0);
+  }
+
+  do {
+
+    test (prvElapsed (t) < TIMEOUT);
+    test (gxPLAppPoll (app, 0) == 0);
+    test (gxPLAppSendQueueStats (app, &stats) == 0);
+  }
+  while (stats.depth > 0);
+
+  printf ("policy %d: enqueued %lu, sent %lu, dropped %lu, rejected %lu\n",
+          policy, stats.enqueued, stats.sent, stats.dropped, rejected);
+  test (stats.depth == 0);
+  // the messages rejected are counted as dropped, not as enqueued
+  test (stats.enqueued + rejected == PRODUCER_COUNT * MESSAGE_COUNT);
+  test (stats.enqueued == stats.sent + stats.dropped - rejected);
+  switch (policy) {
+
+    case gxPLSendQueueDropNewest:
+      test (stats.dropped >= rejected);
+      break;
+
+    case gxPLSendQueueDropOldest:
+    case gxPLSendQueueBlock:
+      // the new message is always queued
+      test (rejected == 0);
+      break;
+  }
+
+  test (gxPLAppSendQueueClose (app) == 0);
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  gxPLSetting * setting;
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectViaHub);
+  test (setting);
+
+  // opens the xPL network
+  test_count++;
+  app = gxPLAppOpen (setting);
+  test (app);
+
+  // no queue opened
+  test_count++;
+  test (gxPLAppSendAsync (app, NULL) != 0);
+  test (errno == EINVAL);
+
+  prvRun (gxPLSendQueueDropNewest);
+  prvRun (gxPLSendQueueDropOldest);
+  prvRun (gxPLSendQueueBlock);
+
+  test_count++;
+  test (gxPLAppClose (app) == 0);
+
+  printf ("All tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
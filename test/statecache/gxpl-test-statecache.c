@@ -0,0 +1,208 @@
+/**
+ * @file
+ * Test of the state cache of the devices
+ *
+ * The messages are sent to the application by an UDP socket on the
+ * loopback interface, the application must be opened on it (-i lo).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define CACHE_SIZE      32
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static int sock;
+static struct sockaddr_in addr;
+
+/* private functions ======================================================== */
+
+/* -----------------------------------------------------------------------------
+ * Sends a message to the application as if it was sent by a device */
+static void
+prvSend (const char * type, const char * source, const char * schema,
+         const char * body) {
+  char buf[256];
+  int len = sprintf (buf, "%s\n{\nhop=1\nsource=%s\ntarget=*\n}\n%s\n"
+                     "{\n%s}\n", type, source, schema, body);
+
+  test (sendto (sock, buf, len, 0, (const struct sockaddr *) &addr,
+                sizeof (addr)) == len);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvPoll (gxPLApplication * app) {
+
+  for (int i = 0; i < 4; i++) {
+
+    test (gxPLAppPoll (app, 5) == 0);
+  }
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  char source[64];
+  gxPLId id;
+  gxPLIoAddr net;
+  gxPLSetting * setting;
+  gxPLApplication * app;
+  gxPLMessage * msg, * old;
+  gxPLStateCacheStats stats;
+  unsigned long age;
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectViaHub);
+  test (setting);
+
+  // opens the xPL network
+  test_count++;
+  app = gxPLAppOpen (setting);
+  test (app);
+  test (gxPLAppStateCacheStats (app, &stats) < 0);
+  test (gxPLAppStateCacheOpen (app, -1) < 0);
+  test (gxPLAppStateCacheOpen (app, CACHE_SIZE) == 0);
+  test (gxPLAppStateCacheOpen (app, CACHE_SIZE) < 0);
+
+  // the messages are sent to the port of the application
+  test_count++;
+  test (gxPLIoCtl (app, gxPLIoFuncGetNetInfo, &net) == 0);
+  sock = socket (AF_INET, SOCK_DGRAM, 0);
+  test (sock >= 0);
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (net.port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  // the status of two sensors of the same device
+  test_count++;
+  prvSend ("xpl-stat", "epsirt-dev.a", "sensor.basic",
+           "device=temp\ntype=temp\ncurrent=21.5\n");
+  prvSend ("xpl-trig", "epsirt-dev.a", "sensor.basic",
+           "device=hum\ntype=humidity\ncurrent=40\n");
+  prvPoll (app);
+  test (gxPLIdSet (&id, "epsirt", "dev", "a") == 0);
+  msg = gxPLAppStateCacheGet (app, &id, "sensor", "basic", "temp", &age);
+  test (msg);
+  test (gxPLMessageTypeGet (msg) == gxPLMessageStatus);
+  test (strcmp (gxPLMessagePairGet (msg, "current"), "21.5") == 0);
+  test (age < 1000);
+  gxPLMessageDelete (msg);
+  msg = gxPLAppStateCacheGet (app, &id, "sensor", "basic", "hum", NULL);
+  test (msg);
+  test (gxPLMessageTypeGet (msg) == gxPLMessageTrigger);
+  test (strcmp (gxPLMessagePairGet (msg, "current"), "40") == 0);
+  gxPLMessageDelete (msg);
+
+  // unknown device, schema and source
+  test_count++;
+  test (gxPLAppStateCacheGet (app, &id, "sensor", "basic", "co2", NULL) == NULL);
+  test (errno == ENOENT);
+  test (gxPLAppStateCacheGet (app, &id, "sensor", "basic", NULL, NULL) == NULL);
+  test (gxPLAppStateCacheGet (app, &id, "x10", "basic", "temp", NULL) == NULL);
+  test (gxPLIdSet (&id, "epsirt", "dev", "z") == 0);
+  test (gxPLAppStateCacheGet (app, &id, "sensor", "basic", "temp", NULL) == NULL);
+  test (gxPLAppStateCacheStats (app, &stats) == 0);
+  test ( (stats.count == 2) && (stats.size == CACHE_SIZE));
+  test ( (stats.hits == 2) && (stats.misses == 4));
+
+  // a new value replaces the previous one, still valid for its owner
+  test_count++;
+  test (gxPLIdSet (&id, "epsirt", "dev", "a") == 0);
+  old = gxPLAppStateCacheGet (app, &id, "sensor", "basic", "temp", NULL);
+  test (old);
+  prvSend ("xpl-trig", "epsirt-dev.a", "sensor.basic",
+           "device=temp\ntype=temp\ncurrent=22\n");
+  prvPoll (app);
+  msg = gxPLAppStateCacheGet (app, &id, "sensor", "basic", "temp", NULL);
+  test (msg && (msg != old));
+  test (strcmp (gxPLMessagePairGet (msg, "current"), "22") == 0);
+  test (strcmp (gxPLMessagePairGet (old, "current"), "21.5") == 0);
+  gxPLMessageDelete (msg);
+  gxPLMessageDelete (old);
+  test (gxPLAppStateCacheStats (app, &stats) == 0);
+  test (stats.count == 2);
+
+  // the commands, heartbeats and configuration messages are not cached
+  test_count++;
+  prvSend ("xpl-cmnd", "epsirt-dev.b", "sensor.basic", "device=temp\n");
+  prvSend ("xpl-stat", "epsirt-dev.b", "hbeat.app", "interval=5\n");
+  prvSend ("xpl-stat", "epsirt-dev.b", "config.list", "reconf=newconf\n");
+  prvSend ("xpl-stat", "epsirt-dev.b", "x10.basic", "command=on\n");
+  prvPoll (app);
+  test (gxPLAppStateCacheStats (app, &stats) == 0);
+  test (stats.count == 3);
+  test (gxPLIdSet (&id, "epsirt", "dev", "b") == 0);
+  msg = gxPLAppStateCacheGet (app, &id, "x10", "basic", "", NULL);
+  test (msg);
+  gxPLMessageDelete (msg);
+
+  // the least recently used messages are removed when the cache is full
+  test_count++;
+  test (gxPLIdSet (&id, "epsirt", "dev", "a") == 0);
+  msg = gxPLAppStateCacheGet (app, &id, "sensor", "basic", "hum", NULL);
+  test (msg);
+  gxPLMessageDelete (msg);
+  for (int i = 0; i < CACHE_SIZE - 1; i++) {
+
+    sprintf (source, "epsirt-dev.n%d", i);
+    prvSend ("xpl-stat", source, "sensor.basic", "device=temp\ncurrent=20\n");
+    if ( (i % 16) == 0) {
+
+      (void) gxPLAppPoll (app, 0);
+    }
+  }
+  prvPoll (app);
+  test (gxPLAppStateCacheStats (app, &stats) == 0);
+  test ( (stats.count == CACHE_SIZE) && (stats.evicted == 2));
+  msg = gxPLAppStateCacheGet (app, &id, "sensor", "basic", "hum", NULL);
+  test (msg);
+  gxPLMessageDelete (msg);
+  test (gxPLAppStateCacheGet (app, &id, "sensor", "basic", "temp", NULL) == NULL);
+  for (int i = 0; i < CACHE_SIZE - 1; i++) {
+
+    sprintf (source, "n%d", i);
+    test (gxPLIdSet (&id, "epsirt", "dev", source) == 0);
+    msg = gxPLAppStateCacheGet (app, &id, "sensor", "basic", "temp", NULL);
+    test (msg);
+    gxPLMessageDelete (msg);
+  }
+
+  // the cache is closed by gxPLAppClose()
+  test_count++;
+  test (gxPLAppStateCacheClose (app) == 0);
+  test (gxPLAppStateCacheGet (app, &id, "sensor", "basic", "temp", NULL) == NULL);
+  test (gxPLAppStateCacheOpen (app, 0) == 0);
+  test (gxPLAppStateCacheStats (app, &stats) == 0);
+  test ( (stats.count == 0) && (stats.size > 0));
+  close (sock);
+  test (gxPLAppClose (app) == 0);
+
+  printf ("All tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,322 @@
+/**
+ * @file
+ * Test of the hierarchical timer wheel, driven by a clock controlled by the
+ * test
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gxPL/util.h>
+#include "timer_p.h"
+
+/* constants ================================================================ */
+#define TICK            DEFAULT_TIMER_TICK_MS
+#define LEVEL_SPAN(n)   (1UL << (DEFAULT_TIMER_WHEEL_BITS * (n)))
+#define WHEEL_RANGE     LEVEL_SPAN (DEFAULT_TIMER_WHEEL_LEVELS)
+#define CLOCK_START     123456UL /* ms, not aligned on a slot */
+#define STEP_MAX        100000   /* calls of gxPLTimerWheelRun() by test */
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* structures =============================================================== */
+typedef struct {
+  gxPLTimer timer;
+  unsigned long expected; /* time of expiry */
+  unsigned long fired;    /* time of the last call */
+  int count;              /* number of calls */
+  unsigned long restart;  /* delay of the restart by the callback, 0 if none */
+  gxPLTimer * stop;       /* timer stopped by the callback, NULL if none */
+} timer_record;
+
+/* private variables ======================================================== */
+static int test_count;
+static unsigned long clock_ms;
+static gxPLTimerWheel wheel;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static int
+prvClock (unsigned long * ms) {
+
+  *ms = clock_ms;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvCallback (gxPLTimer * timer, void * udata) {
+  timer_record * r = (timer_record *) udata;
+
+  test (!gxPLTimerIsPending (timer));
+  r->fired = gxPLTimerWheelNow (&wheel);
+  r->count++;
+  if (r->stop) {
+
+    gxPLTimerStop (&wheel, r->stop);
+  }
+  if (r->restart) {
+
+    r->expected = r->fired + r->restart;
+    gxPLTimerStart (&wheel, timer, r->restart);
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Moves the clock forward and runs the wheel, returns the number of timers
+ * expired */
+static int
+prvAdvance (unsigned long ms) {
+
+  clock_ms += ms;
+  test (gxPLTimerWheelUpdate (&wheel) == clock_ms);
+  return gxPLTimerWheelRun (&wheel);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvStart (timer_record * r, unsigned long delay_ms) {
+
+  memset (r, 0, sizeof (timer_record));
+  gxPLTimerInit (&r->timer, prvCallback, r);
+  r->expected = gxPLTimerWheelNow (&wheel) + delay_ms;
+  gxPLTimerStart (&wheel, &r->timer, delay_ms);
+  test (gxPLTimerIsPending (&r->timer));
+}
+
+/* -----------------------------------------------------------------------------
+ * Delay before the first timer of the records still pending */
+static long
+prvFirst (const timer_record * r, int count) {
+  long first = -1;
+
+  for (int i = 0; i < count; i++) {
+
+    if (gxPLTimerIsPending (&r[i].timer)) {
+      long delay = (long) (r[i].expected - gxPLTimerWheelNow (&wheel));
+
+      if ( (first < 0) || (delay < first)) {
+
+        first = delay;
+      }
+    }
+  }
+  return first;
+}
+
+/* -----------------------------------------------------------------------------
+ * Starts the timers of delays at the same time, then moves the clock by the
+ * delays returned by gxPLTimerWheelNext() until all timers expired, checks
+ * that each timer is called once at its time */
+static void
+prvRunNext (const unsigned long * delay, int count) {
+  timer_record r[count];
+  int expired = 0;
+  int steps = 0;
+  long next;
+
+  for (int i = 0; i < count; i++) {
+
+    prvStart (&r[i], delay[i]);
+  }
+
+  while ( (next = gxPLTimerWheelNext (&wheel)) >= 0) {
+
+    // never later than the first expiry, a cascade may be earlier
+    test (next <= prvFirst (r, count) + TICK - 1);
+    expired += prvAdvance (next);
+    test (++steps < STEP_MAX);
+  }
+  test (expired == count);
+  test (wheel.count == 0);
+
+  for (int i = 0; i < count; i++) {
+
+    test (r[i].count == 1);
+    test ( (long) (r[i].fired - r[i].expected) >= 0);
+    test (r[i].fired - r[i].expected < TICK);
+  }
+}
+
+/* -----------------------------------------------------------------------------
+ * Same as prvRunNext() with a constant step, the wheel processes several
+ * ticks by run */
+static void
+prvRunStep (const unsigned long * delay, int count, unsigned long step) {
+  timer_record r[count];
+  int expired = 0;
+  int steps = 0;
+
+  for (int i = 0; i < count; i++) {
+
+    prvStart (&r[i], delay[i]);
+  }
+
+  while (expired < count) {
+
+    expired += prvAdvance (step);
+    test (++steps < STEP_MAX);
+  }
+  test (expired == count);
+  test (gxPLTimerWheelNext (&wheel) == -1);
+
+  for (int i = 0; i < count; i++) {
+
+    test (r[i].count == 1);
+    test ( (long) (r[i].fired - r[i].expected) >= 0);
+    test (r[i].fired - r[i].expected < step + TICK);
+  }
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  timer_record a, b;
+  // delays on each side of the span of each level
+  const unsigned long cascade[] = {
+    TICK, LEVEL_SPAN (1) - TICK, LEVEL_SPAN (1), LEVEL_SPAN (1) + TICK,
+    LEVEL_SPAN (1) * 3 / 2, LEVEL_SPAN (2) - TICK, LEVEL_SPAN (2),
+    LEVEL_SPAN (2) + TICK, LEVEL_SPAN (2) * 5 / 4, LEVEL_SPAN (3) - TICK,
+    LEVEL_SPAN (3), LEVEL_SPAN (3) + TICK, LEVEL_SPAN (3) * 7 / 3,
+    WHEEL_RANGE - TICK
+  };
+  // beyond the range of the wheel, clamped then moved back
+  const unsigned long clamp[] = {
+    WHEEL_RANGE, WHEEL_RANGE + TICK, WHEEL_RANGE + 12345 * TICK,
+    WHEEL_RANGE * 3 + 7 * TICK
+  };
+  const int ncascade = sizeof (cascade) / sizeof (cascade[0]);
+  const int nclamp = sizeof (clamp) / sizeof (clamp[0]);
+
+  // the wheel uses the clock of the test
+  test_count++;
+  clock_ms = CLOCK_START;
+  gxPLTimerWheelInit (&wheel);
+  test (gxPLTimerWheelClockSet (&wheel, prvClock) == 0);
+  test (gxPLTimerWheelNow (&wheel) == CLOCK_START);
+  test (gxPLTimerWheelNext (&wheel) == -1);
+  test (prvAdvance (1000) == 0);
+
+  // a single timer expires at its time, not before
+  test_count++;
+  prvStart (&a, 10 * TICK);
+  test (gxPLTimerWheelClockSet (&wheel, prvClock) == -1);
+  test (gxPLTimerWheelNext (&wheel) == 10 * TICK);
+  test (prvAdvance (9 * TICK) == 0);
+  test (gxPLTimerWheelNext (&wheel) == TICK);
+  test (prvAdvance (TICK) == 1);
+  test ( (a.count == 1) && (a.fired == a.expected));
+  test (!gxPLTimerIsPending (&a.timer));
+  test (gxPLTimerWheelNext (&wheel) == -1);
+
+  // stop and restart
+  test_count++;
+  prvStart (&a, 10 * TICK);
+  gxPLTimerStop (&wheel, &a.timer);
+  gxPLTimerStop (&wheel, &a.timer);
+  test (!gxPLTimerIsPending (&a.timer));
+  test (gxPLTimerWheelNext (&wheel) == -1);
+  test (prvAdvance (20 * TICK) == 0);
+  prvStart (&a, 10 * TICK);
+  gxPLTimerStart (&wheel, &a.timer, 30 * TICK);
+  a.expected = gxPLTimerWheelNow (&wheel) + 30 * TICK;
+  test (wheel.count == 1);
+  test (prvAdvance (10 * TICK) == 0);
+  test (prvAdvance (20 * TICK) == 1);
+  test ( (a.count == 1) && (a.fired == a.expected));
+
+  // the timers move down the levels, gxPLTimerWheelNext() gives the steps
+  test_count++;
+  prvRunNext (cascade, ncascade);
+
+  // the same with a constant step of several ticks
+  test_count++;
+  prvRunStep (cascade, ncascade, 997 * TICK);
+
+  // the delays beyond the range of the wheel are clamped
+  test_count++;
+  prvRunNext (clamp, nclamp);
+  prvRunStep (clamp, nclamp, LEVEL_SPAN (3) + 3 * TICK);
+
+  // a timer restarted by its callback is not run again on the same tick
+  test_count++;
+  prvStart (&a, 5 * TICK);
+  a.restart = TICK;
+  test (prvAdvance (5 * TICK) == 1);
+  test (gxPLTimerIsPending (&a.timer));
+  test (prvAdvance (0) == 0);
+  test (prvAdvance (TICK) == 1);
+  test ( (a.count == 2) && (a.fired == a.expected - TICK));
+
+  // periodic timer, several periods in a single run
+  test_count++;
+  a.restart = 5 * TICK;
+  gxPLTimerStart (&wheel, &a.timer, 5 * TICK);
+  a.count = 0;
+  for (int i = 0; i < 50; i++) {
+
+    (void) prvAdvance (TICK);
+  }
+  test (a.count == 10);
+  test (prvAdvance (20 * TICK) == 1);
+  test (a.count == 11);
+  a.restart = 0;
+  gxPLTimerStop (&wheel, &a.timer);
+  test (gxPLTimerWheelNext (&wheel) == -1);
+
+  // two timers expiring on the same tick, the first called stops the other
+  test_count++;
+  prvStart (&a, 7 * TICK);
+  prvStart (&b, 7 * TICK);
+  a.stop = &b.timer;
+  b.stop = &a.timer;
+  test (prvAdvance (7 * TICK) == 1);
+  test (a.count + b.count == 1);
+  test (!gxPLTimerIsPending (&a.timer) && !gxPLTimerIsPending (&b.timer));
+  test (wheel.count == 0);
+  test (gxPLTimerWheelNext (&wheel) == -1);
+
+  // the first called restarts the other one later
+  test_count++;
+  prvStart (&a, 7 * TICK);
+  prvStart (&b, 7 * TICK);
+  a.stop = &b.timer;
+  b.stop = &a.timer;
+  test (prvAdvance (7 * TICK) == 1);
+  if (a.count) {
+
+    gxPLTimerStart (&wheel, &b.timer, 20 * TICK);
+    b.expected = gxPLTimerWheelNow (&wheel) + 20 * TICK;
+    b.stop = NULL;
+    test (prvAdvance (19 * TICK) == 0);
+    test (prvAdvance (TICK) == 1);
+    test ( (b.count == 1) && (b.fired == b.expected));
+  }
+  else {
+
+    gxPLTimerStart (&wheel, &a.timer, 20 * TICK);
+    a.expected = gxPLTimerWheelNow (&wheel) + 20 * TICK;
+    a.stop = NULL;
+    test (prvAdvance (19 * TICK) == 0);
+    test (prvAdvance (TICK) == 1);
+    test ( (a.count == 1) && (a.fired == a.expected));
+  }
+  test (wheel.count == 0);
+
+  printf ("All tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
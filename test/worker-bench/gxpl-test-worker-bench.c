@@ -0,0 +1,222 @@
+/**
+ * @file
+ * Worker dispatch benchmark, compares the dispatch of slow device listeners
+ * by gxPLAppPoll() and by a pool of workers
+ *
+ * The messages are sent to the application by an UDP socket on the loopback
+ * interface, the application must be opened on it (-i lo).
+ *
+ * Copyright 2015 (c), epsilonRT
+ * All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <gxPL.h>
+
+/* constants ================================================================ */
+#define VENDOR_ID       "epsirt"
+#define DEVICE_ID       "bench"
+#define DEVICE_COUNT    8
+#define MESSAGE_COUNT   25
+#define WORKER_COUNT    4
+#define LISTENER_DELAY  2000  /* us, a device waiting for its peripheral */
+#define TIMEOUT         10000 /* ms */
+
+/* macros =================================================================== */
+#define test(t) do { \
+    if (!(t)) { \
+      fprintf (stderr, "line %d in %s: test %d failed !\n",  __LINE__, \
+               __FUNCTION__, test_count); \
+      exit (EXIT_FAILURE); \
+    } \
+  } while (0)
+
+/* private variables ======================================================== */
+static int test_count;
+static int last_seq[DEVICE_COUNT];
+static int order_errors;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static unsigned long
+prvElapsed (unsigned long start) {
+  unsigned long now;
+
+  (void) gxPLTimeMonotonicMs (&now);
+  return now - start;
+}
+
+/* -----------------------------------------------------------------------------
+ * Slow listener, checks that the messages of a device are received in order */
+static void
+prvDeviceHandler (gxPLDevice * device, gxPLMessage * msg, void * udata) {
+  int i = (int) (long) udata;
+  int seq = atoi (gxPLMessagePairGet (msg, "seq"));
+
+  if (seq != __atomic_load_n (&last_seq[i], __ATOMIC_ACQUIRE) + 1) {
+
+    __atomic_add_fetch (&order_errors, 1, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n (&last_seq[i], seq, __ATOMIC_RELEASE);
+  usleep (LISTENER_DELAY);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prvIsDone (void) {
+
+  for (int i = 0; i < DEVICE_COUNT; i++) {
+
+    if (__atomic_load_n (&last_seq[i], __ATOMIC_ACQUIRE) != MESSAGE_COUNT) {
+
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* -----------------------------------------------------------------------------
+ * Sends the commands to all devices, returns the time spent in gxPLAppPoll()
+ * until all have been processed */
+static unsigned long
+prvRun (gxPLApplication * app, int sock, const struct sockaddr_in * addr) {
+  char buf[256];
+  unsigned long t, poll_time = 0;
+
+  memset (last_seq, 0, sizeof (last_seq));
+  order_errors = 0;
+
+  for (int seq = 1; seq <= MESSAGE_COUNT; seq++) {
+
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+      int len = sprintf (buf, "xpl-cmnd\n{\nhop=1\nsource=epsirt-test.worker\n"
+                         "target=" VENDOR_ID "-" DEVICE_ID ".d%d\n}\n"
+                         "control.basic\n{\nseq=%d\n}\n", i, seq);
+
+      test (sendto (sock, buf, len, 0, (const struct sockaddr *) addr,
+                    sizeof (*addr)) == len);
+    }
+
+    // the messages are read while the listeners are busy
+    (void) gxPLTimeMonotonicMs (&t);
+    test (gxPLAppPoll (app, 0) == 0);
+    poll_time += prvElapsed (t);
+  }
+
+  (void) gxPLTimeMonotonicMs (&t);
+  while (!prvIsDone()) {
+    unsigned long p;
+
+    test (prvElapsed (t) < TIMEOUT);
+    (void) gxPLTimeMonotonicMs (&p);
+    test (gxPLAppPoll (app, 10) == 0);
+    if (gxPLAppWorkersCount (app) == 0) {
+
+      poll_time += prvElapsed (p);
+    }
+  }
+  return poll_time;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  int sock;
+  unsigned long t, ms;
+  char instance[GXPL_INSTANCEID_MAX + 1];
+  gxPLIoAddr net;
+  struct sockaddr_in addr;
+  gxPLSetting * setting;
+  gxPLApplication * app;
+  gxPLWorkerStats stats;
+
+  // retrieved the requested configuration from the command line
+  test_count++;
+  setting = gxPLSettingFromCommandArgs (argc, argv, gxPLConnectViaHub);
+  test (setting);
+
+  // opens the xPL network
+  test_count++;
+  app = gxPLAppOpen (setting);
+  test (app);
+
+  test_count++;
+  for (int i = 0; i < DEVICE_COUNT; i++) {
+    gxPLDevice * device;
+
+    sprintf (instance, "d%d", i);
+    device = gxPLAppAddDevice (app, VENDOR_ID, DEVICE_ID, instance);
+    test (device);
+    test (gxPLDeviceListenerAdd (device, prvDeviceHandler, gxPLMessageCommand,
+                                 "control", "basic", (void *) (long) i) == 0);
+    test (gxPLDeviceEnable (device, true) == 0);
+  }
+
+  // the messages are sent to the port of the application
+  test_count++;
+  test (gxPLIoCtl (app, gxPLIoFuncGetNetInfo, &net) == 0);
+  sock = socket (AF_INET, SOCK_DGRAM, 0);
+  test (sock >= 0);
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (net.port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  printf ("Worker dispatch benchmark, %d devices, %d messages each, "
+          "listeners of %d us\n\n", DEVICE_COUNT, MESSAGE_COUNT,
+          LISTENER_DELAY);
+
+  // the listeners are called by gxPLAppPoll()
+  test_count++;
+  (void) gxPLTimeMonotonicMs (&t);
+  ms = prvRun (app, sock, &addr);
+  printf ("  poll:      %5lu ms, %5lu ms in gxPLAppPoll()\n", prvElapsed (t), ms);
+  test (order_errors == 0);
+
+  // the listeners are called by the workers
+  test_count++;
+  test (gxPLAppWorkersStart (app, WORKER_COUNT) == 0);
+  test (gxPLAppWorkersStart (app, WORKER_COUNT) < 0);
+  test (gxPLAppWorkersCount (app) == WORKER_COUNT);
+  (void) gxPLTimeMonotonicMs (&t);
+  ms = prvRun (app, sock, &addr);
+  printf ("  %d workers: %5lu ms, %5lu ms in gxPLAppPoll()\n", WORKER_COUNT,
+          prvElapsed (t), ms);
+  test (order_errors == 0);
+
+  test_count++;
+  for (int w = 0; w < WORKER_COUNT; w++) {
+
+    test (gxPLAppWorkerStats (app, w, &stats) == 0);
+    test (stats.depth == 0);
+    printf ("  worker %d:  %4lu messages, depth max %3d, "
+            "latency avg %6lu us, max %6lu us\n", w, stats.count,
+            stats.depth_max, stats.latency_avg, stats.latency_max);
+  }
+  test (gxPLAppWorkerStats (app, WORKER_COUNT, &stats) < 0);
+
+  // back to the dispatch by gxPLAppPoll()
+  test_count++;
+  test (gxPLAppWorkersStop (app) == 0);
+  test (gxPLAppWorkersCount (app) == 0);
+  (void) prvRun (app, sock, &addr);
+  test (order_errors == 0);
+
+  // the workers are stopped by gxPLAppClose()
+  test_count++;
+  test (gxPLAppWorkersStart (app, WORKER_COUNT) == 0);
+  close (sock);
+  test (gxPLAppClose (app) == 0);
+
+  printf ("\nAll tests (%d) were successful !\n", test_count);
+  return 0;
+}
+
+/* ========================================================================== */
@@ -325,7 +325,7 @@ prvRunBridge (const prvBridgeSetting * setting) {
   // Hand control over to gxPLib
   for (;;) {
 
-    ret = gxPLBridgePoll (bridge, 100);
+    ret = gxPLBridgePoll (bridge, -1);
     if (ret != 0) {
 
       vLog (LOG_ERR, "Bridge failure, exiting !");
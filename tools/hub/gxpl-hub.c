@@ -30,6 +30,7 @@
 /* private variables ======================================================== */
 static pid_t hub_pid = 0;
 static gxPLHub * hub;
+static int cache_max_age; /* in seconds, 0 if the requests are not answered */
 
 /* private functions ======================================================== */
 static void prvPrintUsage (void);
@@ -37,7 +38,8 @@ static void prvSupervisorSignalHandler (int sig);
 static void prvHubSignalHandler (int sig);
 static void prvSuperviseHub (gxPLSetting * setting);
 static int prvRunHub (gxPLSetting * setting);
-static void prvParseAdditionnalOptions (int argc, char *argv[]);
+static void prvParseAdditionnalOptions (gxPLSetting * setting,
+                                        int argc, char *argv[]);
 
 /* main ===================================================================== */
 int
@@ -53,7 +55,7 @@ main (int argc, char * argv[]) {
     prvPrintUsage();
     exit (EXIT_FAILURE);
   }
-  prvParseAdditionnalOptions (argc, argv);
+  prvParseAdditionnalOptions (setting, argc, argv);
 
   // Now we detach (daemonize ourself)
   if (setting->nodaemon == 0) {
@@ -107,6 +109,15 @@ prvRunHub (gxPLSetting * setting) {
     return -1;
   }
 
+  if ( (cache_max_age > 0) &&
+       (gxPLHubStateCacheEnable (hub, 0, cache_max_age * 1000, NULL) != 0)) {
+
+    PERROR ("Unable to enable the state cache, %s (%d)",
+            strerror (errno), errno);
+    (void) gxPLHubClose (hub);
+    return -1;
+  }
+
   // Install signal traps for proper shutdown
   signal (SIGTERM, prvHubSignalHandler);
   signal (SIGINT, prvHubSignalHandler);
@@ -132,7 +143,7 @@ prvRunHub (gxPLSetting * setting) {
   // Hand control over to gxPLib
   for (;;) {
 
-    ret = gxPLHubPoll (hub, 100);
+    ret = gxPLHubPoll (hub, -1);
     if (ret != 0) {
 
       PERROR ("Hub failure, exiting !");
@@ -226,10 +237,13 @@ static void
 prvPrintUsage (void) {
   printf ("%s - xPL Hub\n", __progname);
   printf ("Copyright (c) 2015-2016 epsilonRT                \n\n");
-  printf ("Usage: %s [-i interface] [-d] [-D] [-h]\n", __progname);
+  printf ("Usage: %s [-i interface] [-d] [-D] [-F] [-C maxage] [-h]\n", __progname);
   printf ("  -i interface - use interface named interface (i.e. eth0) as network interface\n");
   printf ("  -W timeout   - set the timeout at the opening of the io layer\n");
   printf ("  -D           - do not daemonize -- run from the console\n");
+  printf ("  -F           - forward only, relays the messages without decoding them\n");
+  printf ("  -C maxage    - answers the status requests with the status received for"
+          " less than maxage seconds\n");
   printf ("  -d           - enable debugging, it can be doubled or tripled to"
           " increase the level of debug. \n");
   printf ("  -h           - print this message\n\n");
@@ -291,12 +305,14 @@ prvSupervisorSignalHandler (int sig) {
 
 // -----------------------------------------------------------------------------
 static void
-prvParseAdditionnalOptions (int argc, char *argv[]) {
+prvParseAdditionnalOptions (gxPLSetting * setting, int argc, char *argv[]) {
   int c;
 
-  static const char short_options[] = "h" GXPL_GETOPT;
+  static const char short_options[] = "hFC:" GXPL_GETOPT;
   static struct option long_options[] = {
     {"help",     no_argument,        NULL, 'h' },
+    {"forward",  no_argument,        NULL, 'F' },
+    {"cache",    required_argument,  NULL, 'C' },
     {NULL, 0, NULL, 0} /* End of array need by getopt_long do not delete it*/
   };
 
@@ -311,6 +327,16 @@ prvParseAdditionnalOptions (int argc, char *argv[]) {
         exit (EXIT_SUCCESS);
         break;
 
+      case 'F':
+        setting->forward = 1;
+        PDEBUG ("set forward only mode");
+        break;
+
+      case 'C':
+        cache_max_age = atoi (optarg);
+        PDEBUG ("set state cache max age to %d s", cache_max_age);
+        break;
+
       default:
         break;
     }
@@ -127,9 +127,8 @@ main (int argc, char * argv[]) {
   assert (ret == 0);
 
   for (;;) {
-    // Let XPL run for a while, returning after it hasn't seen any
-    // activity in 100ms or so
-    ret = gxPLAppPoll (app, 100);
+    // Let XPL run until a message is received or a timer expires
+    ret = gxPLAppPoll (app, -1);
     assert (ret == 0);
   }
   return 0;
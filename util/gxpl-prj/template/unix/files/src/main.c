@@ -6,6 +6,9 @@
  */
 #include <signal.h>
 #include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
 #include "template.h"
 
 /* constants ================================================================ */
@@ -30,6 +33,7 @@ prvSignalHandler (int sig) {
 void
 vMain (gxPLSetting * setting) {
   int ret;
+  unsigned long now, next_poll;
   gxPLDevice * device;
   gxPLApplication * app;
 
@@ -77,15 +81,54 @@ vMain (gxPLSetting * setting) {
   signal (SIGTERM, prvSignalHandler);
   signal (SIGINT, prvSignalHandler);
 
+  // The loop waits for the xPL network itself, other descriptors
+  // (sockets, serial ports...) can be added to the poll set
+  (void) gxPLTimeMonotonicMs (&next_poll);
   while (bMainIsRun) {
+    struct pollfd pfd[2];
+    int nfds = 0;
+    long timeout, deadline;
+
+    pfd[nfds].fd = gxPLAppFd (app);
+    pfd[nfds++].events = POLLIN;
+    pfd[nfds].fd = gxPLAppSendQueueFd (app);
+    if (pfd[nfds].fd >= 0) {
+
+      pfd[nfds++].events = POLLIN;
+    }
+
+    // waits until the next xPL timer or the next sensor poll
+    (void) gxPLTimeMonotonicMs (&now);
+    timeout = (long) (next_poll - now);
+    if (timeout < 0) {
+
+      timeout = 0;
+    }
+    deadline = gxPLAppNextDeadlineMs (app);
+    if ( (deadline >= 0) && (deadline < timeout)) {
+
+      timeout = deadline;
+    }
+
+    if ( (poll (pfd, nfds, (int) timeout) < 0) && (errno != EINTR)) {
+
+      PWARNING ("Unable to wait for events: %s", strerror (errno));
+    }
 
     // Main Loop
-    ret = gxPLAppPoll (app, POLL_RATE_MS);
-    if (ret != 0) {
+    ret = gxPLAppProcessReady (app);
+    if (ret < 0) {
 
       PWARNING ("Unable to poll xPL network, error %d", ret);
     }
 
+    (void) gxPLTimeMonotonicMs (&now);
+    if ( (long) (now - next_poll) < 0) {
+
+      continue;
+    }
+    next_poll = now + POLL_RATE_MS;
+
     if (gxPLDeviceIsHubConfirmed (device)) {
 
       // if the hub is confirmed, performs xPL tasks...